@@ -12,34 +12,79 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <future>  // NOLINT
 #include <list>
+#include <memory>
 #include <unordered_map>
-#include "common/logger.h"
+#include <unordered_set>
 #include "common/config.h"
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
 
 
 namespace bustub {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     ReplacerPolicy replacer_policy, size_t max_pool_size)
+    : BufferPoolManager(pool_size, 1, 0, disk_manager, log_manager, replacer_policy, max_pool_size) {}
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                     DiskManager *disk_manager, LogManager *log_manager,
+                                     ReplacerPolicy replacer_policy, size_t max_pool_size)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      frame_arena_(max_pool_size_),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      page_table_(max_pool_size_) {
+  BUSTUB_ASSERT(num_instances > 0, "a standalone buffer pool manager has exactly one instance");
+  BUSTUB_ASSERT(instance_index < num_instances, "instance index must be less than the number of instances");
   // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // 按最大容量分配 frame、页表和 replacer, 这样 GrowPool/ShrinkPool 时 frame 不会移动, frame_id 也保持不变
+  pages_ = frame_arena_.GetPages();
+  switch (replacer_policy) {
+    case ReplacerPolicy::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+    case ReplacerPolicy::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_);
+      break;
+    case ReplacerPolicy::LRU:
+    default:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+  }
 
   // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+  prefetched_ = new std::atomic<bool>[max_pool_size_];
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].pin_count_ = -1;  // 空闲 frame 的 pin_count_ 为 -1, 无锁的 fetch 路径不能 pin 住它
+    prefetched_[i] = false;
+    if (i < pool_size) {  // [pool_size, max_pool_size_) 的 frame 等 GrowPool 时才启用
+      free_list_.emplace_back(static_cast<int>(i));
+    }
   }
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  delete[] pages_;
+  // 预读线程和后台写线程会访问 pages_, 必须先停掉
+  StopPrefetchThreads();
+  StopBackgroundWriter();
+  delete[] prefetched_;
   delete replacer_;
 }
 
+Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) { return FetchPageImpl(page_id, nullptr); }
 
-
-Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
+Page *BufferPoolManager::FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -47,177 +92,1055 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  
   // 1.1 查找buffer pool, 确定需要的page 是否已经在 buffer pool 中, 有则直接返回
+  //     命中时只需要一次无锁的页表探测和一次 pin_count_ 的原子自增, 不需要加 latch_
   frame_id_t frame_id;
-  if(page_table_.find(page_id)!=page_table_.end()){
-    frame_id = page_table_[page_id];
-    replacer_->Pin(frame_id);
+  if (page_table_.Find(page_id, &frame_id) && TryPinFrame(frame_id, page_id)) {
+    fetch_hits_.fetch_add(1, std::memory_order_relaxed);
+    replacer_->RecordAccess(frame_id);
+    OnPrefetchHit(frame_id, strategy);
     return &pages_[frame_id];
   }
 
-  // 1.2 没有找到,说明不在buffer pool,得从磁盘读取 => 需要先在buffer pool 中找到一个空frame 来给调入的 page 腾出空间
-  if(!free_list_.empty()){                // 空闲链表中找到空frame
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  }
-  else{                                   // 否则需要通过 LRU 置换,找到一个 frame
-    bool find_victim = replacer_->Victim(&frame_id);
-    if(!find_victim) return nullptr;
+  // 无锁查找可能因为并发的置换而失败, 加锁后再查一次
+  auto guard = LockLatch();
+  if (page_table_.Find(page_id, &frame_id)) {
+    // 持有 latch_ 时页表中的 frame 不会处于置换中, pin_count_ >= 0
+    pages_[frame_id].pin_count_.fetch_add(1);
+    replacer_->RecordAccess(frame_id);
+    guard.unlock();
+    fetch_hits_.fetch_add(1, std::memory_order_relaxed);
+    OnPrefetchHit(frame_id, strategy);
+    return &pages_[frame_id];
   }
 
-  // 2. 判断1.2中找到的 frame 中数据是否 dirty, 是则写回(本质上就是将内存page置换回磁盘)
-  Page* page = &pages_[frame_id];
-  if(page -> is_dirty_){
-    //Before your buffer pool manager evicts a dirty page from LRU replacer and write this page back to db file,
-    // it needs to flush logs up to pageLSN. You need to compare persistent_lsn_ (a member variable maintains
-    // by Log Manager) with your pageLSN. However unlike group commit, buffer pool can force log manager to flush log
-    // buffer, but still needs to wait for logs to be permanently stored before continue
-    if (enable_logging && log_manager_->GetPersistentLSN() < page->GetLSN()){
-      log_manager_->FlushLog(true);   // 强制刷新
-    }
-      
-    disk_manager_->WritePage(page->page_id_, page->data_);
+  // 1.2 没有找到,说明不在buffer pool,得从磁盘读取 => 需要先在buffer pool 中找到一个空frame 来给调入的 page 腾出空间
+  // 2. GetVictimFrame 中会将 dirty 的 victim 写回磁盘, 并从页表中删除
+  fetch_misses_.fetch_add(1, std::memory_order_relaxed);
+  CancelPrefetchRead(page_id);
+  if (!GetVictimFrame(&frame_id, strategy)) {
+    return nullptr;
   }
 
-  // 3.从页表中删除被替换出去的 page 信息; 把将要新置换进入 buffer 的 page 信息写入页表
-  page_table_.erase(page->page_id_);
-  page_table_[page_id] = frame_id;
-
   // 4.从磁盘读取数据到 buffer 中(当前frame/page), 更新 page 的元数据
+  Page *page = &pages_[frame_id];
   page->page_id_ = page_id;
-  page->pin_count_ = 1;         // TODO: ==1 or +1 ?
   page->is_dirty_ = false;
-  disk_manager_->ReadPage(page->page_id_, page->data_);
-  
+  try {
+    disk_manager_->ReadPage(page->page_id_, page->data_);
+  } catch (const CorruptedPageException &) {
+    // 校验和不对的页面不装入 buffer pool, frame 还给 free list(pin_count_ 仍为 -1)
+    page->page_id_ = INVALID_PAGE_ID;
+    free_list_.emplace_back(frame_id);
+    throw;
+  }
+  page->pin_count_ = 1;  // 从 -1 变为 1 之后其他线程才能无锁地 pin 住它
+
+  // 3. 把将要新置换进入 buffer 的 page 信息写入页表
+  page_table_.Insert(page_id, frame_id);
+  replacer_->RecordAccess(frame_id);
+  AddToRing(strategy, frame_id, page_id);
+
   return page;
 }
 
-
 /**
  * unpin时标注page是否为dirty
  * 将dirty写回磁盘是在: 执行页面置换算法时(FecthPage)、刷新page时(FlushPage)
  * 当 pin_count_ 为0时则可以加入LRU
- */ 
+ */
 bool BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
-  if(page_table_.find(page_id)==page_table_.end()){
-    LOG_WARN("the page(page_id = %d ) want to unpin is not in the buffer pool",page_id);
+  auto guard = LockLatch();
+  return UnpinFrame(page_id, is_dirty);
+}
+
+bool BufferPoolManager::UnpinFrame(page_id_t page_id, bool is_dirty) {
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    LOG_WARN("the page(page_id = %d ) want to unpin is not in the buffer pool", page_id);
     return false;
   }
 
-  frame_id_t frame_id = page_table_[page_id];
-  Page* page = &pages_[frame_id];
-  page->is_dirty_ = is_dirty;
-  if(page->pin_count_ <= 0) return false;
-  page->pin_count_--;
+  Page *page = &pages_[frame_id];
+  // 只能置位, 不能清除: 其他线程之前可能已经把它标记为 dirty
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+  // fetch 命中路径会不加锁地并发增加 pin_count_, 所以这里也要用 CAS
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
 
-  if(page->pin_count_ ==0 ){
+  if (pin_count == 1) {
     replacer_->Unpin(frame_id);
   }
-  
-  return true; 
+
+  return true;
+}
+
+std::vector<Page *> BufferPoolManager::FetchPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  // 1. 命中的页面和 FetchPage 一样无锁地 pin 住
+  std::vector<size_t> misses;
+  frame_id_t frame_id;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if (page_ids[i] != INVALID_PAGE_ID && page_table_.Find(page_ids[i], &frame_id) &&
+        TryPinFrame(frame_id, page_ids[i])) {
+      fetch_hits_.fetch_add(1, std::memory_order_relaxed);
+      replacer_->RecordAccess(frame_id);
+      OnPrefetchHit(frame_id, nullptr);
+      pages[i] = &pages_[frame_id];
+    } else if (page_ids[i] != INVALID_PAGE_ID) {
+      misses.push_back(i);
+    }
+  }
+  if (misses.empty()) {
+    return pages;
+  }
+
+  // 2. 其余的页面只加一次锁: 和 FetchPage 的未命中路径一样, 读盘期间一直持有 latch_
+  auto guard = LockLatch();
+  std::unordered_map<page_id_t, std::pair<frame_id_t, int>> loading;  // page_id -> (frame, 要 pin 的次数)
+  std::vector<page_id_t> load_order;
+  for (size_t i : misses) {
+    const page_id_t page_id = page_ids[i];
+    auto it = loading.find(page_id);
+    if (it != loading.end()) {  // 同一批中重复的页面
+      it->second.second++;
+      pages[i] = &pages_[it->second.first];
+      continue;
+    }
+    if (page_table_.Find(page_id, &frame_id)) {
+      pages_[frame_id].pin_count_.fetch_add(1);
+      fetch_hits_.fetch_add(1, std::memory_order_relaxed);
+      replacer_->RecordAccess(frame_id);
+      pages[i] = &pages_[frame_id];
+      continue;
+    }
+    fetch_misses_.fetch_add(1, std::memory_order_relaxed);
+    CancelPrefetchRead(page_id);
+    if (!GetVictimFrame(&frame_id)) {
+      continue;
+    }
+    // 读盘期间 frame 的 pin_count_ 保持为 -1, 且不在页表中, 其他线程都看不到它
+    pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+    loading[page_id] = {frame_id, 1};
+    load_order.push_back(page_id);
+    pages[i] = &pages_[frame_id];
+  }
+
+  // 3. 按 page_id 排序, 磁盘上连续的页面用一次 preadv 读进各自的 frame; 各段异步提交, 同时在途, 最后一起等待
+  std::sort(load_order.begin(), load_order.end());
+  std::vector<char *> run;
+  std::vector<std::pair<size_t, size_t>> runs;  // 每一段在 load_order 中的 [begin, end)
+  std::vector<std::future<bool>> reads;
+  for (size_t begin = 0, end = 0; begin < load_order.size(); begin = end) {
+    run.clear();
+    end = begin;
+    while (end < load_order.size() && (end == begin || DiskManager::IsNextPage(load_order[end - 1], load_order[end]))) {
+      run.push_back(pages_[loading[load_order[end]].first].data_);
+      end++;
+    }
+    runs.emplace_back(begin, end);
+    reads.push_back(disk_manager_->ReadPagesAsync(load_order[begin], static_cast<int>(run.size()), run.data()));
+  }
+  // 有页面校验失败的段整段不装入, 它们的 frame 还给 free list
+  std::exception_ptr corrupted;
+  std::unordered_set<page_id_t> failed;
+  for (size_t r = 0; r < reads.size(); r++) {
+    try {
+      reads[r].get();
+    } catch (const CorruptedPageException &) {
+      corrupted = std::current_exception();
+      failed.insert(load_order.begin() + runs[r].first, load_order.begin() + runs[r].second);
+    }
+  }
+  for (page_id_t page_id : load_order) {
+    frame_id = loading[page_id].first;
+    Page *page = &pages_[frame_id];
+    if (failed.count(page_id) != 0) {
+      free_list_.emplace_back(frame_id);
+      continue;
+    }
+    page->page_id_ = page_id;
+    page->is_dirty_ = false;
+    page->pin_count_ = loading[page_id].second;
+    page_table_.Insert(page_id, frame_id);
+    replacer_->RecordAccess(frame_id);
+  }
+  if (corrupted != nullptr) {
+    // 和 FetchPage 一样以异常报告校验失败: 先放掉这次 pin 住的所有页面
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      if (pages[i] != nullptr && failed.count(page_ids[i]) == 0) {
+        UnpinFrame(page_ids[i], false);
+      }
+    }
+    std::rethrow_exception(corrupted);
+  }
+  return pages;
+}
+
+bool BufferPoolManager::UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) {
+  auto guard = LockLatch();
+  bool unpinned = true;
+  for (const auto &[page_id, is_dirty] : pages) {
+    unpinned = UnpinFrame(page_id, is_dirty) && unpinned;
+  }
+  return unpinned;
 }
 
 /**
  * FlushPageImpl should flush a page regardless of its pin status
- */ 
+ * 干净的页面与磁盘上的内容一致, 不需要写
+ */
 bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
-  if(page_table_.find(page_id)==page_table_.end() || page_id == INVALID_PAGE_ID){
-    LOG_INFO("the page want to flush is not in the buffer pool");
-    return false;
+  frame_id_t frame_id;
+  {
+    auto guard = LockLatch();
+    if (page_id == INVALID_PAGE_ID || !page_table_.Find(page_id, &frame_id)) {
+      LOG_INFO("the page want to flush is not in the buffer pool");
+      return false;
+    }
+    // 持有 latch_ 时页面不会被置换, 它的 frame 一定可以 pin 住
+    if (!pages_[frame_id].is_dirty_ || !PinFrameForWrite(frame_id)) {
+      return true;
+    }
   }
-  Page* page = &pages_[page_table_[page_id]];
-  disk_manager_->WritePage(page_id,page->data_);
-
-  return true;
+  // 页面可能正在被其他线程修改, 在它的读锁下拷贝出来再写, 写出去的内容和校验和一致
+  std::unique_ptr<char, decltype(&std::free)> data(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, PAGE_SIZE)),
+                                                   &std::free);
+  CopyPageForWrite(&pages_[frame_id], data.get());
+  // 同步的 WritePage 不报告 I/O 错误, 等待异步写的结果; 写失败时页面重新标记为 dirty
+  const bool written = disk_manager_->WritePageAsync(page_id, data.get()).get();
+  if (written) {
+    flush_writes_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    pages_[frame_id].is_dirty_ = true;
+    write_errors_.fetch_add(1, std::memory_order_relaxed);
+    LOG_WARN("failed to flush page %d", page_id);
+  }
+  UnpinWrittenFrame(frame_id);
+  return written;
 }
 
 /**
  * 在缓冲区分配一个空闲page
- */ 
-Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
-  // 0.   Make sure you call DiskManager::AllocatePage!
+ */
+Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) { return NewPageImpl(page_id, nullptr); }
+
+Page *BufferPoolManager::NewPageImpl(page_id_t *page_id, BufferAccessStrategy *strategy) {
+  // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
+  auto guard = LockLatch();
 
-  // 0. 调用diskmanager分配一个page
-  *page_id = disk_manager_->AllocatePage();
-
-  // 1. 检查磁盘上新分配的page能否调入内存; 若空闲链表 和 LRU链表都空,则buffer中没有多余空间
-  if(free_list_.empty() && replacer_->Size()==0){
+  // 1/2. 从空闲链表 或者 LRU中找到一个存放新page的物理页; 若都没有,则buffer中没有多余空间
+  //      注意要先找到frame再分配page_id, 否则分配失败时page_id 就被白白浪费了
+  frame_id_t frame_id;
+  if (!GetVictimFrame(&frame_id, strategy)) {
     return nullptr;
   }
-  
-  // 2. 从空闲链表 或者 LRU中找到一个存放新page的物理页
-  Page* page;
-  frame_id_t frame_id;
-  if(!free_list_.empty()){
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-    page = &pages_[frame_id];
+
+  // 0. 分配一个page; 它可能是刚被删除的页面, 还有对它的预读在途
+  *page_id = AllocatePage();
+  CancelPrefetchRead(*page_id);
+
+  // 3/4. 更新page的元数据并返回
+  return InitNewPage(frame_id, *page_id, strategy);
+}
+
+Page *BufferPoolManager::NewPageImpl(page_id_t *page_id, PageExtent *extent, BufferAccessStrategy *strategy) {
+  *page_id = extent->AllocatePage(disk_manager_);
+  Page *page = NewPageWithId(*page_id, strategy);
+  if (page == nullptr) {  // 没有空闲的 frame, page_id 还给 extent
+    extent->ReleasePage(*page_id);
   }
-  else{
-    replacer_->Victim(&frame_id);
-    page = &pages_[frame_id];
-    FlushPageImpl(page->page_id_);   // 置换到磁盘,需要修改页表...
-    page_table_.erase(page->page_id_);
+  return page;
+}
+
+Page *BufferPoolManager::NewPageWithId(page_id_t page_id, BufferAccessStrategy *strategy) {
+  auto guard = LockLatch();
+  CancelPrefetchRead(page_id);
+  frame_id_t frame_id;
+  if (!GetVictimFrame(&frame_id, strategy)) {
+    return nullptr;
   }
+  return InitNewPage(frame_id, page_id, strategy);
+}
 
-  // 3. 更新page的元数据
-  page->page_id_ = *page_id;
+Page *BufferPoolManager::InitNewPage(frame_id_t frame_id, page_id_t page_id, BufferAccessStrategy *strategy) {
+  // 新page在磁盘上没有内容, 直接清零即可, 无需读盘
+  Page *page = &pages_[frame_id];
+  page->page_id_ = page_id;
   page->is_dirty_ = false;
-  page->pin_count_ = 1;           // 根据测试代码,pin_count_ 不应该设置为0
-  disk_manager_->ReadPage(page->page_id_,page->data_);
-  page_table_[page->page_id_] = frame_id;
-
-  // 4.返回
+  page->ResetMemory();
+  page->pin_count_ = 1;  // 根据测试代码,pin_count_ 不应该设置为0
+  page_table_.Insert(page->page_id_, frame_id);
+  replacer_->RecordAccess(frame_id);
+  AddToRing(strategy, frame_id, page->page_id_);
   return page;
 }
 
-
 /**
- * 根据源码,目前 disk_manager_->DeallocatePage(page_id) 没有做任何事情
- */ 
+ * disk_manager_->DeallocatePage(page_id) 把页面还给 free space map, 之后的 NewPage 会重用它
+ */
 bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   // 0.   Make sure you call DiskManager::DeallocatePage!
   // 1.   Search the page table for the requested page (P).
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  auto guard = LockLatch();
 
-  // 0. 调用diskmanager释放磁盘上的page => 根据源码,这个函数目前没有做任何事情...
-  disk_manager_->DeallocatePage(page_id);
+  // 预读线程可能正在不持有 latch_ 地读这个页面(同时它也可能被 FetchPage 读进来了): 读完之后不会再把删除了的页面放入页表
+  CancelPrefetchRead(page_id);
 
   // 1. 找出内存中的page
-  if(page_table_.find(page_id)==page_table_.end()){
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    disk_manager_->DeallocatePage(page_id);
     return true;
   }
-  Page* page = &pages_[page_table_[page_id]];
+  Page *page = &pages_[frame_id];
 
-  // 2. 判断pin_count_
-  if(page->pin_count_ > 0){
+  // 2. 判断pin_count_; 用 CAS 0 -> -1, 防止无锁的 fetch 在删除过程中 pin 住它
+  int pin_count = 0;
+  if (!page->pin_count_.compare_exchange_strong(pin_count, -1)) {
     return false;
   }
 
-  // 3. 清空内存中的page
-  free_list_.emplace_back(static_cast<int>(page_table_[page_id]));
-  page_table_.erase(page_id);
-  page->page_id_ = 0;
-  page->pin_count_ = 0;
+  // 0. 调用diskmanager释放磁盘上的page
+  disk_manager_->DeallocatePage(page_id);
+
+  // 3. 清空内存中的page; 它可能还在 replacer 中(pin_count_ 为0), 需要先从 replacer 中移除
+  replacer_->Remove(frame_id);
+  page_table_.Remove(page_id);
+  if (prefetched_[frame_id].exchange(false)) {
+    prefetch_wasted_++;
+  }
+  free_list_.emplace_back(frame_id);
+  page->page_id_ = INVALID_PAGE_ID;
   page->is_dirty_ = false;
-  memset(page->data_,0,PAGE_SIZE);
+  page->ResetMemory();
 
-  return false;
+  return true;
 }
 
 void BufferPoolManager::FlushAllPagesImpl() {
-  // You can do it!
-  for(auto it=page_table_.begin(); it!=page_table_.end(); it++){
-    FlushPageImpl(it->first);
+  std::vector<frame_id_t> dirty_frames;
+  {
+    auto guard = LockLatch();
+    // 持有 latch_ 时只有预读线程可能在往 frame 中读盘, 而这时它的 page_id_ 是无效的;
+    // 所以 page_id_ 有效的 frame 就是页表中的全部页面. 只写脏页, pin 住它们之后就可以放开 latch_
+    for (size_t i = 0; i < pool_size_; i++) {
+      Page *page = &pages_[i];
+      if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_ && PinFrameForWrite(static_cast<frame_id_t>(i))) {
+        dirty_frames.push_back(static_cast<frame_id_t>(i));
+      }
+    }
+  }
+  std::sort(dirty_frames.begin(), dirty_frames.end(),
+            [&](frame_id_t a, frame_id_t b) { return pages_[a].page_id_ < pages_[b].page_id_; });
+
+  // 页面在各自的读锁下拷贝到 buffer 中再写(见 CopyPageForWrite); buffer 按页对齐, O_DIRECT 可以直接写
+  std::unique_ptr<char, decltype(&std::free)> buffer(
+      static_cast<char *>(std::aligned_alloc(PAGE_SIZE, std::max<size_t>(dirty_frames.size(), 1) * PAGE_SIZE)),
+      &std::free);
+  std::vector<char *> copies(dirty_frames.size());
+  for (size_t i = 0; i < dirty_frames.size(); i++) {
+    copies[i] = buffer.get() + i * PAGE_SIZE;
+    CopyPageForWrite(&pages_[dirty_frames[i]], copies[i]);
+  }
+
+  // 磁盘上连续的页面合并成一次 pwritev, 顺序分配的表刷盘时就是少量的大块顺序写, 而不是大量 4KB 的随机写.
+  // 各段异步提交, checkpoint 时很多写同时在途, 全部完成之后再 Sync
+  std::vector<std::pair<size_t, size_t>> runs;
+  std::vector<std::future<bool>> writes;
+  for (size_t begin = 0, end = 0; begin < dirty_frames.size(); begin = end) {
+    const page_id_t first_page_id = pages_[dirty_frames[begin]].page_id_;
+    end = begin + 1;
+    while (end < dirty_frames.size() && end - begin < static_cast<size_t>(FLUSH_BATCH_SIZE) &&
+           DiskManager::IsNextPage(pages_[dirty_frames[end - 1]].page_id_, pages_[dirty_frames[end]].page_id_)) {
+      end++;
+    }
+    runs.emplace_back(begin, end);
+    writes.push_back(
+        disk_manager_->WritePagesAsync(first_page_id, static_cast<int>(end - begin), copies.data() + begin));
+  }
+  // 写失败的一段页面重新标记为 dirty, 留给下一次刷盘; 在它们 unpin 之前标记, 不会被当作干净页面置换掉
+  for (size_t i = 0; i < writes.size(); i++) {
+    const auto [begin, end] = runs[i];
+    if (writes[i].get()) {
+      flush_writes_.fetch_add(end - begin, std::memory_order_relaxed);
+      continue;
+    }
+    for (size_t j = begin; j < end; j++) {
+      pages_[dirty_frames[j]].is_dirty_ = true;
+    }
+    write_errors_.fetch_add(end - begin, std::memory_order_relaxed);
+    LOG_WARN("failed to flush %zu pages from page %d", end - begin, pages_[dirty_frames[begin]].page_id_);
+  }
+  for (frame_id_t frame_id : dirty_frames) {
+    UnpinWrittenFrame(frame_id);
+  }
+  // 写盘只进入了 OS 的 page cache, FlushAllPages(比如 checkpoint)要保证页面已经持久化
+  if (!dirty_frames.empty()) {
+    disk_manager_->Sync();
+  }
+}
+
+bool BufferPoolManager::GetVictimFrame(frame_id_t *frame_id, BufferAccessStrategy *strategy) {
+  // 扫描/批量写优先复用自己环中的 frame, 不去置换共享 buffer pool 中的热页
+  if (strategy != nullptr && strategy->type_ != AccessType::NORMAL && GetRingFrame(strategy, frame_id)) {
+    ring_victims_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  if (!free_list_.empty()) {  // 空闲链表中找到空frame, 它的 pin_count_ 已经是 -1
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    free_list_victims_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  // 否则需要通过 LRU 置换,找到一个 frame; pin 住页面时不通知 replacer, 所以 victim 可能正被使用:
+  // CAS 0 -> -1 失败就换下一个. 被跳过的 frame 在 pin_count_ 再次降为 0 时会重新加入 replacer
+  while (true) {
+    if (!replacer_->Victim(frame_id)) {
+      return false;
+    }
+    int pin_count = 0;
+    if (pages_[*frame_id].pin_count_.compare_exchange_strong(pin_count, -1)) {
+      break;
+    }
+  }
+
+  replacer_victims_.fetch_add(1, std::memory_order_relaxed);
+  EvictPage(&pages_[*frame_id]);
+  return true;
+}
+
+bool BufferPoolManager::GetRingFrame(BufferAccessStrategy *strategy, frame_id_t *frame_id) {
+  // 环最多占用 buffer pool 的 1/4, 否则小 buffer pool 会被扫描全部占满
+  const size_t ring_size = std::min(strategy->ring_.size(), std::max<size_t>(pool_size_ / 4, 1));
+  strategy->current_ = (strategy->current_ + 1) % ring_size;
+  const BufferAccessStrategy::RingSlot &slot = strategy->ring_[strategy->current_];
+  if (slot.page_id_ == INVALID_PAGE_ID) {  // 环还没有填满
+    return false;
+  }
+
+  // 该 frame 可能已经被正常置换, 装入了别的页面
+  frame_id_t resident_frame_id;
+  if (!page_table_.Find(slot.page_id_, &resident_frame_id) || resident_frame_id != slot.frame_id_) {
+    return false;
+  }
+  // 扫描不负责写回别人弄脏的页面(写回前可能还要先刷日志), 交给正常的置换; 批量写的页面本来就是脏的, 直接写回
+  Page *page = &pages_[resident_frame_id];
+  if (strategy->type_ == AccessType::SEQUENTIAL_SCAN && page->is_dirty_) {
+    return false;
+  }
+  // 页面仍在被使用(比如被别的线程 pin 住)时不能复用
+  int pin_count = 0;
+  if (!page->pin_count_.compare_exchange_strong(pin_count, -1)) {
+    return false;
+  }
+
+  replacer_->Remove(resident_frame_id);
+  EvictPage(page);
+  *frame_id = resident_frame_id;
+  return true;
+}
+
+void BufferPoolManager::AddToRing(BufferAccessStrategy *strategy, frame_id_t frame_id, page_id_t page_id) {
+  if (strategy == nullptr || strategy->type_ == AccessType::NORMAL) {
+    return;
+  }
+  // GetRingFrame 已经把 current_ 移到了这次要填的位置
+  strategy->ring_[strategy->current_] = {frame_id, page_id};
+}
+
+void BufferPoolManager::EvictPage(Page *page) {
+  // 判断找到的 frame 中数据是否 dirty, 是则写回(本质上就是将内存page置换回磁盘)
+  if (page->is_dirty_) {
+    // Before your buffer pool manager evicts a dirty page from LRU replacer and write this page back to db file,
+    // it needs to flush logs up to pageLSN. You need to compare persistent_lsn_ (a member variable maintains
+    // by Log Manager) with your pageLSN. However unlike group commit, buffer pool can force log manager to flush log
+    // buffer, but still needs to wait for logs to be permanently stored before continue
+    if (enable_logging && log_manager_ != nullptr && log_manager_->GetPersistentLSN() < page->GetLSN()) {
+      log_manager_->FlushLog(true);  // 强制刷新
+      forced_log_flushes_.fetch_add(1, std::memory_order_relaxed);
+    }
+    disk_manager_->WritePage(page->page_id_, page->data_);
+    page->is_dirty_ = false;
+    eviction_writes_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // 预读进来却没有被用到就被置换出去了
+  if (prefetched_[page - pages_].exchange(false)) {
+    prefetch_wasted_++;
+  }
+
+  // 从页表中删除被替换出去的 page 信息
+  page_table_.Remove(page->page_id_);
+}
+
+void BufferPoolManager::Prefetch(page_id_t page_id, size_t chain_length,
+                                 std::function<page_id_t(Page *)> next_page_id) {
+  if (page_id == INVALID_PAGE_ID || chain_length == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(prefetch_latch_);
+  // 预读只是提示, 队列满了直接丢弃
+  if (prefetch_shutdown_ || prefetch_queue_.size() >= PREFETCH_QUEUE_SIZE) {
+    return;
+  }
+  // 预读线程在第一次预读时才创建, ParallelBufferPoolManager 的分片不会创建自己的预读线程
+  if (prefetch_threads_.empty()) {
+    for (int i = 0; i < PREFETCH_THREADS; i++) {
+      prefetch_threads_.emplace_back(&BufferPoolManager::PrefetchWorker, this);
+    }
+  }
+  prefetch_queue_.push_back({page_id, chain_length, std::move(next_page_id)});
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::Prefetch(const std::vector<page_id_t> &page_ids) {
+  for (page_id_t page_id : page_ids) {
+    Prefetch(page_id);
+  }
+}
+
+PrefetchStats BufferPoolManager::GetPrefetchStats() {
+  PrefetchStats stats;
+  stats.prefetched_ = prefetched_count_;
+  stats.hits_ = prefetch_hits_;
+  stats.wasted_ = prefetch_wasted_;
+  return stats;
+}
+
+BufferPoolStats BufferPoolManager::GetStats(bool reset) {
+  // reset 时用 exchange 读取并清零, 两次采样之间的事件不会丢失, 也不会被重复计数
+  auto sample = [reset](std::atomic<uint64_t> &counter) {
+    return reset ? counter.exchange(0, std::memory_order_relaxed) : counter.load(std::memory_order_relaxed);
+  };
+  BufferPoolStats stats;
+  stats.fetch_hits_ = sample(fetch_hits_);
+  stats.fetch_misses_ = sample(fetch_misses_);
+  stats.free_list_victims_ = sample(free_list_victims_);
+  stats.replacer_victims_ = sample(replacer_victims_);
+  stats.ring_victims_ = sample(ring_victims_);
+  stats.eviction_writes_ = sample(eviction_writes_);
+  stats.flush_writes_ = sample(flush_writes_);
+  stats.bgwriter_writes_ = sample(bgwriter_writes_);
+  stats.write_errors_ = sample(write_errors_);
+  stats.forced_log_flushes_ = sample(forced_log_flushes_);
+  for (size_t i = 0; i < BufferPoolStats::LATCH_WAIT_BUCKETS; i++) {
+    stats.latch_wait_[i] = sample(latch_wait_[i]);
+  }
+  stats.prefetch_.prefetched_ = sample(prefetched_count_);
+  stats.prefetch_.hits_ = sample(prefetch_hits_);
+  stats.prefetch_.wasted_ = sample(prefetch_wasted_);
+  return stats;
+}
+
+double BufferPoolStats::HitRatio() const {
+  const uint64_t fetches = fetch_hits_ + fetch_misses_;
+  return fetches == 0 ? 0 : static_cast<double>(fetch_hits_) / static_cast<double>(fetches);
+}
+
+BufferPoolStats &BufferPoolStats::operator+=(const BufferPoolStats &other) {
+  fetch_hits_ += other.fetch_hits_;
+  fetch_misses_ += other.fetch_misses_;
+  free_list_victims_ += other.free_list_victims_;
+  replacer_victims_ += other.replacer_victims_;
+  ring_victims_ += other.ring_victims_;
+  eviction_writes_ += other.eviction_writes_;
+  flush_writes_ += other.flush_writes_;
+  bgwriter_writes_ += other.bgwriter_writes_;
+  write_errors_ += other.write_errors_;
+  forced_log_flushes_ += other.forced_log_flushes_;
+  for (size_t i = 0; i < LATCH_WAIT_BUCKETS; i++) {
+    latch_wait_[i] += other.latch_wait_[i];
+  }
+  prefetch_.prefetched_ += other.prefetch_.prefetched_;
+  prefetch_.hits_ += other.prefetch_.hits_;
+  prefetch_.wasted_ += other.prefetch_.wasted_;
+  return *this;
+}
+
+Page *BufferPoolManager::PrefetchPageImpl(page_id_t page_id) {
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id) && TryPinFrame(frame_id, page_id)) {
+    return &pages_[frame_id];
+  }
+  {
+    auto guard = LockLatch();
+    if (page_table_.Find(page_id, &frame_id)) {
+      pages_[frame_id].pin_count_.fetch_add(1);
+      return &pages_[frame_id];
+    }
+    // 同一个页面已经在预读了, 不必再读一次
+    if (prefetch_reads_.count(page_id) > 0 || !GetVictimFrame(&frame_id)) {
+      return nullptr;
+    }
+    // 读盘期间 page_id_ 保持无效, FlushAllPages 不会把读了一半的数据写回
+    pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+    prefetch_reads_.emplace(page_id, false);
+  }
+
+  // 与 FetchPage 不同, 预读在读盘时不持有 latch_: 这个 frame 的 pin_count_ 为 -1, 且不在页表、free list 和
+  // replacer 中, 其他线程都看不到它
+  Page *page = &pages_[frame_id];
+  try {
+    disk_manager_->ReadPage(page_id, page->data_);
+  } catch (const CorruptedPageException &) {
+    // 预读不报告校验失败, 真正 FetchPage 这个页面时才会抛出异常
+    auto guard = LockLatch();
+    prefetch_reads_.erase(page_id);
+    free_list_.emplace_back(frame_id);
+    return nullptr;
+  }
+
+  auto guard = LockLatch();
+  auto read = prefetch_reads_.find(page_id);
+  const bool cancelled = read->second;
+  prefetch_reads_.erase(read);
+  frame_id_t resident_frame_id;
+  if (page_table_.Find(page_id, &resident_frame_id)) {
+    // 读盘期间已经被正常的 FetchPage 读进来了, 归还我们的 frame
+    free_list_.emplace_back(frame_id);
+    pages_[resident_frame_id].pin_count_.fetch_add(1);
+    return &pages_[resident_frame_id];
+  }
+  if (cancelled) {
+    // 读盘期间页面被别的路径读进来过(之后可能已被修改、写回并置换出去), 或者被 DeletePage 删除了(它的 page_id
+    // 可能已经被重新分配): 读到的数据可能是旧的, 作废
+    free_list_.emplace_back(frame_id);
+    return nullptr;
+  }
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  page->pin_count_ = 1;
+  page_table_.Insert(page_id, frame_id);
+  // 没有访问记录的 frame 会被 LRU-K 最先置换, 预读的页面还没被用到就被换出去了
+  replacer_->RecordAccess(frame_id);
+  prefetched_[frame_id] = true;
+  prefetched_count_++;
+  return page;
+}
+
+void BufferPoolManager::PrefetchWorker() {
+  while (true) {
+    PrefetchRequest request;
+    {
+      std::unique_lock<std::mutex> lock(prefetch_latch_);
+      prefetch_cv_.wait(lock, [this] { return prefetch_shutdown_ || !prefetch_queue_.empty(); });
+      if (prefetch_shutdown_) {
+        return;
+      }
+      request = std::move(prefetch_queue_.front());
+      prefetch_queue_.pop_front();
+    }
+
+    Page *page = PrefetchPageImpl(request.page_id_);
+    if (page == nullptr) {  // 所有 frame 都被 pin 住了, 或者页面正在预读/已被删除, 放弃这次预读
+      continue;
+    }
+    page_id_t next_page_id = INVALID_PAGE_ID;
+    if (request.chain_length_ > 1 && request.next_page_id_ != nullptr) {
+      page->RLatch();
+      next_page_id = request.next_page_id_(page);
+      page->RUnlatch();
+    }
+    UnpinPage(request.page_id_, false);
+    // 链上的下一个页面只有读到当前页面之后才知道
+    if (next_page_id != INVALID_PAGE_ID) {
+      Prefetch(next_page_id, request.chain_length_ - 1, std::move(request.next_page_id_));
+    }
+  }
+}
+
+void BufferPoolManager::CancelPrefetchRead(page_id_t page_id) {
+  auto read = prefetch_reads_.find(page_id);
+  if (read != prefetch_reads_.end()) {
+    read->second = true;
+  }
+}
+
+void BufferPoolManager::StopPrefetchThreads() {
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    prefetch_shutdown_ = true;
+    prefetch_queue_.clear();
+  }
+  prefetch_cv_.notify_all();
+  for (auto &thread : prefetch_threads_) {
+    thread.join();
+  }
+  prefetch_threads_.clear();
+}
+
+bool BufferPoolManager::SaveResidentPages(const std::string &file_name) {
+  const std::vector<page_id_t> page_ids = GetResidentPages();
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    LOG_WARN("can't open warm-start file %s", file_name.c_str());
+    return false;
+  }
+  // 文件格式: 页面个数, 然后是各个 page_id, 最近使用的在前
+  const auto num_pages = static_cast<uint32_t>(page_ids.size());
+  out.write(reinterpret_cast<const char *>(&num_pages), sizeof(num_pages));
+  out.write(reinterpret_cast<const char *>(page_ids.data()), num_pages * sizeof(page_id_t));
+  return out.good();
+}
+
+size_t BufferPoolManager::LoadResidentPages(const std::string &file_name) {
+  std::ifstream in(file_name, std::ios::binary);
+  if (!in.is_open()) {
+    return 0;
+  }
+  uint32_t num_pages = 0;
+  in.read(reinterpret_cast<char *>(&num_pages), sizeof(num_pages));
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  while (page_ids.size() < num_pages && in.read(reinterpret_cast<char *>(&page_id), sizeof(page_id))) {
+    page_ids.push_back(page_id);
+  }
+  return WarmUp(page_ids);
+}
+
+std::vector<page_id_t> BufferPoolManager::GetResidentPages() {
+  auto guard = LockLatch();
+  std::vector<page_id_t> page_ids;
+  std::vector<bool> listed(pool_size_, false);
+  auto list_frame = [&](size_t frame_id) {
+    if (!listed[frame_id] && pages_[frame_id].page_id_ != INVALID_PAGE_ID) {
+      page_ids.push_back(pages_[frame_id].page_id_);
+      listed[frame_id] = true;
+    }
+  };
+  // 被 pin 住的页面正在使用, 算作最近使用的; 然后按 replacer 的置换顺序倒序, 最后是其余的页面
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (pages_[i].pin_count_ > 0) {
+      list_frame(i);
+    }
+  }
+  const std::vector<frame_id_t> candidates = replacer_->GetVictimCandidates(pool_size_);
+  for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+    list_frame(*it);
+  }
+  for (size_t i = 0; i < pool_size_; i++) {
+    list_frame(i);
+  }
+  return page_ids;
+}
+
+size_t BufferPoolManager::WarmUp(const std::vector<page_id_t> &page_ids) {
+  auto guard = LockLatch();
+  // 只预热放得进空闲 frame 的、最近使用的那些页面, 不置换已经在 buffer pool 中的页面
+  std::vector<page_id_t> selected;
+  std::unordered_set<page_id_t> seen;
+  frame_id_t frame_id;
+  for (page_id_t page_id : page_ids) {
+    if (selected.size() >= free_list_.size()) {
+      break;
+    }
+    if (page_id == INVALID_PAGE_ID || static_cast<uint32_t>(page_id) % num_instances_ != instance_index_ ||
+        page_table_.Find(page_id, &frame_id) || !seen.insert(page_id).second) {
+      continue;
+    }
+    CancelPrefetchRead(page_id);
+    selected.push_back(page_id);
+  }
+
+  // 按 page_id 排序, 连续的页面用一次 preadv 直接读进各自的 frame, 不经过中间 buffer(O_DIRECT 时也是对齐的)
+  std::vector<page_id_t> sorted(selected);
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<char *> run;
+  std::unordered_map<page_id_t, frame_id_t> frames;
+  for (size_t begin = 0, end = 0; begin < sorted.size(); begin = end) {
+    end = begin + 1;
+    while (end < sorted.size() && end - begin < static_cast<size_t>(WARM_START_BATCH_SIZE) &&
+           DiskManager::IsNextPage(sorted[end - 1], sorted[end])) {
+      end++;
+    }
+    run.clear();
+    for (size_t i = begin; i < end; i++) {
+      frames[sorted[i]] = free_list_.front();
+      free_list_.pop_front();
+      run.push_back(pages_[frames[sorted[i]]].data_);
+    }
+    try {
+      disk_manager_->ReadPages(sorted[begin], static_cast<int>(end - begin), run.data());
+    } catch (const CorruptedPageException &) {
+      // 预热只是尽力而为: 有页面校验失败的段不装入, 之后 FetchPage 它时会报告
+      for (size_t i = begin; i < end; i++) {
+        free_list_.push_front(frames[sorted[i]]);
+        frames.erase(sorted[i]);
+      }
+      continue;
+    }
+    for (size_t i = begin; i < end; i++) {
+      frame_id = frames[sorted[i]];
+      Page *page = &pages_[frame_id];
+      page->page_id_ = sorted[i];
+      page->is_dirty_ = false;
+      page->pin_count_ = 0;
+      page_table_.Insert(sorted[i], frame_id);
+    }
+  }
+
+  // 最久未使用的先加入 replacer, 这样预热后的置换顺序与保存时一致
+  for (auto it = selected.rbegin(); it != selected.rend(); ++it) {
+    auto frame = frames.find(*it);
+    if (frame != frames.end()) {
+      replacer_->RecordAccess(frame->second);
+      replacer_->Unpin(frame->second);
+    }
+  }
+  return frames.size();
+}
+
+void BufferPoolManager::StartBackgroundWriter(size_t pages_per_round, std::chrono::milliseconds interval) {
+  StopBackgroundWriter();
+  std::lock_guard<std::mutex> guard(bgwriter_latch_);
+  bgwriter_shutdown_ = false;
+  bgwriter_thread_ = std::thread(&BufferPoolManager::BackgroundWriterWorker, this, pages_per_round, interval);
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> guard(bgwriter_latch_);
+    bgwriter_shutdown_ = true;
+    thread = std::move(bgwriter_thread_);
+  }
+  bgwriter_cv_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+void BufferPoolManager::BackgroundWriterWorker(size_t pages_per_round, std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> lock(bgwriter_latch_);
+  while (!bgwriter_cv_.wait_for(lock, interval, [this] { return bgwriter_shutdown_; })) {
+    lock.unlock();
+    BackgroundWrite(pages_per_round);
+    lock.lock();
+  }
+}
+
+size_t BufferPoolManager::BackgroundWrite(size_t max_pages) {
+  const std::vector<frame_id_t> candidates = replacer_->GetVictimCandidates(max_pages);
+  // 一轮的页面都拷贝到 buffer 中异步写, 同时在途; 写完之前一直 pin 着它们. buffer 按页对齐, O_DIRECT 可以直接写
+  std::unique_ptr<char, decltype(&std::free)> buffer(
+      static_cast<char *>(std::aligned_alloc(PAGE_SIZE, std::max<size_t>(candidates.size(), 1) * PAGE_SIZE)),
+      &std::free);
+  std::vector<frame_id_t> pinned;
+  std::vector<frame_id_t> written_frames;
+  std::vector<std::future<bool>> writes;
+  // 候选 frame 只是 replacer 某一时刻的快照, 每个 frame 都要重新检查
+  for (frame_id_t frame_id : candidates) {
+    Page *page = &pages_[frame_id];
+    if (!page->is_dirty_) {
+      continue;
+    }
+    // 只写没人使用的页面: CAS 0 -> 1 pin 住它, 防止写盘期间被置换. 不调用 replacer_->Pin, 否则它在 LRU 中的位置就变了
+    int pin_count = 0;
+    if (!page->pin_count_.compare_exchange_strong(pin_count, 1)) {
+      continue;
+    }
+
+    pinned.push_back(frame_id);
+    const page_id_t page_id = page->page_id_;
+    char *data = buffer.get() + writes.size() * PAGE_SIZE;
+    bool write = page_id != INVALID_PAGE_ID && page->is_dirty_;
+    if (write) {
+      page->RLatch();
+      // WAL: 日志持久化之前不能写回页面. 后台写线程不强制刷日志, 留给之后的轮次或者置换时处理
+      if (enable_logging && log_manager_ != nullptr && log_manager_->GetPersistentLSN() < page->GetLSN()) {
+        write = false;
+      } else {
+        // 先清 dirty 再拷贝: 拷贝之后的修改会在 unpin 时重新置位 dirty
+        page->is_dirty_ = false;
+        memcpy(data, page->GetData(), PAGE_SIZE);
+      }
+      page->RUnlatch();
+    }
+    if (write) {
+      written_frames.push_back(frame_id);
+      writes.push_back(disk_manager_->WritePageAsync(page_id, data));
+    }
+  }
+
+  size_t num_written = 0;
+  for (size_t i = 0; i < writes.size(); i++) {
+    if (writes[i].get()) {
+      num_written++;
+    } else {
+      // 写失败: 页面还 pin 着, 重新标记为 dirty, 它不会被当作干净页面置换掉
+      pages_[written_frames[i]].is_dirty_ = true;
+      write_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  bgwriter_writes_.fetch_add(num_written, std::memory_order_relaxed);
+  for (frame_id_t frame_id : pinned) {
+    UnpinWrittenFrame(frame_id);
+  }
+  return num_written;
+}
+
+void BufferPoolManager::OnPrefetchHit(frame_id_t frame_id, BufferAccessStrategy *strategy) {
+  // 先读一次再 exchange, 避免每次命中都写这个 cache line
+  if (!prefetched_[frame_id].load(std::memory_order_relaxed) || !prefetched_[frame_id].exchange(false)) {
+    return;
+  }
+  prefetch_hits_++;
+  if (strategy == nullptr || strategy->type_ == AccessType::NORMAL) {
+    return;
+  }
+  // 扫描用到的预读页面纳入它的环, 环中被替换下来的 frame 放回 free list 供下一次预读使用,
+  // 这样预读 + 扫描总共只占用 环大小 + 预读窗口 个 frame, 不会挤出共享 buffer pool 中的热页
+  auto guard = LockLatch();
+  frame_id_t recycled_frame_id;
+  if (GetRingFrame(strategy, &recycled_frame_id)) {
+    pages_[recycled_frame_id].page_id_ = INVALID_PAGE_ID;
+    free_list_.emplace_back(recycled_frame_id);
+  }
+  AddToRing(strategy, frame_id, pages_[frame_id].page_id_);
+}
+
+bool BufferPoolManager::TryPinFrame(frame_id_t frame_id, page_id_t page_id) {
+  Page *page = &pages_[frame_id];
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count < 0) {  // 空闲或正在置换
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+
+  // pin 住之后 frame 不会再被置换, 这时 page_id_ 是稳定的; 但查页表到 pin 住之间它可能已经换成了别的页面
+  if (page->page_id_ != page_id) {
+    if (page->pin_count_.fetch_sub(1) == 1) {
+      // 置换线程可能因为我们短暂的 pin 而把它从 replacer 中跳过了, 放回去; 多放一次也没关系, 置换时会 CAS 检查
+      replacer_->Unpin(frame_id);
+    }
+    return false;
+  }
+  // 不调用 replacer_->Pin(LRUReplacer 的 Pin 要加锁): pin 住的 frame 可能还在 replacer 中, 置换时 CAS 会跳过它
+  return true;
+}
+
+bool BufferPoolManager::PinFrameForWrite(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count < 0) {  // 空闲或正在置换
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+  return true;
+}
+
+void BufferPoolManager::UnpinWrittenFrame(frame_id_t frame_id) {
+  if (pages_[frame_id].pin_count_.fetch_sub(1) == 1) {
+    // 我们 pin 住期间它可能被 Victim 取出后跳过了, 或者使用者 unpin 时看到它还被 pin 着, 放回去
+    replacer_->Unpin(frame_id);
+  }
+}
+
+void BufferPoolManager::CopyPageForWrite(Page *page, char *data) {
+  page->RLatch();
+  // 先清 dirty 再拷贝: 拷贝之后的修改会在 unpin 时重新置位 dirty
+  page->is_dirty_ = false;
+  memcpy(data, page->GetData(), PAGE_SIZE);
+  page->RUnlatch();
+}
+
+size_t BufferPoolManager::GrowPool(size_t num_frames) {
+  auto guard = LockLatch();
+  // 新启用的 frame 的 pin_count_ 一直是 -1, page_id_ 无效, 直接加入空闲链表即可
+  const size_t old_size = pool_size_;
+  const size_t new_size = std::min(max_pool_size_, old_size + num_frames);
+  for (size_t i = old_size; i < new_size; i++) {
+    free_list_.emplace_back(static_cast<frame_id_t>(i));
+  }
+  pool_size_ = new_size;
+  return new_size - old_size;
+}
+
+size_t BufferPoolManager::ShrinkPool(size_t num_frames) {
+  auto guard = LockLatch();
+  std::vector<bool> is_free(pool_size_, false);
+  for (frame_id_t frame_id : free_list_) {
+    is_free[frame_id] = true;
+  }
+
+  // 从最后一个 frame 开始往前退役, 这样在用的 frame 总是 [0, pool_size_), 不需要移动任何 frame
+  const size_t old_size = pool_size_;
+  size_t new_size = old_size;
+  while (new_size > 0 && old_size - new_size < num_frames) {
+    const auto frame_id = static_cast<frame_id_t>(new_size - 1);
+    Page *page = &pages_[frame_id];
+    if (!is_free[frame_id]) {
+      // 和置换一样 CAS 0 -> -1; 被 pin 住的, 或者 pin_count_ 为 -1 却不在空闲链表中(预读线程正在往里读盘)的 frame
+      // 不能退役, 到此为止
+      int pin_count = 0;
+      if (!page->pin_count_.compare_exchange_strong(pin_count, -1)) {
+        break;
+      }
+      replacer_->Remove(frame_id);
+      EvictPage(page);
+      page->page_id_ = INVALID_PAGE_ID;
+      page->is_dirty_ = false;
+    }
+    new_size--;
+  }
+  if (new_size == old_size) {
+    return 0;
+  }
+
+  free_list_.remove_if([new_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= new_size; });
+  pool_size_ = new_size;
+  // 退役的 frame 已经不在页表中, 无锁的 fetch 即使拿到旧的 frame_id 也 pin 不住它(pin_count_ 为 -1)
+  frame_arena_.Release(new_size, old_size - new_size);
+  return old_size - new_size;
+}
+
+std::unique_lock<std::mutex> BufferPoolManager::LockLatch() {
+  // 只有拿不到锁时才计时, 没有竞争的加锁不需要读时钟
+  std::unique_lock<std::mutex> guard(latch_, std::try_to_lock);
+  if (guard.owns_lock()) {
+    latch_wait_[0].fetch_add(1, std::memory_order_relaxed);
+    return guard;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  guard.lock();
+  const auto wait_us = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+  // wait_us 为 0 时落在第 1 个桶, 否则落在 2 + floor(log2(wait_us))
+  size_t bucket = 1;
+  for (uint64_t us = wait_us; us > 0; us >>= 1) {
+    bucket++;
+  }
+  latch_wait_[std::min(bucket, BufferPoolStats::LATCH_WAIT_BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+  return guard;
+}
+
+page_id_t BufferPoolManager::AllocatePage() {
+  // 单独使用时, page_id 由 disk manager 统一分配
+  if (num_instances_ == 1) {
+    return disk_manager_->AllocatePage();
   }
+  // 作为 ParallelBufferPoolManager 的一个分片时, 只分配满足 page_id % num_instances_ == instance_index_ 的 page_id,
+  // 这样 ParallelBufferPoolManager 才能根据 page_id 找到它所在的分片
+  const page_id_t next_page_id = disk_manager_->AllocatePage(num_instances_, instance_index_);
+  BUSTUB_ASSERT(next_page_id % num_instances_ == instance_index_, "allocated page id belongs to another instance");
+  return next_page_id;
 }
 
 }  // namespace bustub
@@ -12,18 +12,78 @@
 
 #include "buffer/clock_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : num_pages_(num_pages) {
+  frames_ = new std::atomic<uint8_t>[num_pages];
+  for (size_t i = 0; i < num_pages; i++) {
+    frames_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+ClockReplacer::~ClockReplacer() { delete[] frames_; }
 
-ClockReplacer::~ClockReplacer() = default;
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  // 时钟指针扫过的 frame: 不可置换的跳过; 引用位为1的清零后跳过(第二次机会); 否则就是 victim.
+  // 多个线程可以同时扫描, 每个线程用 fetch_add 领取指针的下一个位置, 用 CAS 抢占 victim
+  while (size_.load() > 0) {
+    const size_t pos = clock_hand_.fetch_add(1) % num_pages_;
+    uint8_t state = frames_[pos].load();
+    if ((state & EVICTABLE) == 0) {
+      continue;
+    }
+    if ((state & REFERENCED) != 0) {
+      // CAS 失败说明有并发的 Pin/Unpin, 交给下一圈处理即可
+      frames_[pos].compare_exchange_strong(state, EVICTABLE);
+      continue;
+    }
+    if (frames_[pos].compare_exchange_strong(state, 0)) {
+      size_--;
+      *frame_id = static_cast<frame_id_t>(pos);
+      return true;
+    }
+  }
+  return false;
+}
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+/*
+ * This method should be called after a page is pinned to a frame in the BufferPoolManager
+ */
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "frame id out of range");
+  if ((frames_[frame_id].exchange(0) & EVICTABLE) != 0) {
+    size_--;
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+/*
+ * This method should be called when the pin_count of a page becomes 0
+ */
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "frame id out of range");
+  if ((frames_[frame_id].fetch_or(EVICTABLE | REFERENCED) & EVICTABLE) == 0) {
+    size_++;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+size_t ClockReplacer::Size() {
+  const int64_t size = size_.load();
+  return size > 0 ? static_cast<size_t>(size) : 0;
+}
 
-size_t ClockReplacer::Size() { return 0; }
+std::vector<frame_id_t> ClockReplacer::GetVictimCandidates(size_t max_count) {
+  // 从时钟指针当前位置往前看一圈, 引用位为0的可置换 frame 就是指针接下来会选中的 victim; 只读, 不清引用位
+  std::vector<frame_id_t> candidates;
+  const size_t hand = clock_hand_.load();
+  for (size_t i = 0; i < num_pages_ && candidates.size() < max_count; i++) {
+    const size_t pos = (hand + i) % num_pages_;
+    if (frames_[pos].load() == EVICTABLE) {
+      candidates.push_back(static_cast<frame_id_t>(pos));
+    }
+  }
+  return candidates;
+}
 
 }  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <new>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames) : num_frames_(num_frames) {
+  const size_t data_size = num_frames * PAGE_SIZE;
+  if (data_size > 0) {
+    // 1. 显式大页: 需要系统预留了 hugetlbfs 页面, 否则 mmap 失败
+    void *data = MAP_FAILED;
+    if (data_size >= HUGE_PAGE_SIZE) {
+      mapped_size_ = (data_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+      data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      huge_pages_ = data != MAP_FAILED;
+    }
+    // 2. 普通页面, 再建议内核使用透明大页; madvise 失败(比如内核没有开启 THP)也没关系
+    if (data == MAP_FAILED) {
+      mapped_size_ = data_size;
+      // MAP_NORESERVE: 只为 buffer pool 可以增长到的大小预留地址空间, 不占用 overcommit 的额度
+      data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (data == MAP_FAILED) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map the buffer pool frames");
+      }
+#ifdef MADV_HUGEPAGE
+      if (data_size >= HUGE_PAGE_SIZE) {
+        madvise(data, mapped_size_, MADV_HUGEPAGE);
+      }
+#endif
+    }
+    // 匿名映射的内存已经清零
+    data_ = static_cast<char *>(data);
+  }
+
+  // 元数据数组单独分配, Page 按 cache line 对齐; Page 没有默认的 frame 构造方式, 所以用 placement new 逐个构造
+  pages_ = static_cast<Page *>(::operator new[](num_frames * sizeof(Page), std::align_val_t(alignof(Page))));
+  for (size_t i = 0; i < num_frames; i++) {
+    new (&pages_[i]) Page(data_ + i * PAGE_SIZE);
+  }
+}
+
+void FrameArena::Release(size_t first_frame, size_t num_frames) {
+  if (data_ == nullptr || num_frames == 0) {
+    return;
+  }
+  // 显式大页只能按大页释放; madvise 失败时内存只是没有归还, frame 仍然可用
+  size_t begin = first_frame * PAGE_SIZE;
+  size_t end = std::min((first_frame + num_frames) * PAGE_SIZE, mapped_size_);
+  if (huge_pages_) {
+    begin = (begin + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    end = end == num_frames_ * PAGE_SIZE ? mapped_size_ : end / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+  if (begin < end) {
+    madvise(data_ + begin, end - begin, MADV_DONTNEED);
+  }
+}
+
+FrameArena::~FrameArena() {
+  for (size_t i = 0; i < num_frames_; i++) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_, std::align_val_t(alignof(Page)));
+  if (data_ != nullptr) {
+    munmap(data_, mapped_size_);
+  }
+}
+
+}  // namespace bustub
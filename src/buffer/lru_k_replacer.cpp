@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_period)
+    : k_(k), correlated_period_(correlated_period), frames_(num_pages) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs k >= 1");
+}
+
+LRUKReplacer::EvictKey LRUKReplacer::MakeKey(frame_id_t frame_id) const {
+  const FrameHistory &frame = frames_[frame_id];
+  if (frame.history_.size() < k_) {
+    // 不足K次引用: backward K-distance 为无穷大, 按最早的一次引用排序(没有引用记录的最先置换)
+    return {{false, frame.history_.empty() ? 0 : frame.history_.back()}, frame_id};
+  }
+  // backward K-distance 越大, 第K次引用的时间越早
+  return {{true, frame.history_[k_ - 1]}, frame_id};
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (evictable_.empty()) {
+    return false;
+  }
+
+  // 处于相关引用周期内的 frame 暂不置换; 如果所有可置换的 frame 都在周期内, 退化为选第一个
+  auto victim = evictable_.begin();
+  for (auto it = evictable_.begin(); it != evictable_.end(); ++it) {
+    if (current_timestamp_ - frames_[it->second].last_ > correlated_period_) {
+      victim = it;
+      break;
+    }
+  }
+
+  *frame_id = victim->second;
+  evictable_.erase(victim);
+  // 被置换的 frame 将装入别的页面, 之前的引用历史不再有意义
+  frames_[*frame_id] = FrameHistory();
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < frames_.size(), "frame id out of range");
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    evictable_.erase(MakeKey(frame_id));
+    frame.evictable_ = false;
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < frames_.size(), "frame id out of range");
+  FrameHistory &frame = frames_[frame_id];
+  if (!frame.evictable_) {
+    evictable_.insert(MakeKey(frame_id));
+    frame.evictable_ = true;
+  }
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return evictable_.size();
+}
+
+std::vector<frame_id_t> LRUKReplacer::GetVictimCandidates(size_t max_count) {
+  // 按 EvictKey 顺序返回; 不考虑相关引用周期, 周期很短, 这些 frame 很快也会被置换
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<frame_id_t> candidates;
+  for (auto it = evictable_.begin(); it != evictable_.end() && candidates.size() < max_count; ++it) {
+    candidates.push_back(it->second);
+  }
+  return candidates;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < frames_.size(), "frame id out of range");
+  FrameHistory &frame = frames_[frame_id];
+  // 排序键依赖引用历史, 可置换的 frame 需要先从 evictable_ 中取出, 更新后再放回
+  if (frame.evictable_) {
+    evictable_.erase(MakeKey(frame_id));
+  }
+
+  const uint64_t now = ++current_timestamp_;
+  if (frame.history_.empty()) {
+    frame.history_.push_back(now);
+  } else if (now - frame.last_ > correlated_period_) {
+    // 新的非相关引用: 上一段相关引用持续的时间不计入 backward K-distance, 把已有的历史整体后移这么多
+    const uint64_t correlated_span = frame.last_ - frame.history_.front();
+    for (size_t i = 0; i < frame.history_.size(); i++) {
+      frame.history_[i] += correlated_span;
+    }
+    frame.history_.insert(frame.history_.begin(), now);
+    if (frame.history_.size() > k_) {
+      frame.history_.pop_back();
+    }
+  }
+  // 相关引用只更新最后一次引用的时间
+  frame.last_ = now;
+
+  if (frame.evictable_) {
+    evictable_.insert(MakeKey(frame_id));
+  }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < frames_.size(), "frame id out of range");
+  if (frames_[frame_id].evictable_) {
+    evictable_.erase(MakeKey(frame_id));
+  }
+  frames_[frame_id] = FrameHistory();
+}
+
+}  // namespace bustub
@@ -80,15 +80,16 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   // unpined 的 frame 可以被加入LRU链表末尾
   // 注: project1中没有提及LRU缓存满的情况,这里暂时Log下来
   latch_.lock();
-  if(unpin_pages_ >= max_pages_){
-    LOG_WARN("cached pages in LRU buff have exceed, where max_pages=%d, used_pages=%d",\
-            (int)max_pages_,(int)unpin_pages_);
+  // 若 frame 已经在LRU链表中, 根据提供的测试代码:不需要将其放到链表末尾...
+  if(id2ptr_.find(frame_id) != id2ptr_.end()){
     latch_.unlock();
     return;
   }
-  
-  // 若 frame 已经在LRU链表中, 根据提供的测试代码:不需要将其放到链表末尾...
-  if(id2ptr_.find(frame_id) != id2ptr_.end()){
+
+  // 已在链表中的 frame 先返回, 否则链表满时重复 Unpin 会误报 (后台写线程会对已在链表中的 frame 再次 Unpin)
+  if(unpin_pages_ >= max_pages_){
+    LOG_WARN("cached pages in LRU buff have exceed, where max_pages=%d, used_pages=%d",\
+            (int)max_pages_,(int)unpin_pages_);
     latch_.unlock();
     return;
   }
@@ -104,6 +105,26 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   latch_.unlock();
 }
 
+/*
+ * BufferPoolManager 命中时不调用 Pin, 被访问的 frame 可能还在链表中: 把它移到链表末尾, 保持最近使用的顺序
+ */
+void LRUReplacer::RecordAccess(frame_id_t frame_id) {
+  latch_.lock();
+  auto it = id2ptr_.find(frame_id);
+  if(it == id2ptr_.end() || it->second == tail_->prev){
+    latch_.unlock();
+    return;
+  }
+
+  Node* node = it->second;
+  node->prev->next = node->next; node->next->prev = node->prev;
+  Node* prev = tail_->prev;
+  prev->next = node;
+  node->prev = prev; node->next = tail_;
+  tail_->prev = node;
+  latch_.unlock();
+}
+
 size_t LRUReplacer::Size() {
   int size;
   latch_.lock();
@@ -112,4 +133,15 @@ size_t LRUReplacer::Size() {
   return size; 
 }
 
+std::vector<frame_id_t> LRUReplacer::GetVictimCandidates(size_t max_count) {
+  // 从链表头部(最近最久未使用)开始, 正是 Victim 的顺序
+  std::vector<frame_id_t> candidates;
+  latch_.lock();
+  for (Node *node = head_->next; node != tail_ && candidates.size() < max_count; node = node->next) {
+    candidates.push_back(node->frame_id);
+  }
+  latch_.unlock();
+  return candidates;
+}
+
 }  // namespace bustub
@@ -0,0 +1,224 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/mmap_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/mmap_buffer_pool_manager.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <new>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+MmapBufferPoolManager::MmapBufferPoolManager(const std::string &db_file) : BufferPoolManager(0, nullptr) {
+  fd_ = open(db_file.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    close(fd_);
+    throw Exception("can't stat db file");
+  }
+  // 文件末尾不完整的页面不算, 它是被中断的写入
+  num_pages_ = static_cast<size_t>(st.st_size) / PAGE_SIZE;
+  if (num_pages_ > 0) {
+    void *data = mmap(nullptr, num_pages_ * PAGE_SIZE, PROT_READ, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      close(fd_);
+      throw Exception("can't map db file");
+    }
+    data_ = static_cast<char *>(data);
+  }
+  const size_t num_extents = (num_pages_ + EXTENT_SIZE - 1) / EXTENT_SIZE;
+  extent_pages_ = std::make_unique<std::atomic<Page *>[]>(num_extents);
+  sequential_ = std::make_unique<std::atomic<bool>[]>(num_extents);
+  verified_ = std::make_unique<std::atomic<bool>[]>(num_pages_);
+}
+
+MmapBufferPoolManager::~MmapBufferPoolManager() {
+  // 预读线程会调用 PrefetchPageImpl, 必须在 Page 被销毁之前停掉
+  StopPrefetchThreads();
+  const size_t num_extents = (num_pages_ + EXTENT_SIZE - 1) / EXTENT_SIZE;
+  for (size_t i = 0; i < num_extents; i++) {
+    Page *pages = extent_pages_[i].load(std::memory_order_relaxed);
+    if (pages == nullptr) {
+      continue;
+    }
+    for (size_t j = 0; j < EXTENT_SIZE; j++) {
+      pages[j].~Page();
+    }
+    ::operator delete[](pages, std::align_val_t(alignof(Page)));
+  }
+  if (data_ != nullptr) {
+    munmap(data_, num_pages_ * PAGE_SIZE);
+  }
+  close(fd_);
+}
+
+/**
+ * The Page objects are created one extent at a time, so that the metadata of a large file only takes memory for the
+ * part of it that is used
+ */
+Page *MmapBufferPoolManager::GetPage(page_id_t page_id) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= num_pages_) {
+    return nullptr;
+  }
+  const size_t extent = page_id / EXTENT_SIZE;
+  Page *pages = extent_pages_[extent].load(std::memory_order_acquire);
+  if (pages == nullptr) {
+    std::lock_guard<std::mutex> guard(extent_latch_);
+    pages = extent_pages_[extent].load(std::memory_order_relaxed);
+    if (pages == nullptr) {
+      pages = static_cast<Page *>(::operator new[](EXTENT_SIZE * sizeof(Page), std::align_val_t(alignof(Page))));
+      for (size_t i = 0; i < EXTENT_SIZE; i++) {
+        // 文件最后一个 extent 中超出文件的 Page 指向 nullptr, GetPage 不会返回它们
+        const size_t n = extent * EXTENT_SIZE + i;
+        new (&pages[i]) Page(n < num_pages_ ? data_ + n * PAGE_SIZE : nullptr);
+        pages[i].page_id_ = static_cast<page_id_t>(n);
+      }
+      extent_pages_[extent].store(pages, std::memory_order_release);
+    }
+  }
+  return &pages[page_id % EXTENT_SIZE];
+}
+
+void MmapBufferPoolManager::Advise(page_id_t page_id, size_t num_pages, int advice) {
+  // madvise 要求地址按 OS 页面对齐, OS 页面可能比 PAGE_SIZE 大
+  static const auto os_page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t begin = static_cast<size_t>(page_id) * PAGE_SIZE / os_page_size * os_page_size;
+  const size_t end = std::min(static_cast<size_t>(page_id) + num_pages, num_pages_) * PAGE_SIZE;
+  if (begin < end && madvise(data_ + begin, end - begin, advice) != 0) {
+    LOG_DEBUG("madvise failed for page %d", page_id);
+  }
+}
+
+Page *MmapBufferPoolManager::FetchPageImpl(page_id_t page_id) { return FetchPageImpl(page_id, nullptr); }
+
+Page *MmapBufferPoolManager::FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) {
+  Page *page = GetPage(page_id);
+  if (page == nullptr) {
+    return nullptr;
+  }
+  if (strategy != nullptr && strategy->GetType() == AccessType::SEQUENTIAL_SCAN) {
+    // 表和索引的页面按 extent 分配, 顺序扫描的页面几乎都在它的 extent 中, 每个 extent 只需要提示一次
+    const size_t extent = page_id / EXTENT_SIZE;
+    if (!sequential_[extent].load(std::memory_order_relaxed) && !sequential_[extent].exchange(true)) {
+      Advise(static_cast<page_id_t>(extent * EXTENT_SIZE), EXTENT_SIZE, MADV_SEQUENTIAL);
+    }
+  }
+  // 第一次 fetch 时校验页面, 也是这时缺页把它从磁盘读进来, 所以算作未命中; 同时校验同一个页面的线程结果相同
+  if (verified_[page_id].load(std::memory_order_acquire)) {
+    fetch_hits_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    fetch_misses_.fetch_add(1, std::memory_order_relaxed);
+    if (!DiskManager::IsPageChecksumValid(page->data_)) {
+      throw CorruptedPageException(page_id);
+    }
+    verified_[page_id].store(true, std::memory_order_release);
+  }
+  page->pin_count_.fetch_add(1);
+  return page;
+}
+
+bool MmapBufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  Page *page = GetPage(page_id);
+  if (page == nullptr) {
+    return false;
+  }
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  if (is_dirty) {
+    LOG_WARN("page %d was unpinned dirty, the memory-mapped buffer pool is read-only", page_id);
+    return false;
+  }
+  return true;
+}
+
+std::vector<Page *> MmapBufferPoolManager::FetchPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<Page *> pages;
+  pages.reserve(page_ids.size());
+  try {
+    for (page_id_t page_id : page_ids) {
+      pages.push_back(FetchPageImpl(page_id));
+    }
+  } catch (const CorruptedPageException &) {
+    // 和 BufferPoolManager::FetchPages 一样, 抛出异常时不留下被 pin 住的页面
+    for (Page *page : pages) {
+      if (page != nullptr) {
+        UnpinPageImpl(page->page_id_, false);
+      }
+    }
+    throw;
+  }
+  return pages;
+}
+
+bool MmapBufferPoolManager::UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) {
+  bool all_unpinned = true;
+  for (const auto &[page_id, is_dirty] : pages) {
+    all_unpinned = UnpinPageImpl(page_id, is_dirty) && all_unpinned;
+  }
+  return all_unpinned;
+}
+
+bool MmapBufferPoolManager::FlushPageImpl(page_id_t page_id) { return false; }
+
+Page *MmapBufferPoolManager::NewPageImpl(page_id_t *page_id) { return NewPageImpl(page_id, nullptr); }
+
+Page *MmapBufferPoolManager::NewPageImpl(page_id_t *page_id, BufferAccessStrategy *strategy) {
+  LOG_WARN("can't create a page, the memory-mapped buffer pool is read-only");
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+Page *MmapBufferPoolManager::NewPageImpl(page_id_t *page_id, PageExtent *extent, BufferAccessStrategy *strategy) {
+  return NewPageImpl(page_id, strategy);
+}
+
+bool MmapBufferPoolManager::DeletePageImpl(page_id_t page_id) { return false; }
+
+Page *MmapBufferPoolManager::PrefetchPageImpl(page_id_t page_id) {
+  Page *page = GetPage(page_id);
+  if (page == nullptr) {
+    return nullptr;
+  }
+  Advise(page_id, 1, MADV_WILLNEED);
+  // 预读线程接下来读这个页面(沿着链表找下一个页面), 缺页发生在预读线程而不是扫描的线程中; 真正 FetchPage
+  // 时才校验
+  page->pin_count_.fetch_add(1);
+  prefetched_count_.fetch_add(1, std::memory_order_relaxed);
+  return page;
+}
+
+size_t MmapBufferPoolManager::WarmUp(const std::vector<page_id_t> &page_ids) {
+  size_t num_pages = 0;
+  for (page_id_t page_id : page_ids) {
+    if (page_id >= 0 && static_cast<size_t>(page_id) < num_pages_) {
+      Advise(page_id, 1, MADV_WILLNEED);
+      num_pages++;
+    }
+  }
+  return num_pages;
+}
+
+}  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_frames) {
+  // 装载率不超过 50%, 线性探测的平均探测长度很短
+  capacity_ = 2;
+  shift_ = 63;
+  while (capacity_ < 2 * num_frames) {
+    capacity_ <<= 1;
+    shift_--;
+  }
+  mask_ = capacity_ - 1;
+  slots_ = new std::atomic<uint64_t>[capacity_];
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+}
+
+PageTable::~PageTable() { delete[] slots_; }
+
+bool PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const {
+  size_t slot = HomeSlot(page_id);
+  // 最多探测 capacity_ 次: 并发的 Remove 在搬移元素, 不能假设一定能遇到空槽
+  for (size_t probes = 0; probes < capacity_; probes++) {
+    const uint64_t entry = slots_[slot].load(std::memory_order_acquire);
+    if (entry == EMPTY_SLOT) {
+      return false;
+    }
+    if (EntryPageId(entry) == page_id) {
+      *frame_id = EntryFrameId(entry);
+      return true;
+    }
+    slot = (slot + 1) & mask_;
+  }
+  return false;
+}
+
+size_t PageTable::FindSlot(page_id_t page_id) const {
+  size_t slot = HomeSlot(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++) {
+    const uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY_SLOT) {
+      return capacity_;
+    }
+    if (EntryPageId(entry) == page_id) {
+      return slot;
+    }
+    slot = (slot + 1) & mask_;
+  }
+  return capacity_;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "can not insert INVALID_PAGE_ID into the page table");
+  size_t slot = HomeSlot(page_id);
+  while (true) {
+    const uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY_SLOT) {
+      BUSTUB_ASSERT(size_ < capacity_ / 2, "page table holds more entries than frames");
+      size_++;
+      break;
+    }
+    if (EntryPageId(entry) == page_id) {
+      break;
+    }
+    slot = (slot + 1) & mask_;
+  }
+  slots_[slot].store(MakeEntry(page_id, frame_id), std::memory_order_release);
+}
+
+bool PageTable::Remove(page_id_t page_id) {
+  size_t hole = FindSlot(page_id);
+  if (hole == capacity_) {
+    return false;
+  }
+
+  // backward shift: 把 hole 之后同一个 cluster 中、探测路径经过 hole 的元素前移填洞, 最后一个洞才置为空.
+  // 元素是先复制到前面再覆盖原位置, 所以并发的 Find 最多漏掉正在搬移的元素, 不会读到不完整的 entry
+  size_t slot = hole;
+  while (true) {
+    slot = (slot + 1) & mask_;
+    const uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY_SLOT) {
+      break;
+    }
+    // entry 的 home 在 (hole, slot] 区间(环形)内时, 它的探测路径不经过 hole, 不能前移
+    const size_t home = HomeSlot(EntryPageId(entry));
+    const bool home_between = hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+    if (!home_between) {
+      slots_[hole].store(entry, std::memory_order_release);
+      hole = slot;
+    }
+  }
+  slots_[hole].store(EMPTY_SLOT, std::memory_order_release);
+  size_--;
+  return true;
+}
+
+}  // namespace bustub
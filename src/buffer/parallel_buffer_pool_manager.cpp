@@ -0,0 +1,283 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+// 父类本身不持有任何 frame(pool_size 为0), 所有 frame 都在各个分片中
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerPolicy replacer_policy, size_t max_pool_size)
+    : BufferPoolManager(0, disk_manager, log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "ParallelBufferPoolManager needs at least one instance");
+  // Allocate and create individual BufferPoolManager instances
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.push_back(new BufferPoolManager(pool_size, static_cast<uint32_t>(num_instances),
+                                               static_cast<uint32_t>(i), disk_manager, log_manager,
+                                               replacer_policy, max_pool_size));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // 预读线程会访问各个分片, 必须在删除分片之前停掉
+  StopPrefetchThreads();
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  // Get BufferPoolManager responsible for handling given page id.
+  return instances_[static_cast<uint32_t>(page_id) % instances_.size()];
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id) {
+  // Fetch page for page_id from responsible BufferPoolManager
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) {
+  if (strategy == nullptr) {
+    return FetchPageImpl(page_id);
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, *strategy);
+}
+
+bool ParallelBufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  // Unpin page_id from responsible BufferPoolManager
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPageImpl(page_id_t page_id) {
+  // Flush page_id from responsible BufferPoolManager
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPageImpl(page_id_t *page_id) { return NewPageImpl(page_id, nullptr); }
+
+Page *ParallelBufferPoolManager::NewPageImpl(page_id_t *page_id, BufferAccessStrategy *strategy) {
+  // create new page. We will request page allocation in a round robin manner from the underlying
+  // BufferPoolManagers. If AllocatePage fails, we try the next one until all have been tried.
+  // 1.   From a starting index of the BPMs, call NewPageImpl until either 1) success and return 2) looped around to
+  //      starting index and return nullptr
+  // 2.   Bump the starting index (mod number of instances) to start search at a different BPM each time this
+  //      function is called
+  const size_t start = next_instance_.fetch_add(1) % instances_.size();
+  for (size_t i = 0; i < instances_.size(); i++) {
+    BufferPoolManager *instance = instances_[(start + i) % instances_.size()];
+    Page *page = strategy == nullptr ? instance->NewPage(page_id) : instance->NewPage(page_id, *strategy);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+Page *ParallelBufferPoolManager::NewPageImpl(page_id_t *page_id, PageExtent *extent, BufferAccessStrategy *strategy) {
+  // extent 中的页面是连续的, 会轮流落在各个分片上; 每个页面只能由拥有它的分片创建
+  *page_id = extent->AllocatePage(instances_[0]->disk_manager_);
+  Page *page = GetBufferPoolManager(*page_id)->NewPageWithId(*page_id, strategy);
+  if (page == nullptr) {
+    extent->ReleasePage(*page_id);
+  }
+  return page;
+}
+
+bool ParallelBufferPoolManager::DeletePageImpl(page_id_t page_id) {
+  // Delete page_id from responsible BufferPoolManager
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+std::vector<Page *> ParallelBufferPoolManager::FetchPages(const std::vector<page_id_t> &page_ids) {
+  // 按分片拆分, positions[k][j] 是分片 k 的第 j 个页面在 page_ids 中的位置
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  std::vector<std::vector<size_t>> positions(instances_.size());
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if (page_ids[i] == INVALID_PAGE_ID) {
+      continue;
+    }
+    const size_t k = static_cast<uint32_t>(page_ids[i]) % instances_.size();
+    instance_page_ids[k].push_back(page_ids[i]);
+    positions[k].push_back(i);
+  }
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  for (size_t k = 0; k < instances_.size(); k++) {
+    if (instance_page_ids[k].empty()) {
+      continue;
+    }
+    const std::vector<Page *> instance_pages = instances_[k]->FetchPages(instance_page_ids[k]);
+    for (size_t j = 0; j < instance_pages.size(); j++) {
+      pages[positions[k][j]] = instance_pages[j];
+    }
+  }
+  return pages;
+}
+
+bool ParallelBufferPoolManager::UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) {
+  std::vector<std::vector<std::pair<page_id_t, bool>>> instance_pages(instances_.size());
+  for (const auto &page : pages) {
+    instance_pages[static_cast<uint32_t>(page.first) % instances_.size()].push_back(page);
+  }
+  bool unpinned = true;
+  for (size_t k = 0; k < instances_.size(); k++) {
+    if (!instance_pages[k].empty()) {
+      unpinned = instances_[k]->UnpinPages(instance_pages[k]) && unpinned;
+    }
+  }
+  return unpinned;
+}
+
+PrefetchStats ParallelBufferPoolManager::GetPrefetchStats() {
+  PrefetchStats stats;
+  for (auto *instance : instances_) {
+    PrefetchStats instance_stats = instance->GetPrefetchStats();
+    stats.prefetched_ += instance_stats.prefetched_;
+    stats.hits_ += instance_stats.hits_;
+    stats.wasted_ += instance_stats.wasted_;
+  }
+  return stats;
+}
+
+size_t ParallelBufferPoolManager::GrowPool(size_t num_frames) {
+  size_t added = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    added += instances_[i]->GrowPool(num_frames / instances_.size() + (i < num_frames % instances_.size() ? 1 : 0));
+  }
+  return added;
+}
+
+size_t ParallelBufferPoolManager::ShrinkPool(size_t num_frames) {
+  size_t removed = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    removed +=
+        instances_[i]->ShrinkPool(num_frames / instances_.size() + (i < num_frames % instances_.size() ? 1 : 0));
+  }
+  return removed;
+}
+
+Page *ParallelBufferPoolManager::GetPages() { return nullptr; }
+
+Page *ParallelBufferPoolManager::GetFrame(size_t frame_id) {
+  for (auto *instance : instances_) {
+    const size_t pool_size = instance->GetPoolSize();
+    if (frame_id < pool_size) {
+      return instance->GetFrame(frame_id);
+    }
+    frame_id -= pool_size;
+  }
+  return nullptr;
+}
+
+size_t ParallelBufferPoolManager::GetMaxPoolSize() {
+  size_t max_pool_size = 0;
+  for (auto *instance : instances_) {
+    max_pool_size += instance->GetMaxPoolSize();
+  }
+  return max_pool_size;
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() {
+  size_t pool_size = 0;
+  for (auto *instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats(bool reset) {
+  BufferPoolStats stats;
+  for (const BufferPoolStats &instance_stats : GetInstanceStats(reset)) {
+    stats += instance_stats;
+  }
+  return stats;
+}
+
+std::vector<BufferPoolStats> ParallelBufferPoolManager::GetInstanceStats(bool reset) {
+  std::vector<BufferPoolStats> stats;
+  stats.reserve(instances_.size());
+  for (auto *instance : instances_) {
+    stats.push_back(instance->GetStats(reset));
+  }
+  return stats;
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetResidentPages() {
+  std::vector<std::vector<page_id_t>> instance_pages;
+  size_t max_size = 0;
+  for (auto *instance : instances_) {
+    instance_pages.push_back(instance->GetResidentPages());
+    max_size = std::max(max_size, instance_pages.back().size());
+  }
+  // 各分片之间没有统一的访问顺序, 轮流取各分片的第 i 个页面
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < max_size; i++) {
+    for (const auto &pages : instance_pages) {
+      if (i < pages.size()) {
+        page_ids.push_back(pages[i]);
+      }
+    }
+  }
+  return page_ids;
+}
+
+size_t ParallelBufferPoolManager::WarmUp(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> instance_pages(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID) {
+      instance_pages[static_cast<uint32_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  size_t num_pages = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    num_pages += instances_[i]->WarmUp(instance_pages[i]);
+  }
+  return num_pages;
+}
+
+void ParallelBufferPoolManager::StartBackgroundWriter(size_t pages_per_round, std::chrono::milliseconds interval) {
+  for (auto *instance : instances_) {
+    instance->StartBackgroundWriter(pages_per_round, interval);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto *instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
+size_t ParallelBufferPoolManager::BackgroundWrite(size_t max_pages) {
+  size_t written = 0;
+  for (auto *instance : instances_) {
+    written += instance->BackgroundWrite(max_pages);
+  }
+  return written;
+}
+
+Page *ParallelBufferPoolManager::PrefetchPageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->PrefetchPageImpl(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPagesImpl() {
+  // flush all pages from all BufferPoolManagers
+  for (auto *instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+}  // namespace bustub
@@ -83,7 +83,7 @@ void InsertExecutor::insert_tuple_and_index(Tuple& tuple,RID* rid){
 
   // 插入table
   RID currRid;
-  table->InsertTuple(tuple,&currRid,txn_);
+  table->InsertTuple(tuple,&currRid,txn_,&bulk_write_strategy_);
   *rid = currRid;
 
   // 插入index
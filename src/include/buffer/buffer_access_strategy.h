@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** How an operation is going to access the pages it fetches. */
+enum class AccessType {
+  /** Regular access through the shared buffer pool. */
+  NORMAL,
+  /** Every page is read once, in order, e.g. by a TableIterator. */
+  SEQUENTIAL_SCAN,
+  /** Many pages are written once, in order, e.g. by an insert of many tuples. */
+  BULK_WRITE
+};
+
+/**
+ * BufferAccessStrategy is a hint an operation passes to BufferPoolManager::FetchPage/NewPage, like PostgreSQL's
+ * buffer access strategies.
+ *
+ * Pages a SEQUENTIAL_SCAN or BULK_WRITE operation has to read in are loaded into the frames of a small private ring,
+ * and once the ring is full every miss recycles the oldest frame of the ring instead of asking the replacer for a
+ * victim. A large scan therefore only ever occupies a ring-sized part of the pool, and the hot pages of everybody
+ * else stay resident. Hits are served from the shared pool as usual.
+ *
+ * The strategy holds per-operation state: every scan/insert creates its own and must not share it between threads.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+ public:
+  explicit BufferAccessStrategy(AccessType type) : type_(type) {
+    switch (type) {
+      case AccessType::SEQUENTIAL_SCAN:
+        ring_.resize(SEQUENTIAL_SCAN_RING_SIZE);
+        break;
+      case AccessType::BULK_WRITE:
+        ring_.resize(BULK_WRITE_RING_SIZE);
+        break;
+      case AccessType::NORMAL:
+      default:
+        break;
+    }
+  }
+
+  /** @return the access type of this strategy */
+  AccessType GetType() const { return type_; }
+
+  /** @return the page a bulk write appended to last, INVALID_PAGE_ID if none (cf. PostgreSQL's BulkInsertState) */
+  page_id_t GetCurrentPageId() const { return current_page_id_; }
+
+  /** Remember the page a bulk write appended to, so the next append does not have to walk the table from the start */
+  void SetCurrentPageId(page_id_t page_id) { current_page_id_ = page_id; }
+
+ private:
+  /** A frame this strategy loaded a page into. It may be recycled only if it still holds that page. */
+  struct RingSlot {
+    frame_id_t frame_id_ = -1;
+    page_id_t page_id_ = INVALID_PAGE_ID;
+  };
+
+  AccessType type_;
+  /** The private ring; the buffer pool manager uses at most a quarter of its frames of it. */
+  std::vector<RingSlot> ring_;
+  /** The ring slot that was filled last. */
+  size_t current_ = 0;
+  page_id_t current_page_id_ = INVALID_PAGE_ID;
+};
+
+}  // namespace bustub
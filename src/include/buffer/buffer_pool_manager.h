@@ -12,22 +12,92 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
 #include <list>
 // NOLINT 保证静态代码检查工具会略过该行
 #include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/page_extent.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/** Read-ahead counters of a buffer pool. */
+struct PrefetchStats {
+  /** Pages read in by the prefetcher. */
+  uint64_t prefetched_ = 0;
+  /** Prefetched pages that were fetched before they were evicted. */
+  uint64_t hits_ = 0;
+  /** Prefetched pages that were evicted or deleted without ever being fetched. */
+  uint64_t wasted_ = 0;
+};
+
+/** Counters of a buffer pool, sampled with BufferPoolManager::GetStats(). */
+struct BufferPoolStats {
+  /** Number of buckets of the latch wait histogram. */
+  static constexpr size_t LATCH_WAIT_BUCKETS = 16;
+
+  /** Fetches that found the page resident. */
+  uint64_t fetch_hits_ = 0;
+  /** Fetches that had to read the page from disk. */
+  uint64_t fetch_misses_ = 0;
+  /** Frames for new or fetched pages that were taken from the free list. */
+  uint64_t free_list_victims_ = 0;
+  /** Frames for new or fetched pages that were taken from the replacer. */
+  uint64_t replacer_victims_ = 0;
+  /** Frames for new or fetched pages that were recycled from the ring of an access strategy. */
+  uint64_t ring_victims_ = 0;
+  /** Dirty pages written back because their frame was reused. */
+  uint64_t eviction_writes_ = 0;
+  /** Pages written by FlushPage/FlushAllPages. */
+  uint64_t flush_writes_ = 0;
+  /** Dirty pages written by the background writer. */
+  uint64_t bgwriter_writes_ = 0;
+  /** Page writes of FlushPage/FlushAllPages/the background writer that failed. The pages are left dirty. */
+  uint64_t write_errors_ = 0;
+  /** Log flushes forced by evicting a dirty page whose LSN was not persistent yet. */
+  uint64_t forced_log_flushes_ = 0;
+  /**
+   * Histogram of the time spent waiting for the buffer pool latch. latch_wait_[0] counts acquisitions that did not
+   * wait, latch_wait_[1] waits shorter than 1us and latch_wait_[i] waits of [2^(i-2), 2^(i-1)) us; the last bucket
+   * also counts all longer waits.
+   */
+  std::array<uint64_t, LATCH_WAIT_BUCKETS> latch_wait_{};
+  /** Read-ahead counters. */
+  PrefetchStats prefetch_;
+
+  /** @return the fraction of fetches that found the page resident, 0 if there were no fetches */
+  double HitRatio() const;
+
+  /** Add the counters of another buffer pool. */
+  BufferPoolStats &operator+=(const BufferPoolStats &other);
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
 class BufferPoolManager {
+  // 预读线程属于最外层的 ParallelBufferPoolManager, 它需要调用分片的 PrefetchPageImpl
+  friend class ParallelBufferPoolManager;
+
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
@@ -37,13 +107,31 @@ class BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy used to pick victim frames
+   * @param max_pool_size how far GrowPool() can grow the buffer pool, 0 means it can not grow beyond pool_size
    */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                    ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK, size_t max_pool_size = 0);
+
+  /**
+   * Creates a new BufferPoolManager that is one shard of a ParallelBufferPoolManager.
+   * A shard only ever owns the page ids p with p % num_instances == instance_index.
+   * @param pool_size the size of this shard
+   * @param num_instances total number of shards
+   * @param instance_index index of this shard, in [0, num_instances)
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy used to pick victim frames
+   * @param max_pool_size how far GrowPool() can grow this shard, 0 means it can not grow beyond pool_size
+   */
+  BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index, DiskManager *disk_manager,
+                    LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK,
+                    size_t max_pool_size = 0);
 
   /**
    * Destroys an existing BufferPoolManager.
    */
-  ~BufferPoolManager();
+  virtual ~BufferPoolManager();
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
@@ -92,11 +180,171 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch the requested page on behalf of a scan or bulk write. On a miss the page is read into a frame of the
+   * strategy's private ring rather than a victim chosen by the replacer.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the calling operation
+   * @return the requested page
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy &strategy) { return FetchPageImpl(page_id, &strategy); }
+
+  /**
+   * Creates a new page on behalf of a bulk write, in a frame of the strategy's private ring.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy of the calling operation
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPage(page_id_t *page_id, BufferAccessStrategy &strategy) { return NewPageImpl(page_id, &strategy); }
+
+  /**
+   * Creates a new page of a table or index, taking the page id from the object's extent so that its pages are
+   * contiguous on disk.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the calling object
+   * @param strategy the access strategy, nullptr for normal access
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPage(page_id_t *page_id, PageExtent &extent, BufferAccessStrategy *strategy = nullptr) {
+    return NewPageImpl(page_id, &extent, strategy);
+  }
+
+  /**
+   * Deletes a page of a table or index; the next NewPage with the object's extent hands the page out again.
+   * @param page_id id of page to be deleted
+   * @param extent the extent of the calling object
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  bool DeletePage(page_id_t page_id, PageExtent &extent) {
+    const bool deleted = DeletePageImpl(page_id);
+    if (deleted) {
+      extent.FreePage(page_id);
+    }
+    return deleted;
+  }
+
+  /**
+   * Fetch several pages at once, e.g. all the children of a B+ tree node. Resident pages are pinned without the latch;
+   * the misses are loaded under a single acquisition of the latch, runs of consecutive pages with one vectored read
+   * each. A page listed twice is pinned twice.
+   * @param page_ids the pages to fetch
+   * @return the pinned pages, in the order of page_ids; nullptr for a page for which no frame was free
+   * @throws CorruptedPageException if a page read from disk does not match its checksum, no page is left pinned then
+   */
+  virtual std::vector<Page *> FetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Unpin several pages under a single acquisition of the latch.
+   * @param pages the pages to unpin, and whether each one was modified
+   * @return false if any of the pages was not resident or not pinned
+   */
+  virtual bool UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages);
+
+  /**
+   * Asynchronously read pages into the buffer pool, so that a later FetchPage finds them resident. The reads are done
+   * by background I/O threads; requests are dropped if the queue is full or no frame can be evicted.
+   * To read ahead along a linked list of pages (a table heap, the B+ tree leaf chain) pass chain_length > 1 and a
+   * function that returns the id of the page after a given page, it is called with the page read latched.
+   * @param page_id the first page to read
+   * @param chain_length how many pages of the chain starting at page_id to read
+   * @param next_page_id returns the next page of the chain, or INVALID_PAGE_ID at the end of the chain
+   */
+  void Prefetch(page_id_t page_id, size_t chain_length = 1, std::function<page_id_t(Page *)> next_page_id = nullptr);
+
+  /**
+   * Asynchronously read a list of pages into the buffer pool.
+   * @param page_ids the pages to read
+   */
+  void Prefetch(const std::vector<page_id_t> &page_ids);
+
+  /** @return how many pages sequential scans should read ahead, 0 disables read-ahead */
+  size_t GetPrefetchWindow() const { return prefetch_window_; }
+
+  /** Set how many pages sequential scans should read ahead, 0 disables read-ahead. */
+  void SetPrefetchWindow(size_t prefetch_window) { prefetch_window_ = prefetch_window; }
+
+  /** @return the read-ahead counters */
+  virtual PrefetchStats GetPrefetchStats();
+
+  /**
+   * Take a snapshot of the buffer pool counters. The counters are updated with relaxed atomics, so a snapshot taken
+   * under load is not one consistent point in time, but every event is counted exactly once across resets.
+   * @param reset true to also reset the counters (including the read-ahead counters) to 0
+   * @return the counters since the buffer pool was created or last reset
+   */
+  virtual BufferPoolStats GetStats(bool reset = false);
+
+  /**
+   * Start a background writer thread that periodically writes back the dirty, unpinned pages the replacer is going to
+   * evict next, so that the victims found by FetchPage/NewPage are almost always clean. A page is only written once
+   * the log records up to its LSN are persistent. Calling it again restarts the writer with the new settings.
+   * @param pages_per_round how many eviction candidates are examined per round
+   * @param interval how long the writer sleeps between rounds
+   */
+  virtual void StartBackgroundWriter(size_t pages_per_round = BGWRITER_PAGES_PER_ROUND,
+                                     std::chrono::milliseconds interval = bgwriter_interval);
+
+  /** Stop the background writer thread, if it is running. */
+  virtual void StopBackgroundWriter();
+
+  /**
+   * One round of the background writer: write back the dirty pages among the next eviction candidates.
+   * @param max_pages how many eviction candidates to examine
+   * @return the number of pages written; the pages that could not be written stay dirty, see write_errors_
+   */
+  virtual size_t BackgroundWrite(size_t max_pages);
+
+  /**
+   * Write the ids of the resident pages to a file, most recently used first, so that a restarted buffer pool can be
+   * warmed up with LoadResidentPages().
+   * @param file_name the file to write
+   * @return false if the file could not be written
+   */
+  bool SaveResidentPages(const std::string &file_name);
+
+  /**
+   * Warm up the buffer pool with the pages listed by SaveResidentPages(). As many of the most recently used pages as
+   * fit are read, sorted by page id so that runs of consecutive pages are read with one sequential read each.
+   * Call it before the buffer pool is used.
+   * @param file_name the file written by SaveResidentPages()
+   * @return the number of pages read, 0 if the file does not exist
+   */
+  size_t LoadResidentPages(const std::string &file_name);
+
+  /** @return the ids of the resident pages, most recently used first */
+  virtual std::vector<page_id_t> GetResidentPages();
+
+  /**
+   * Add frames to the buffer pool while it is in use. The memory of all max_pool_size frames is reserved up front,
+   * so growing only puts the next frames on the free list and no frame ever moves.
+   * @param num_frames how many frames to add
+   * @return the number of frames added, less than num_frames if the pool reached max_pool_size
+   */
+  virtual size_t GrowPool(size_t num_frames);
+
+  /**
+   * Remove frames from the buffer pool while it is in use. The frames with the highest ids are retired: their pages
+   * are evicted (dirty ones written back) and their memory is returned to the OS. A frame that is pinned or being
+   * read can not be retired, so shrinking stops there.
+   * @param num_frames how many frames to remove
+   * @return the number of frames removed
+   */
+  virtual size_t ShrinkPool(size_t num_frames);
+
   /** @return pointer to all the pages in the buffer pool */
-  Page *GetPages() { return pages_; }
+  virtual Page *GetPages() { return pages_; }
+
+  /**
+   * @param frame_id a frame of the buffer pool, less than GetPoolSize()
+   * @return the page held by the frame
+   */
+  virtual Page *GetFrame(size_t frame_id) { return &pages_[frame_id]; }
+
+  /** @return the maximum size GrowPool() can grow the buffer pool to */
+  virtual size_t GetMaxPoolSize() { return max_pool_size_; }
 
   /** @return size of the buffer pool */
-  size_t GetPoolSize() { return pool_size_; }
+  virtual size_t GetPoolSize() { return pool_size_; }
 
  protected:
   /**
@@ -116,8 +364,17 @@ class BufferPoolManager {
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
    * @return the requested page
+   * @throws CorruptedPageException if the page read from disk does not match its checksum, it is not cached then
+   */
+  virtual Page *FetchPageImpl(page_id_t page_id);
+
+  /**
+   * Fetch the requested page from the buffer pool, using an access strategy on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy, nullptr for normal access
+   * @return the requested page
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  virtual Page *FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy);
 
   /**
    * Unpin the target page from the buffer pool.
@@ -125,49 +382,243 @@ class BufferPoolManager {
    * @param is_dirty true if the page should be marked as dirty, false otherwise
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
-  bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
 
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
-   * @return false if the page could not be found in the page table, true otherwise
+   * @return false if the page could not be found in the page table or could not be written, true otherwise
    */
-  bool FlushPageImpl(page_id_t page_id);
+  virtual bool FlushPageImpl(page_id_t page_id);
 
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPageImpl(page_id_t *page_id);
+  virtual Page *NewPageImpl(page_id_t *page_id);
+
+  /**
+   * Creates a new page in the buffer pool, using an access strategy to find a frame.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy, nullptr for normal access
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPageImpl(page_id_t *page_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Creates a new page in the buffer pool, with the next page id of an extent.
+   * @param[out] page_id id of created page
+   * @param extent the extent the page id is taken from
+   * @param strategy the access strategy, nullptr for normal access
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPageImpl(page_id_t *page_id, PageExtent *extent, BufferAccessStrategy *strategy);
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
-  bool DeletePageImpl(page_id_t page_id);
+  virtual bool DeletePageImpl(page_id_t page_id);
+
+  /**
+   * Flushes all the pages in the buffer pool to disk. The pages that could not be written stay dirty, they are
+   * counted in BufferPoolStats::write_errors_.
+   */
+  virtual void FlushAllPagesImpl();
+
+  /**
+   * The body of UnpinPageImpl. Caller must hold latch_.
+   */
+  bool UnpinFrame(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Find a frame to hold a new page: from the strategy's ring if there is one, then from the free list and then from
+   * the replacer. A dirty victim is written back and removed from the page table. Caller must hold latch_.
+   * @param[out] frame_id id of the frame that can be reused
+   * @param strategy the access strategy of the caller, nullptr for normal access
+   * @return false if every frame is pinned
+   */
+  bool GetVictimFrame(frame_id_t *frame_id, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Create a page with an id that was allocated already, e.g. from an extent.
+   * @return the page pinned once, or nullptr if every frame is pinned
+   */
+  Page *NewPageWithId(page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /** Make frame_id a new, zeroed page page_id pinned once. The caller holds latch_. */
+  Page *InitNewPage(frame_id_t frame_id, page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Try to recycle the next frame of a strategy's ring. Caller must hold latch_.
+   * @param strategy a SEQUENTIAL_SCAN or BULK_WRITE strategy
+   * @param[out] frame_id the recycled frame
+   * @return false if the ring is not full yet or its next frame is in use
+   */
+  bool GetRingFrame(BufferAccessStrategy *strategy, frame_id_t *frame_id);
+
+  /**
+   * Record that a frame was filled with a page on behalf of a strategy, so that it can be recycled later.
+   */
+  void AddToRing(BufferAccessStrategy *strategy, frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Write back a page that is being evicted if it is dirty, and remove it from the page table.
+   * The frame must be claimed, i.e. its pin count is -1. Caller must hold latch_.
+   */
+  void EvictPage(Page *page);
+
+  /**
+   * Read a page into the buffer pool on behalf of the prefetcher, without holding latch_ during the disk read.
+   * The page is not counted as an access of the caller.
+   * @param page_id the page to read
+   * @return the page pinned once, or nullptr if every frame is pinned, the page is already being prefetched or it was
+   * deleted during the read
+   */
+  virtual Page *PrefetchPageImpl(page_id_t page_id);
+
+  /** Main loop of a prefetch thread. */
+  void PrefetchWorker();
+
+  /** Stop and join the prefetch threads. Must be called before the frames they use are destroyed. */
+  void StopPrefetchThreads();
+
+  /**
+   * Cancel the prefetch read of a page that is in flight, if any, so that the prefetcher drops what it read instead of
+   * putting it into the page table. Every path that loads, creates or deletes a page calls it under latch_: the read
+   * may have started before the page was last written back, its contents can be stale.
+   */
+  void CancelPrefetchRead(page_id_t page_id);
+
+  /**
+   * Read pages into free frames and make them evictable, the first page as the most recently used one.
+   * @param page_ids the pages to read, most recently used first
+   * @return the number of pages read
+   */
+  virtual size_t WarmUp(const std::vector<page_id_t> &page_ids);
+
+  /** Main loop of the background writer thread. */
+  void BackgroundWriterWorker(size_t pages_per_round, std::chrono::milliseconds interval);
+
+  /**
+   * Called after a fetch pinned a frame. Counts a prefetch hit if the frame was read by the prefetcher and not used
+   * since, and moves the frame into the ring of a scan strategy.
+   */
+  void OnPrefetchHit(frame_id_t frame_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Pin a frame that a lock-free page table lookup reported to hold page_id. Does not take latch_, and does not tell
+   * the replacer: a pinned frame stays in it, GetVictimFrame skips victims that are pinned.
+   * @param frame_id the frame returned by page_table_.Find()
+   * @param page_id the page that is expected to be in the frame
+   * @return false if the frame is being evicted or no longer holds page_id; the caller must retry under latch_
+   */
+  bool TryPinFrame(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Pin a resident frame so that it can be written back without latch_, like the background writer does: it can not
+   * be evicted or deleted until UnpinWrittenFrame. The replacer is not told, the frame keeps its place in it.
+   * @return false if the frame is free or being evicted
+   */
+  bool PinFrameForWrite(frame_id_t frame_id);
+
+  /** Release a pin of PinFrameForWrite. */
+  void UnpinWrittenFrame(frame_id_t frame_id);
+
+  /**
+   * Copy the data of a pinned page to be written back, under its read latch so that the copy (and the checksum the
+   * disk manager stamps into it) is never torn by a concurrent writer. Clears the dirty flag: a change after the copy
+   * marks the page dirty again when it is unpinned. Do not hold latch_, a writer may wait for it under the page latch.
+   */
+  void CopyPageForWrite(Page *page, char *data);
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Acquire latch_, and record in the latch wait histogram how long that took.
+   * @return the held latch
    */
-  void FlushAllPagesImpl();
+  std::unique_lock<std::mutex> LockLatch();
 
-  /** Number of pages in the buffer pool. */
-  size_t pool_size_;
+  /**
+   * Allocate a page id owned by this instance. Caller must hold latch_.
+   * @return the allocated page id
+   */
+  page_id_t AllocatePage();
+
+  /** Number of pages in the buffer pool, frames [0, pool_size_) are in use. Only changed under latch_. */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames the buffer pool was allocated for, frames [pool_size_, max_pool_size_) are retired. */
+  const size_t max_pool_size_;
+  /** How many instances are in the parallel BPM (1 if this BPM is used on its own). */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPM instance in the parallel BPM. */
+  const uint32_t instance_index_ = 0;
+  /** Memory of the frames: page aligned page data, and the Page metadata in a separate array. */
+  FrameArena frame_arena_;
   /** Array of buffer pool pages. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages. Lookups are lock-free, updates are protected by latch_. */
+  PageTable page_table_;
   /** Replacer to find unpinned pages for replacement. replacer管理的是可以被置换出去的frame(_id), 是page_table_对应 page 的子集 */
   Replacer *replacer_;
   /** List of free pages. frame_id_t 只是在pages_[] 这个buffer中的编号,并非真正物理页号 */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** A pending read-ahead request. */
+  struct PrefetchRequest {
+    page_id_t page_id_ = INVALID_PAGE_ID;
+    size_t chain_length_ = 0;
+    std::function<page_id_t(Page *)> next_page_id_;
+  };
+
+  /** Pages waiting to be read by the prefetch threads. */
+  std::deque<PrefetchRequest> prefetch_queue_;
+  /** Background threads doing the read-ahead, started on the first Prefetch() call. */
+  std::vector<std::thread> prefetch_threads_;
+  bool prefetch_shutdown_ = false;
+  /** Protects prefetch_queue_, prefetch_threads_ and prefetch_shutdown_. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  /**
+   * Pages being read by PrefetchPageImpl without latch_, protected by latch_. CancelPrefetchRead sets the flag to
+   * cancel the read, so that a stale or deleted page is not put into the page table.
+   */
+  std::unordered_map<page_id_t, bool> prefetch_reads_;
+  std::atomic<size_t> prefetch_window_{PREFETCH_WINDOW};
+  /** prefetched_[i] is true if frame i was read by the prefetcher and has not been fetched since. */
+  std::atomic<bool> *prefetched_;
+  std::atomic<uint64_t> prefetched_count_{0};
+  std::atomic<uint64_t> prefetch_hits_{0};
+  std::atomic<uint64_t> prefetch_wasted_{0};
+
+  /** The background writer thread, not joinable if it is not running. */
+  std::thread bgwriter_thread_;
+  bool bgwriter_shutdown_ = false;
+  /** Protects bgwriter_thread_ and bgwriter_shutdown_. */
+  std::mutex bgwriter_latch_;
+  std::condition_variable bgwriter_cv_;
+
+  /** Counters reported by GetStats(), see BufferPoolStats. */
+  std::atomic<uint64_t> fetch_hits_{0};
+  std::atomic<uint64_t> fetch_misses_{0};
+  std::atomic<uint64_t> free_list_victims_{0};
+  std::atomic<uint64_t> replacer_victims_{0};
+  std::atomic<uint64_t> ring_victims_{0};
+  std::atomic<uint64_t> eviction_writes_{0};
+  std::atomic<uint64_t> flush_writes_{0};
+  std::atomic<uint64_t> bgwriter_writes_{0};
+  std::atomic<uint64_t> write_errors_{0};
+  std::atomic<uint64_t> forced_log_flushes_{0};
+  std::array<std::atomic<uint64_t>, BufferPoolStats::LATCH_WAIT_BUCKETS> latch_wait_{};
+
+  /**
+   * This latch protects page_table_ updates, free_list_ and frame loading/eviction.
+   * The fetch-hit path only touches the page table and the atomic pin count of a frame, so it never takes it.
+   */
   std::mutex latch_;
 };
 }  // namespace bustub
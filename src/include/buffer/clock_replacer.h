@@ -12,8 +12,7 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +22,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame has one atomic byte holding its evictable bit and its reference bit, and the clock hand is an atomic
+ * counter. Pin/Unpin are single atomic bit flips and Victim sweeps with CAS, so no operation takes a lock.
+ * 理解: 与 LRUReplacer 不同, 这里不需要在 Unpin/Pin 时分配/释放链表节点, 也没有全局的 latch_.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -45,8 +48,21 @@ class ClockReplacer : public Replacer {
 
   size_t Size() override;
 
+  std::vector<frame_id_t> GetVictimCandidates(size_t max_count) override;
+
  private:
-  // TODO(student): implement me!
+  /** The frame may be evicted, i.e. its pin count is 0. */
+  static constexpr uint8_t EVICTABLE = 1;
+  /** The frame was unpinned since the clock hand last passed it. */
+  static constexpr uint8_t REFERENCED = 2;
+
+  size_t num_pages_;
+  /** Evictable and reference bits of every frame, indexed by frame id. */
+  std::atomic<uint8_t> *frames_;
+  /** Position of the clock hand, taken modulo num_pages_. */
+  std::atomic<size_t> clock_hand_{0};
+  /** Number of evictable frames. Signed: a racing Victim can decrement it before Unpin increments it. */
+  std::atomic<int64_t> size_{0};
 };
 
 }  // namespace bustub
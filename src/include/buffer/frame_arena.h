@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the memory of a buffer pool's frames.
+ *
+ * The page data of all frames is one contiguous, PAGE_SIZE aligned region mapped with mmap. It is backed by explicit
+ * huge pages (MAP_HUGETLB) when the system has them reserved, otherwise transparent huge pages are requested with
+ * madvise, and if that is not supported either it stays on regular pages. Fewer TLB entries cover a large pool, and
+ * the alignment is what direct I/O needs. Physical memory is only committed when a frame is first touched, so a buffer
+ * pool can allocate the arena for its maximum size and grow into it.
+ *
+ * The Page objects (pin count, dirty flag, latch) live in a separate array. Page is cache line aligned, so latching
+ * or pinning one frame does not invalidate the cache lines of its neighbours or of any page data.
+ */
+class FrameArena {
+ public:
+  /**
+   * Allocate the frames, every frame is zeroed.
+   * @param num_frames the number of frames
+   */
+  explicit FrameArena(size_t num_frames);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the frames, num_frames Page objects */
+  Page *GetPages() { return pages_; }
+
+  /** @return the start of the page data region, frame i's data starts at i * PAGE_SIZE */
+  char *GetData() { return data_; }
+
+  /**
+   * Give the memory of some frames back to the OS, e.g. when the buffer pool shrinks. The frames stay mapped, and
+   * read as zero when they are used again.
+   * @param first_frame the first frame to release
+   * @param num_frames how many frames to release
+   */
+  void Release(size_t first_frame, size_t num_frames);
+
+  /** @return true if the page data is backed by explicit huge pages */
+  bool IsHugePageBacked() const { return huge_pages_; }
+
+ private:
+  size_t num_frames_;
+  /** Length of the mapping, the data size rounded up to the page or huge page size. */
+  size_t mapped_size_ = 0;
+  char *data_ = nullptr;
+  bool huge_pages_ = false;
+  Page *pages_ = nullptr;
+};
+
+}  // namespace bustub
@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy (O'Neil et al., SIGMOD '93).
+ *
+ * It keeps the timestamps of the last K uncorrelated references of every frame and evicts the evictable frame whose
+ * backward K-distance (now - time of its K-th most recent reference) is the largest. Frames with fewer than K
+ * references have an infinite backward K-distance and are evicted first, oldest reference first, so a page that a
+ * sequential scan touched once goes before a B+ tree inner page that is referenced over and over.
+ *
+ * References to a frame within correlated_period of its previous reference are correlated (e.g. a scan fetching the
+ * same page once per tuple) and count as one reference. A frame is not evicted while it is inside its correlated
+ * period unless every evictable frame is.
+ *
+ * Timestamps are a logical clock advanced by RecordAccess(), so periods are measured in buffer pool accesses.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of references remembered per frame
+   * @param correlated_period references closer than this to the previous one are correlated
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        uint64_t correlated_period = LRUK_CORRELATED_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  std::vector<frame_id_t> GetVictimCandidates(size_t max_count) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+ private:
+  /** Reference history of one frame. */
+  struct FrameHistory {
+    /** Times of the last (at most K) uncorrelated references, most recent first. */
+    std::vector<uint64_t> history_;
+    /** Time of the last reference, correlated or not. */
+    uint64_t last_ = 0;
+    bool evictable_ = false;
+  };
+
+  /**
+   * Eviction order of evictable frames: (has K references, time of the K-th / oldest reference, frame id).
+   * Smaller keys are evicted first.
+   */
+  using EvictKey = std::pair<std::pair<bool, uint64_t>, frame_id_t>;
+
+  EvictKey MakeKey(frame_id_t frame_id) const;
+
+  const size_t k_;
+  const uint64_t correlated_period_;
+  /** Logical clock, advanced once per RecordAccess(). */
+  uint64_t current_timestamp_ = 0;
+  std::vector<FrameHistory> frames_;
+  /** Evictable frames ordered by EvictKey. */
+  std::set<EvictKey> evictable_;
+  /** Protects all the members above. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -47,6 +47,11 @@ class LRUReplacer : public Replacer {
 
   size_t Size() override;
 
+  /** Moves a frame that is in the list to its end, the page was just used. */
+  void RecordAccess(frame_id_t frame_id) override;
+
+  std::vector<frame_id_t> GetVictimCandidates(size_t max_count) override;
+
  private:
   // 基本思路: 双向链表+hash实现LRU , 链表头部的是最近最久未使用的
   // TODO(student): implement me!
@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/mmap_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * MmapBufferPoolManager serves a database file read-only, e.g. on a reporting replica. The file is mapped into memory
+ * and FetchPage returns a Page whose data points into the mapping: there are no frames, nothing is copied and nothing
+ * is ever evicted, the OS page cache holds the pages. Opening the file costs no I/O and no memory for frames, a page
+ * is read from disk by the page fault of its first access.
+ *
+ * The mapping is read-only: NewPage and DeletePage fail, and an unpin that marks the page dirty is rejected.
+ * The checksum of a page is verified on its first fetch. Only the database file (the default tablespace) is mapped.
+ *
+ * The access hints of the callers become madvise() hints: a fetch with a SEQUENTIAL_SCAN strategy marks the extent of
+ * the page MADV_SEQUENTIAL (aggressive read-ahead, pages are dropped early), and Prefetch() marks the pages
+ * MADV_WILLNEED and touches them on the prefetch threads.
+ */
+class MmapBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Map a database file. Pages written to the file afterwards are not visible beyond its size at this point.
+   * @param db_file the database file, written by a DiskManager
+   * @throws Exception if the file can not be opened or mapped
+   */
+  explicit MmapBufferPoolManager(const std::string &db_file);
+
+  /**
+   * Unmap the file. No page may be in use any more.
+   */
+  ~MmapBufferPoolManager() override;
+
+  /** @return the number of pages of the mapped file */
+  size_t GetNumPages() const { return num_pages_; }
+
+  /** Fetch the pages one by one, nothing has to be read. */
+  std::vector<Page *> FetchPages(const std::vector<page_id_t> &page_ids) override;
+
+  /** Unpin the pages one by one. */
+  bool UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) override;
+
+ protected:
+  /**
+   * Pin a page of the mapping.
+   * @param page_id id of page to be fetched
+   * @return the requested page, nullptr if it is beyond the end of the file
+   * @throws CorruptedPageException if the page does not match its checksum
+   */
+  Page *FetchPageImpl(page_id_t page_id) override;
+
+  /**
+   * Pin a page of the mapping. A SEQUENTIAL_SCAN strategy marks the extent of the page for sequential access.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy, nullptr for normal access
+   * @return the requested page, nullptr if it is beyond the end of the file
+   * @throws CorruptedPageException if the page does not match its checksum
+   */
+  Page *FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Unpin a page. The page can not have been modified, the mapping is read-only.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty must be false
+   * @return false if the page pin count is <= 0 before this call or is_dirty is true (the page is unpinned then)
+   */
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  /** @return false, there is never anything to flush */
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  /** @return nullptr, pages can not be created */
+  Page *NewPageImpl(page_id_t *page_id) override;
+
+  /** @return nullptr, pages can not be created */
+  Page *NewPageImpl(page_id_t *page_id, BufferAccessStrategy *strategy) override;
+
+  /** @return nullptr, pages can not be created */
+  Page *NewPageImpl(page_id_t *page_id, PageExtent *extent, BufferAccessStrategy *strategy) override;
+
+  /** @return false, pages can not be deleted */
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  /** Nothing to flush. */
+  void FlushAllPagesImpl() override {}
+
+  /**
+   * Ask the OS to read a page in the background (MADV_WILLNEED), on behalf of the prefetch threads. The checksum is
+   * verified by the first FetchPage of the page, not here.
+   * @param page_id the page to read
+   * @return the page pinned once, or nullptr if it is beyond the end of the file
+   */
+  Page *PrefetchPageImpl(page_id_t page_id) override;
+
+  /**
+   * Ask the OS to read the pages in the background (MADV_WILLNEED).
+   * @param page_ids the pages to read
+   * @return the number of pages of the file among them
+   */
+  size_t WarmUp(const std::vector<page_id_t> &page_ids) override;
+
+ private:
+  /**
+   * @return the Page of page_id, created together with the other Page objects of its extent on first use; nullptr if
+   * page_id is not a page of the file
+   */
+  Page *GetPage(page_id_t page_id);
+
+  /** madvise() the pages [page_id, page_id + num_pages). */
+  void Advise(page_id_t page_id, size_t num_pages, int advice);
+
+  int fd_ = -1;
+  /** The mapped file, nullptr if it is empty. */
+  char *data_ = nullptr;
+  size_t num_pages_ = 0;
+  /** The Page objects of the extents, extent_pages_[i] holds the pages [i * EXTENT_SIZE, (i + 1) * EXTENT_SIZE). */
+  std::unique_ptr<std::atomic<Page *>[]> extent_pages_;
+  /** Protects the creation of extent_pages_[i]. */
+  std::mutex extent_latch_;
+  /** sequential_[i] is true once extent i was marked MADV_SEQUENTIAL. */
+  std::unique_ptr<std::atomic<bool>[]> sequential_;
+  /** verified_[page_id] is true once the checksum of the page was verified. */
+  std::unique_ptr<std::atomic<bool>[]> verified_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the page ids resident in a buffer pool to their frame ids.
+ *
+ * It is a fixed-capacity open addressing hash table (linear probing) sized from the pool size, so it never allocates
+ * after construction. Every slot is one 8-byte atomic word holding (page_id, frame_id), eight slots per cache line.
+ *
+ * Find() is lock-free and may run concurrently with Insert()/Remove(). Insert()/Remove() must be serialized by the
+ * caller (the buffer pool manager latch). A concurrent Find() can miss an entry that is being moved by Remove(), or
+ * return a mapping that was just removed, so the caller has to validate the frame it gets back and fall back to a
+ * lookup under the latch on a miss.
+ * 理解: 删除使用 backward shift 而不是墓碑, 所以表中永远不会堆积墓碑, 探测长度只取决于当前的装载率(<= 50%).
+ */
+class PageTable {
+ public:
+  /**
+   * Creates a new PageTable.
+   * @param num_frames the maximum number of entries, i.e. the number of frames of the buffer pool
+   */
+  explicit PageTable(size_t num_frames);
+
+  ~PageTable();
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Look up the frame holding a page. Lock-free.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame that held page_id at the time of the lookup
+   * @return true if page_id was found
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const;
+
+  /**
+   * Insert or overwrite the mapping page_id -> frame_id. Caller must serialize writers.
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Remove the mapping of page_id. Caller must serialize writers.
+   * @return false if page_id was not in the table
+   */
+  bool Remove(page_id_t page_id);
+
+  /** @return the number of entries in the table. Caller must serialize writers. */
+  size_t Size() const { return size_; }
+
+ private:
+  /** Slot value of an empty slot; INVALID_PAGE_ID is never inserted, so it can not collide with a real entry. */
+  static constexpr uint64_t EMPTY_SLOT = ~static_cast<uint64_t>(0);
+
+  static uint64_t MakeEntry(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static page_id_t EntryPageId(uint64_t entry) { return static_cast<page_id_t>(entry >> 32); }
+  static frame_id_t EntryFrameId(uint64_t entry) { return static_cast<frame_id_t>(entry & 0xFFFFFFFF); }
+
+  /** @return the home slot of page_id (Fibonacci hashing: sharded page ids are strided, so do not just mask) */
+  size_t HomeSlot(page_id_t page_id) const {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               shift_);
+  }
+
+  /** @return the slot holding page_id, or capacity_ if it is not in the table. Caller must serialize writers. */
+  size_t FindSlot(page_id_t page_id) const;
+
+  /** Number of slots, a power of two >= 2 * num_frames. */
+  size_t capacity_;
+  /** capacity_ - 1. */
+  size_t mask_;
+  /** 64 - log2(capacity_). */
+  uint32_t shift_;
+  /** Number of entries. */
+  size_t size_ = 0;
+  std::atomic<uint64_t> *slots_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager splits the buffer pool into num_instances independent BufferPoolManager shards.
+ * A page always lives in shard page_id % num_instances, and every shard has its own latch, page table, free list
+ * and replacer, so threads that touch pages of different shards never contend with each other.
+ * 对外的接口与 BufferPoolManager 完全一致, 因而可以直接替换 BufferPoolManager 使用.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of shards, e.g. the number of cores
+   * @param pool_size the size of each shard
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy of every shard
+   * @param max_pool_size how far GrowPool() can grow each shard, 0 means the shards can not grow beyond pool_size
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK,
+                            size_t max_pool_size = 0);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager and all of its shards.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @return the number of shards */
+  size_t GetNumInstances() const { return instances_.size(); }
+
+  /**
+   * @param page_id id of page
+   * @return pointer to the shard that is responsible for page_id
+   */
+  BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
+
+  /** Fetch the pages of every shard with one FetchPages call per shard. */
+  std::vector<Page *> FetchPages(const std::vector<page_id_t> &page_ids) override;
+
+  /** Unpin the pages of every shard with one UnpinPages call per shard. */
+  bool UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) override;
+
+  /** @return the read-ahead counters summed over all shards */
+  PrefetchStats GetPrefetchStats() override;
+
+  /** @return the counters summed over all shards */
+  BufferPoolStats GetStats(bool reset = false) override;
+
+  /**
+   * @param reset true to also reset the counters of every shard
+   * @return the counters of every shard, the i-th entry is the shard that owns the page ids p % num_instances == i
+   */
+  std::vector<BufferPoolStats> GetInstanceStats(bool reset = false);
+
+  /** @return the resident pages of all BufferPoolManagers, interleaved so that the most recent pages come first */
+  std::vector<page_id_t> GetResidentPages() override;
+
+  /** Start a background writer in every BufferPoolManager, each one examines pages_per_round of its own pages. */
+  void StartBackgroundWriter(size_t pages_per_round = BGWRITER_PAGES_PER_ROUND,
+                             std::chrono::milliseconds interval = bgwriter_interval) override;
+
+  /** Stop the background writers of all BufferPoolManagers. */
+  void StopBackgroundWriter() override;
+
+  /** One background writer round in every BufferPoolManager. */
+  size_t BackgroundWrite(size_t max_pages) override;
+
+  /** Grow the shards by num_frames in total, spread evenly over them. */
+  size_t GrowPool(size_t num_frames) override;
+
+  /** Shrink the shards by up to num_frames in total, spread evenly over them. */
+  size_t ShrinkPool(size_t num_frames) override;
+
+  /** The frames live in the shards, there is no array of all the pages: always nullptr, use GetFrame() instead. */
+  Page *GetPages() override;
+
+  /**
+   * @param frame_id a frame of the buffer pool, less than GetPoolSize()
+   * @return the page held by the frame, the frames of shard 0 are numbered first, then those of shard 1 and so on
+   */
+  Page *GetFrame(size_t frame_id) override;
+
+  /** @return the sum of the maximum sizes of the shards */
+  size_t GetMaxPoolSize() override;
+
+  /** @return the sum of the sizes of the shards */
+  size_t GetPoolSize() override;
+
+ protected:
+  /**
+   * Fetch the requested page from the shard responsible for it.
+   * @param page_id id of page to be fetched
+   * @return the requested page
+   */
+  Page *FetchPageImpl(page_id_t page_id) override;
+
+  /**
+   * Fetch the requested page from the shard responsible for it, using an access strategy on a miss.
+   * A ring slot that a different shard filled is simply refilled by the shard that misses on it.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy, nullptr for normal access
+   * @return the requested page
+   */
+  Page *FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Unpin the target page from the shard responsible for it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  /**
+   * Flushes the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  /**
+   * Creates a new page. Shards are tried round-robin, starting from a different shard on every call, so that
+   * newly allocated pages are spread evenly over the shards.
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageImpl(page_id_t *page_id) override;
+
+  /**
+   * Creates a new page round-robin like NewPageImpl(page_id), using an access strategy to find a frame.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy, nullptr for normal access
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageImpl(page_id_t *page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Creates a new page with the next page id of an extent, in the shard that owns that page id.
+   * @param[out] page_id id of created page
+   * @param extent the extent the page id is taken from
+   * @param strategy the access strategy, nullptr for normal access
+   * @return nullptr if the shard could not create the page, otherwise pointer to new page
+   */
+  Page *NewPageImpl(page_id_t *page_id, PageExtent *extent, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Deletes a page from the shard responsible for it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  /**
+   * Flushes all the pages of every shard to disk.
+   */
+  void FlushAllPagesImpl() override;
+
+  /**
+   * Read a page into the shard responsible for it on behalf of the prefetch threads of this manager.
+   * @param page_id the page to read
+   * @return the page pinned once, or nullptr if every frame of the shard is pinned
+   */
+  Page *PrefetchPageImpl(page_id_t page_id) override;
+
+  /**
+   * Warm up every BufferPoolManager with the pages it owns.
+   * @param page_ids the pages to read, most recently used first
+   * @return the number of pages read
+   */
+  size_t WarmUp(const std::vector<page_id_t> &page_ids) override;
+
+ private:
+  /** The shards, instances_[i] owns the page ids p with p % instances_.size() == i. */
+  std::vector<BufferPoolManager *> instances_;
+  /** The shard NewPageImpl starts searching from on the next call. */
+  std::atomic<size_t> next_instance_{0};
+};
+
+}  // namespace bustub
@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** Replacement policies a BufferPoolManager can be created with. */
+enum class ReplacerPolicy { LRU, CLOCK, LRU_K };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -25,7 +30,8 @@ class Replacer {
   virtual ~Replacer() = default;
 
   /**
-   * Remove the victim frame as defined by the replacement policy.
+   * Remove the victim frame as defined by the replacement policy. The BufferPoolManager does not call Pin when it pins
+   * a page, so the victim may be in use: the caller skips it, and Unpin adds it back once it is unpinned.
    * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
    * @return true if a victim frame was found, false otherwise
    */
@@ -45,6 +51,26 @@ class Replacer {
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * Records that the page held by a frame was accessed. Policies that only look at pin/unpin order ignore it.
+   * @param frame_id the id of the accessed frame
+   */
+  virtual void RecordAccess(frame_id_t frame_id) {}
+
+  /**
+   * Forgets everything about a frame whose page was deleted, so that the next page loaded into it starts fresh.
+   * @param frame_id the id of the frame
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Looks ahead of the replacement policy without changing its state, used by the background writer to clean the
+   * pages that are about to be evicted.
+   * @param max_count the maximum number of frames to return
+   * @return the frames that would be victimized next, next victim first
+   */
+  virtual std::vector<frame_id_t> GetVictimCandidates(size_t max_count) { return {}; }
 };
 
 }  // namespace bustub
@@ -78,9 +78,11 @@ class Catalog {
    * @param txn the transaction in which the table is being created
    * @param table_name the name of the new table
    * @param schema the schema of the new table
+   * @param tablespace_id the tablespace the pages of the table are stored in (see DiskManager::CreateTablespace)
    * @return a pointer to the metadata of the new table
    */
-  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
+  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                             tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID) {
     BUSTUB_ASSERT(names_.count(table_name) == 0, "Table names should be unique!");
     table_oid_t oid = next_table_oid_;
     next_table_oid_++;
@@ -88,7 +90,7 @@ class Catalog {
     // TODO:TableMetadata 中的 TableHeap成员如何解决 ? 如何知道 first_page_id_ ?
     // tables_[oid] = std::make_unique<TableMetadata>(schema,table_name,nullptr,oid);
     // fix 2022.5.10: TableHeap有两个构造函数,直接使用不含参数 first_page_id_ 的构造函数
-    std::unique_ptr<TableHeap> tableHeap(new TableHeap(bpm_,lock_manager_, log_manager_,txn));
+    std::unique_ptr<TableHeap> tableHeap(new TableHeap(bpm_,lock_manager_, log_manager_,txn,tablespace_id));
     tables_[oid] = std::make_unique<TableMetadata>(schema,table_name,std::move(tableHeap),oid);
     return tables_[oid].get();
   }
@@ -115,13 +117,14 @@ class Catalog {
    * @param key_schema the schema of the key
    * @param key_attrs key attributes,key中的各attr 在table schema中是第几个attr
    * @param keysize size of the key
+   * @param tablespace_id the tablespace the pages of the index are stored in, need not be the one of the table
    * @return a pointer to the metadata of the new table
    * 记得将数据表中的内容,添加到B+树索引中...
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
-                         size_t keysize) {
+                         size_t keysize, tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID) {
     BUSTUB_ASSERT(names_.count(table_name) > 0, "input table name does not exist!");
     index_oid_t oid = next_index_oid_;
     next_index_oid_++;
@@ -141,7 +144,8 @@ class Catalog {
     // std::unique_ptr<Index> index(new Index(meta_data));     
     // indexes_[oid] = std::make_unique<IndexInfo>(key_schema,index_name,index,oid,table_name,keysize);
     // fix 2022.5.10: 本文使用的B+树索引,应该直接创建对应的具体索引!!!
-    std::unique_ptr<Index> bpTree_index(new BPlusTreeIndex<KeyType,ValueType,KeyComparator>(metadata,bpm_));
+    std::unique_ptr<Index> bpTree_index(
+        new BPlusTreeIndex<KeyType,ValueType,KeyComparator>(metadata,bpm_,tablespace_id));
     // 为数据表(table_name) 中的数据创建索引(根据key_schema),将索引信息添加到B+树中;
     TableHeap* tableHeap = GetTable(table_name)->table_.get();
     for(auto it=tableHeap->Begin(txn); it!=tableHeap->End(); it++){
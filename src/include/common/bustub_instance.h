@@ -23,29 +23,45 @@ namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * @param db_file_name the database file
+   * @param warm_start if true, the resident page set of the buffer pool is saved to <db name>.warm at every
+   * checkpoint and at shutdown, and reloaded from it here before the instance is used
+   * @param io_engine the engine of the asynchronous disk I/O (checkpoints, background writes, batched reads)
+   * @param direct_io if true, the database file bypasses the OS page cache, see DiskManager
+   */
+  explicit BustubInstance(const std::string &db_file_name, bool warm_start = false,
+                          IOEngineType io_engine = IOEngineType::IO_URING, bool direct_io = false) {
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, io_engine, direct_io);
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
     buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    if (warm_start) {
+      warm_start_file_ = db_file_name.substr(0, db_file_name.rfind('.')) + ".warm";
+      buffer_pool_manager_->LoadResidentPages(warm_start_file_);
+    }
 
     // txn related
     lock_manager_ = new LockManager();
     transaction_manager_ = new TransactionManager(lock_manager_, log_manager_);
 
     // checkpoints
-    checkpoint_manager_ = new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_);
+    checkpoint_manager_ =
+        new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_, warm_start_file_);
   }
 
   ~BustubInstance() {
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
+    if (!warm_start_file_.empty()) {
+      buffer_pool_manager_->SaveResidentPages(warm_start_file_);
+    }
     delete checkpoint_manager_;
     delete log_manager_;
     delete buffer_pool_manager_;
@@ -60,6 +76,8 @@ class BustubInstance {
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
   CheckpointManager *checkpoint_manager_;
+  /** Where the resident page set is saved, empty if warm start is disabled. */
+  std::string warm_start_file_;
 };
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
 namespace bustub {
@@ -27,20 +28,45 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The background writer of a buffer pool wakes up every BGWRITER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds bgwriter_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
 static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int PAGE_CHECKSUM_SIZE = 4;                                  // crc32c trailer of every page
+static constexpr int PAGE_DATA_SIZE = PAGE_SIZE - PAGE_CHECKSUM_SIZE;         // page bytes before the trailer
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
+static constexpr int CACHE_LINE_SIZE = 64;                                    // size of a cpu cache line in byte
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;                     // size of an os huge page in byte
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;                                     // lookback window of lru-k replacer
+static constexpr int LRUK_CORRELATED_PERIOD = 16;                             // lru-k correlated period, in accesses
+static constexpr int SEQUENTIAL_SCAN_RING_SIZE = 32;                          // sequential scan ring size, in pages
+static constexpr int BULK_WRITE_RING_SIZE = 128;                              // bulk write ring size, in pages
+static constexpr int PREFETCH_WINDOW = 4;                                     // default read-ahead window, in pages
+static constexpr int PREFETCH_THREADS = 2;                                    // read-ahead i/o threads per buffer pool
+static constexpr int PREFETCH_QUEUE_SIZE = 256;                               // pending read-ahead requests
+static constexpr int BGWRITER_PAGES_PER_ROUND = 16;                           // max pages written per bgwriter round
+static constexpr int WARM_START_BATCH_SIZE = 32;                              // max pages per warm-start read
+static constexpr int FLUSH_BATCH_SIZE = 64;                                   // max pages per write-combined flush
+static constexpr int PIN_BATCH_SIZE = 16;                                     // max pages pinned per FetchPages batch
+static constexpr int IO_QUEUE_DEPTH = 64;                                     // max async i/o requests in flight
+static constexpr int IO_THREADS = 4;                                          // i/o threads of the thread pool engine
+static constexpr int EXTENT_SIZE = 64;                                        // pages per table/index extent
+static constexpr int TABLESPACE_PAGE_BITS = 24;                               // page number bits, other tablespaces
+static constexpr int MAX_TABLESPACES = 1 << (31 - TABLESPACE_PAGE_BITS);      // including the default tablespace
+static constexpr int DEFAULT_TABLESPACE_ID = 0;                               // the tablespace of the database file
 
-using frame_id_t = int32_t;    // frame id type
-using page_id_t = int32_t;     // page id type
-using txn_id_t = int32_t;      // transaction id type
-using lsn_t = int32_t;         // log sequence number type
-using slot_offset_t = size_t;  // slot offset type
+using frame_id_t = int32_t;       // frame id type
+using page_id_t = int32_t;        // page id type
+using txn_id_t = int32_t;         // transaction id type
+using lsn_t = int32_t;            // log sequence number type
+using slot_offset_t = size_t;     // slot offset type
 using oid_t = uint16_t;
+using tablespace_id_t = int32_t;  // tablespace id type
 
 }  // namespace bustub
@@ -19,6 +19,7 @@
 #include <stdexcept>
 #include <string>
 
+#include "common/config.h"
 #include "type/type.h"
 
 namespace bustub {
@@ -47,6 +48,8 @@ enum class ExceptionType {
   OUT_OF_MEMORY = 9,
   /** Method not implemented. */
   NOT_IMPLEMENTED = 11,
+  /** A page read from disk does not match its checksum. */
+  CORRUPTED_PAGE = 12,
 };
 
 class Exception : public std::runtime_error {
@@ -85,6 +88,8 @@ class Exception : public std::runtime_error {
         return "Out of Memory";
       case ExceptionType::NOT_IMPLEMENTED:
         return "Not implemented";
+      case ExceptionType::CORRUPTED_PAGE:
+        return "Corrupted page";
       default:
         return "Unknown";
     }
@@ -100,4 +105,18 @@ class NotImplementedException : public Exception {
   explicit NotImplementedException(const std::string &msg) : Exception(ExceptionType::NOT_IMPLEMENTED, msg) {}
 };
 
+class CorruptedPageException : public Exception {
+ public:
+  CorruptedPageException() = delete;
+  explicit CorruptedPageException(page_id_t page_id)
+      : Exception(ExceptionType::CORRUPTED_PAGE, "checksum mismatch on page " + std::to_string(page_id)),
+        page_id_(page_id) {}
+
+  /** @return the page that failed its checksum */
+  page_id_t GetPageId() const { return page_id_; }
+
+ private:
+  page_id_t page_id_;
+};
+
 }  // namespace bustub
@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.h
+//
+// Identification: src/include/common/util/crc32c.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Crc32cUtil computes CRC-32C (Castagnoli), the checksum of the database pages. It uses the crc32 instruction of
+ * SSE4.2 (or of ARMv8) when the build targets it, and a table driven slice-by-8 implementation otherwise.
+ */
+class Crc32cUtil {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param size the number of bytes
+   * @param crc the checksum of the preceding bytes, to checksum data in pieces
+   * @return the checksum of the preceding bytes followed by data
+   */
+  static uint32_t Crc32c(const char *data, size_t size, uint32_t crc = 0);
+
+  /** The table driven implementation, the same result as Crc32c on every platform. */
+  static uint32_t Crc32cPortable(const char *data, size_t size, uint32_t crc = 0);
+
+  /** @return true if Crc32c uses a crc32 instruction */
+  static bool IsHardwareAccelerated();
+};
+
+}  // namespace bustub
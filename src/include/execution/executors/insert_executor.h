@@ -15,6 +15,7 @@
 #include <memory>
 #include <utility>
 
+#include "buffer/buffer_access_strategy.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/executors/seq_scan_executor.h"
@@ -65,5 +66,7 @@ class InsertExecutor : public AbstractExecutor {
   TableMetadata* table_info_;
   Transaction *txn_;
   std::vector<IndexInfo*> index_infos_;  // B+树索引信息,一个表上可能有多个索引!
+  // 一次插入可能写入大量页面, 通过 BULK_WRITE 的环写入, 避免把 buffer pool 中的热页全部挤出去
+  BufferAccessStrategy bulk_write_strategy_{AccessType::BULK_WRITE};
 };
 }  // namespace bustub
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <string>
+#include <utility>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
@@ -23,11 +26,15 @@ namespace bustub {
  */
 class CheckpointManager {
  public:
+  /**
+   * @param warm_start_file if not empty, every checkpoint also saves the resident page set of the buffer pool to it
+   */
   CheckpointManager(TransactionManager *transaction_manager, LogManager *log_manager,
-                    BufferPoolManager *buffer_pool_manager)
+                    BufferPoolManager *buffer_pool_manager, std::string warm_start_file = "")
       : transaction_manager_(transaction_manager),
         log_manager_(log_manager),
-        buffer_pool_manager_(buffer_pool_manager) {}
+        buffer_pool_manager_(buffer_pool_manager),
+        warm_start_file_(std::move(warm_start_file)) {}
 
   ~CheckpointManager() = default;
 
@@ -38,6 +45,7 @@ class CheckpointManager {
   TransactionManager *transaction_manager_ __attribute__((__unused__));
   LogManager *log_manager_ __attribute__((__unused__));
   BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  std::string warm_start_file_;
 };
 
 }  // namespace bustub
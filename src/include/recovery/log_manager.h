@@ -73,7 +73,7 @@ class LogManager {
 
   char *log_buffer_;
   char *flush_buffer_;
-  size_t log_offset_;             // 当前日志的末尾(或者下次日志的开始)在log_buffer_中的偏移
+  size_t log_offset_{0};          // 当前日志的末尾(或者下次日志的开始)在log_buffer_中的偏移
 
   std::thread *flush_thread_ __attribute__((__unused__));
 
@@ -81,7 +81,7 @@ class LogManager {
   
   std::mutex mtx_cv_;             // 与条件变量配合使用    -- add by cdz
   std::condition_variable cv_;    // 刷新日志的条件变量
-  bool need_flush_;               // 条件变量等待的条件(个人实现时合并了两个条件:时间到 和 log buffer满) -- add by cdz
+  bool need_flush_{false};        // 条件变量等待的条件(个人实现时合并了两个条件:时间到 和 log buffer满) -- add by cdz
   std::thread *timer_thread_ __attribute__((__unused__));   // 用于定时(待优化TODO)  -- add by cdz
 
   DiskManager *disk_manager_ __attribute__((__unused__));
@@ -13,53 +13,203 @@
 #pragma once
 
 #include <atomic>
-#include <fstream>
 #include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/free_space_map.h"
+#include "storage/disk/io_engine.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Every page carries a CRC-32C checksum in its last PAGE_CHECKSUM_SIZE bytes (the trailer, see PAGE_DATA_SIZE). The
+ * write functions compute it and store it into the trailer of the caller's buffer before the write; the read functions
+ * verify it and throw a CorruptedPageException if a page does not match, e.g. after a torn write or bit rot. A page of
+ * all zeros (never written, or past the end of the file) is valid.
+ *
+ * The pages can be spread over several data files, the tablespaces, e.g. to put a hot index on its own disk. Tablespace
+ * DEFAULT_TABLESPACE_ID is the database file, its page ids are the page numbers and it has the whole non-negative
+ * range of page_id_t. The page ids of the other tablespaces are negative: the sign bit, the tablespace id - 1 in the
+ * next 31 - TABLESPACE_PAGE_BITS bits and the number of the page within the tablespace's file in the low
+ * TABLESPACE_PAGE_BITS bits (see MakePageId). The tablespace id bits are never all ones, so no page id is
+ * INVALID_PAGE_ID. Every tablespace has its own file, free space map, fsync and asynchronous I/O engine (queue and
+ * threads), so the I/O of one file does not wait behind the I/O of another.
+ *
+ * The page and log I/O functions are virtual, so that another storage backend (see MemoryDiskManager) can be used
+ * wherever a DiskManager is expected. Page allocation is shared by all backends.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param io_engine the engine of the asynchronous page I/O, it is started by the first asynchronous request
+   * @param direct_io if true, the database file is opened with O_DIRECT: pages are read and written straight between
+   * the disk and the caller's buffers, bypassing the OS page cache, so a page is not cached both by the buffer pool
+   * and by the OS. Buffers that are not PAGE_SIZE aligned go through an aligned bounce buffer. If the file system does
+   * not support O_DIRECT, the file is used with buffered I/O instead, see IsDirectIO(). Applies to the files of all
+   * tablespaces
+   * @param log_file the log file, e.g. on a disk of its own; empty for the db file name with the extension .log
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, IOEngineType io_engine = IOEngineType::IO_URING,
+                       bool direct_io = false, const std::string &log_file = "");
 
-  ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
+
+  /**
+   * Add a tablespace, stored in a data file of its own. Tablespaces are numbered in the order they are added, from
+   * DEFAULT_TABLESPACE_ID + 1 on; a database must add its tablespaces in the same order whenever it is opened.
+   * @param db_file the data file of the tablespace, created if it does not exist. Its free space map is kept next to
+   * it, with the extension .fsm
+   * @return the id of the new tablespace, for CreateTable/CreateIndex and AllocateExtent
+   * @throws Exception if the file can not be opened, or there are MAX_TABLESPACES tablespaces already
+   */
+  virtual tablespace_id_t CreateTablespace(const std::string &db_file);
+
+  /** @return the number of tablespaces, including the default one */
+  int GetNumTablespaces() const { return num_tablespaces_.load(std::memory_order_acquire); }
+
+  /**
+   * @param tablespace_id the tablespace of the page
+   * @param page_no the number of the page within the tablespace's file
+   * @return the page id
+   */
+  static page_id_t MakePageId(tablespace_id_t tablespace_id, page_id_t page_no) {
+    if (tablespace_id == DEFAULT_TABLESPACE_ID) {
+      return page_no;
+    }
+    return static_cast<page_id_t>(static_cast<uint32_t>(1) << 31 |
+                                  static_cast<uint32_t>(tablespace_id - 1) << TABLESPACE_PAGE_BITS |
+                                  static_cast<uint32_t>(page_no));
+  }
+
+  /** @return the tablespace of a page, MAX_TABLESPACES for INVALID_PAGE_ID */
+  static tablespace_id_t GetTablespaceId(page_id_t page_id) {
+    if (page_id >= 0) {
+      return DEFAULT_TABLESPACE_ID;
+    }
+    const uint32_t bits = static_cast<uint32_t>(page_id) >> TABLESPACE_PAGE_BITS;
+    return static_cast<tablespace_id_t>(bits & (MAX_TABLESPACES - 1)) + 1;
+  }
+
+  /** @return the number of a page within the file of its tablespace */
+  static page_id_t GetPageNo(page_id_t page_id) {
+    return page_id >= 0 ? page_id : page_id & ((1 << TABLESPACE_PAGE_BITS) - 1);
+  }
+
+  /**
+   * @return true if page next directly follows page page_id in the file of their tablespace, i.e. one transfer of
+   * consecutive pages (ReadPages, WritePages) can cover both
+   */
+  static bool IsNextPage(page_id_t page_id, page_id_t next) {
+    return GetTablespaceId(next) == GetTablespaceId(page_id) &&
+           GetPageNo(next) == static_cast<int64_t>(GetPageNo(page_id)) + 1;
+  }
+
+  /**
+   * Make every page written so far durable (fdatasync every tablespace), and save the free space maps that changed.
+   * Page writes only reach the OS page cache, this is the durability point, e.g. at the end of a checkpoint. Log writes
+   * are synced by WriteLog itself.
+   */
+  virtual void Sync();
 
   /**
    * Write a page to the database file.
    * @param page_id id of the page
-   * @param page_data raw page data
+   * @param page_data raw page data, its checksum trailer is overwritten
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  virtual void WritePage(page_id_t page_id, char *page_data);
+
+  /**
+   * Write consecutive pages to the database file with a single vectored write (pwritev). The pages do not have to be
+   * contiguous in memory.
+   * @param page_id id of the first page
+   * @param num_pages number of pages to write
+   * @param page_data page_data[i] is the raw data of page page_id + i, its checksum trailer is overwritten
+   */
+  virtual void WritePages(page_id_t page_id, int num_pages, char *const *page_data);
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @throws CorruptedPageException if the page does not match its checksum, page_data holds the page as read
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Read consecutive pages from the database file with a single sequential read.
+   * @param page_id id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] page_data output buffer of num_pages * PAGE_SIZE bytes
+   * @throws CorruptedPageException for the first page that does not match its checksum, after all pages are read
+   */
+  virtual void ReadPages(page_id_t page_id, int num_pages, char *page_data);
+
+  /**
+   * Read consecutive pages from the database file into separate buffers with a single vectored read (preadv).
+   * @param page_id id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] page_data page_data[i] receives page page_id + i, zeroed if it is past the end of the file
+   * @throws CorruptedPageException for the first page that does not match its checksum, after all pages are read
+   */
+  virtual void ReadPages(page_id_t page_id, int num_pages, char *const *page_data);
+
+  /**
+   * Read a page from the database file asynchronously. page_data must stay valid until the future is ready.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, zeroed past the end of the file
+   * @return a future that becomes true when the page was read, false on an I/O error. Its get() throws a
+   * CorruptedPageException if the page does not match its checksum
+   */
+  virtual std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /**
+   * Asynchronous ReadPages into separate buffers, see ReadPageAsync.
+   * @param page_id id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] page_data page_data[i] receives page page_id + i
+   */
+  virtual std::future<bool> ReadPagesAsync(page_id_t page_id, int num_pages, char *const *page_data);
+
+  /**
+   * Write a page to the database file asynchronously. page_data must stay valid and unchanged until the future is
+   * ready. Like WritePage, the write is durable only after Sync().
+   * @param page_id id of the page
+   * @param page_data raw page data, its checksum trailer is overwritten before the call returns
+   * @return a future that becomes true when the page was written, false on an I/O error
+   */
+  virtual std::future<bool> WritePageAsync(page_id_t page_id, char *page_data);
+
+  /**
+   * Asynchronous WritePages, see WritePageAsync.
+   * @param page_id id of the first page
+   * @param num_pages number of pages to write
+   * @param page_data page_data[i] is the raw data of page page_id + i
+   */
+  virtual std::future<bool> WritePagesAsync(page_id_t page_id, int num_pages, char *const *page_data);
+
+  /** @return the engine that runs the asynchronous I/O, IO_URING may have fallen back to THREAD_POOL */
+  IOEngineType GetIOEngineType();
 
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
    * @param size size of log entry
    */
-  void WriteLog(char *log_data, int size);
+  virtual void WriteLog(char *log_data, int size);
 
   /**
    * Read a log entry from the log file.
@@ -68,20 +218,70 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  bool ReadLog(char *log_data, int size, int offset);
+  virtual bool ReadLog(char *log_data, int size, int offset);
 
   /**
-   * Allocate a page on disk.
+   * Allocate a page of the default tablespace. Deallocated pages are reused, lowest first, before the file grows.
+   * Allocation does no I/O, the free space map is saved by Sync() and ShutDown(). After a crash, a page reused since
+   * the last Sync() may be free in the saved map; new pages at the end are recovered from the size of the file when
+   * the tablespace is opened.
    * @return the id of the allocated page
+   * @throws Exception if the tablespace has no page numbers left
    */
   page_id_t AllocatePage();
 
   /**
-   * Deallocate a page on disk.
+   * Allocate a page of the default tablespace whose id is congruent to offset modulo stride, e.g. for one instance of
+   * a parallel buffer pool.
+   * @param stride the number of page id stripes
+   * @param offset the stripe, less than stride
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage(uint32_t stride, uint32_t offset);
+
+  /**
+   * Allocate num_pages consecutive pages, e.g. an extent of one table or index (see PageExtent).
+   * @param num_pages the number of pages
+   * @param tablespace_id the tablespace of the pages
+   * @return the id of the first page
+   * @throws Exception if the tablespace does not exist or has no page numbers left
+   */
+  page_id_t AllocateExtent(int num_pages, tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID);
+
+  /**
+   * Reserve num_pages consecutive pages for one table or index (see PageExtent). The pages stay free in the free
+   * space map, the owner takes them with AllocatePageInExtent; the reservation ends when the disk manager is closed.
+   * @param num_pages the number of pages
+   * @param tablespace_id the tablespace of the pages
+   * @return the id of the first page
+   * @throws Exception if the tablespace does not exist or has no page numbers left
+   */
+  page_id_t ReserveExtent(int num_pages, tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID);
+
+  /**
+   * Allocate the lowest free page of an extent. Like AllocatePage it does no I/O.
+   * @param extent the id of the first page of the extent
+   * @param num_pages the number of pages of the extent
+   * @return the id of the allocated page, INVALID_PAGE_ID if every page of the extent is allocated
+   */
+  page_id_t AllocatePageInExtent(page_id_t extent, int num_pages);
+
+  /**
+   * Deallocate a page on disk, it can be allocated again. The free space map is saved by Sync() and ShutDown().
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /** @return the map of the allocated pages of a tablespace, by page number */
+  FreeSpaceMap *GetFreeSpaceMap(tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID) {
+    return &GetTablespace(MakePageId(tablespace_id, 0))->free_space_map_;
+  }
+
+  /** @return true if the file of a tablespace bypasses the OS page cache (O_DIRECT) */
+  bool IsDirectIO(tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID) const {
+    return GetTablespace(MakePageId(tablespace_id, 0))->direct_io_;
+  }
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -91,6 +291,15 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /**
+   * @param page_data PAGE_SIZE bytes as stored on disk
+   * @return true if the trailer of the page matches its data, or the page is all zeros (it was never written)
+   */
+  static bool IsPageChecksumValid(const char *page_data);
+
+  /** @return the number of pages read so far that did not match their checksum */
+  uint64_t GetNumChecksumFailures() const { return num_checksum_failures_.load(std::memory_order_relaxed); }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -100,19 +309,94 @@ class DiskManager {
   /** Checks if the non-blocking flush future was set. */
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
+ protected:
+  /** Creates a disk manager without files, for a backend that stores the pages and the log itself. */
+  DiskManager();
+
+  /** The data file of a tablespace, and the state of its pages. */
+  struct Tablespace {
+    std::string file_name_;
+    // 空闲页面位图, 保存在 <file name>.fsm 中; 没有文件的 tablespace 不保存
+    std::string fsm_name_;
+    // file descriptor of the data file. All page I/O is positional (pread/pwrite), there is no shared file position,
+    // so the buffer pool threads read and write pages in parallel without a latch
+    int fd_ = -1;
+    // fd_ 是否以 O_DIRECT 打开. 文件系统在读写时才拒绝 O_DIRECT 的话, 会去掉这个标志退回到带缓存的 I/O
+    std::atomic<bool> direct_io_{false};
+    // size of the data file, kept up to date by the writes so that reads can detect the end of file without a stat
+    // call
+    std::atomic<int64_t> file_size_{0};
+    FreeSpaceMap free_space_map_;
+    // 保存位图时持有, 保存用的临时文件只有一个
+    std::mutex fsm_file_latch_;
+    // 位图在上次保存之后被修改过; 分配/释放只设置它, Sync/ShutDown 只保存修改过的位图
+    std::atomic<bool> fsm_dirty_{false};
+    // 异步 I/O 引擎在这个文件第一次异步请求时才创建, 每个文件有自己的队列和线程
+    std::once_flag io_engine_once_;
+    std::unique_ptr<IOEngine> io_engine_;
+  };
+
+  /**
+   * Add a tablespace, see CreateTablespace.
+   * @param db_file the data file, empty for a tablespace without a file
+   * @return the id of the new tablespace
+   */
+  tablespace_id_t AddTablespace(const std::string &db_file);
+
+  /**
+   * @return the tablespace of a page
+   * @throws Exception if the tablespace does not exist
+   */
+  Tablespace *GetTablespace(page_id_t page_id) const;
+
+  /**
+   * @param page_no the first of num_pages page numbers that were allocated in a tablespace
+   * @return the page id of page_no
+   * @throws Exception if the pages do not fit into the page numbers of a tablespace
+   */
+  static page_id_t ToAllocatedPageId(tablespace_id_t tablespace_id, page_id_t page_no, int num_pages);
+
+  /** Store the checksum of the page into its trailer. */
+  static void SetPageChecksum(char *page_data);
+  /**
+   * Verify the checksums of num_pages pages read from page_id on.
+   * @throws CorruptedPageException for the first page that does not match
+   */
+  void VerifyPages(page_id_t page_id, int num_pages, const char *const *page_data);
+
+  std::atomic<int> num_flushes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<bool> flush_log_{false};
+  std::future<void> *flush_log_f_{nullptr};  // 个人实现中暂未用上...
+
  private:
-  int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+  int64_t GetFileSize(int fd);
+  /** Open (or create) the data file of a tablespace and load its free space map. */
+  void OpenTablespace(Tablespace *tablespace, const std::string &db_file);
+  /** Transfer iov at offset of the data file of a tablespace, through a bounce buffer if O_DIRECT can not use iov. */
+  ssize_t TransferPages(Tablespace *tablespace, std::vector<struct iovec> *iov, off_t offset, bool write);
+  /** Load the free space map of a tablespace from its fsm_name_. */
+  bool LoadFreeSpaceMap(Tablespace *tablespace);
+  /** Replace the fsm_name_ of a tablespace with its current free space map. */
+  void SaveFreeSpaceMap(Tablespace *tablespace);
+  /** Submit a read or write of num_pages consecutive pages to the I/O engine of their tablespace. */
+  std::future<bool> SubmitPages(page_id_t page_id, int num_pages, char *const *page_data, bool write);
+  IOEngine *GetIOEngine(Tablespace *tablespace);
+  // file descriptor of the log file, opened in append mode
+  int log_fd_ = -1;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // size of the log file, kept up to date by the writes so that reads can detect the end of file without a stat call
+  std::atomic<int64_t> log_file_size_{0};
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
-  int num_flushes_;
-  int num_writes_;
-  bool flush_log_;
-  std::future<void> *flush_log_f_;    // 个人实现中暂未用上...
+  // tablespaces_[i] 在 num_tablespaces_ 增加之前创建好, 之后不再改变, 所以读写页面时不需要加锁
+  std::unique_ptr<Tablespace> tablespaces_[MAX_TABLESPACES];
+  std::atomic<int> num_tablespaces_{0};
+  /** Serializes CreateTablespace. */
+  std::mutex tablespace_latch_;
+  bool direct_io_ = false;
+  std::atomic<uint64_t> num_checksum_failures_{0};
+  // 异步 I/O 引擎在第一次异步请求时才创建, 只做同步 I/O 的 DiskManager 不会启动它的线程
+  IOEngineType io_engine_type_{IOEngineType::THREAD_POOL};
 };
 
 }  // namespace bustub
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/disk/free_space_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap tracks which pages of the database file are allocated, one bit per page, so that deallocated pages are
+ * handed out again before the file grows.
+ *
+ * Pages [0, GetNumPages()) have been allocated at least once; a page at or past it has never been used. Allocation
+ * returns the lowest free page. A search starts at a hint, the lowest 64 page word that may have a free page, which
+ * only moves forward past full words and moves back when a page below it is freed, so allocation is O(1) amortized.
+ *
+ * An extent can also be reserved for one table or index (see PageExtent): its pages stay free until the owner
+ * allocates them one by one with AllocateInRange, and Allocate skips them. Reservations are not serialized, so the
+ * pages of an extent its owner never used are free again when the map is loaded.
+ *
+ * The map is serialized to a sidecar file of the database (see DiskManager).
+ */
+class FreeSpaceMap {
+ public:
+  FreeSpaceMap() = default;
+
+  /**
+   * Allocate the lowest free page whose id is congruent to offset modulo stride, extending the map if there is none.
+   * Pages that the extension skips (the other residues) become free pages.
+   * @param stride the page ids that can be allocated are offset, offset + stride, ... (1 for any page)
+   * @param offset the residue, less than stride
+   * @param[out] reused if not nullptr, set to true if the page was a free page below GetNumPages()
+   * @return the allocated page id
+   */
+  page_id_t Allocate(uint32_t stride = 1, uint32_t offset = 0, bool *reused = nullptr);
+
+  /**
+   * Allocate num_pages consecutive pages, starting at a multiple of num_pages: the lowest such run that is completely
+   * free, or a new one past the end of the map. Pages that the extension skips become free pages.
+   * @param num_pages the number of pages
+   * @param[out] reused if not nullptr, set to true if the run was free pages below GetNumPages()
+   * @return the first page id of the run
+   */
+  page_id_t AllocateExtent(page_id_t num_pages, bool *reused = nullptr);
+
+  /**
+   * Reserve num_pages consecutive pages like AllocateExtent, but leave them free: only AllocateInRange hands them out.
+   * @param num_pages the number of pages
+   * @return the first page id of the run
+   */
+  page_id_t ReserveExtent(page_id_t num_pages);
+
+  /**
+   * Allocate the lowest free page of [first, first + num_pages), reserved or not.
+   * @param first the first page id
+   * @param num_pages the number of pages
+   * @return the allocated page id, INVALID_PAGE_ID if all of them are allocated
+   */
+  page_id_t AllocateInRange(page_id_t first, page_id_t num_pages);
+
+  /**
+   * Free a page. Freeing a page that is not allocated does nothing.
+   * @param page_id the page id
+   */
+  void Free(page_id_t page_id);
+
+  /** @return true if the page is allocated */
+  bool IsAllocated(page_id_t page_id);
+
+  /**
+   * Mark pages [0, num_pages) allocated, e.g. the pages of a database file that has no map yet.
+   * @param num_pages the number of pages
+   */
+  void MarkAllocated(page_id_t num_pages);
+
+  /**
+   * Mark pages [first, first + num_pages) allocated, extending the map if needed; the other pages keep their state.
+   * E.g. the pages of a database file past its map, written after the map was last saved.
+   * @param first the first page id
+   * @param num_pages the number of pages
+   */
+  void MarkRangeAllocated(page_id_t first, page_id_t num_pages);
+
+  /** @return one past the highest page that was ever allocated */
+  page_id_t GetNumPages();
+
+  /** @return the number of pages below GetNumPages() that are free, including reserved ones */
+  size_t GetNumFreePages();
+
+  /** @return the map in its file format: a magic number, the number of pages and the bitmap words */
+  std::vector<char> Serialize();
+
+  /**
+   * Replace the map with a serialized one.
+   * @return false if data is not a valid map, the map is unchanged then
+   */
+  bool Deserialize(const std::vector<char> &data);
+
+ private:
+  static constexpr uint32_t MAGIC = 0x4D534642;  // "BFSM"
+  static constexpr page_id_t BITS_PER_WORD = 64;
+
+  /** @return the bits of word w that belong to pages below num_pages_ with id % stride == offset */
+  uint64_t CandidateMask(size_t w, uint32_t stride, uint32_t offset) const;
+  void SetAllocated(page_id_t page_id, bool allocated);
+  /** Grow the map to num_pages pages, the new pages are free. */
+  void Extend(page_id_t num_pages);
+  /** @return the mask of the bits of a word that belong to the pages [first, first + num_pages), from page_id on */
+  static uint64_t RangeMask(page_id_t page_id, page_id_t first, page_id_t num_pages);
+  /** @return true if none of the pages [first, first + num_pages) is allocated or reserved */
+  bool IsRangeFree(page_id_t first, page_id_t num_pages) const;
+  /** @return the first page of the lowest aligned run of num_pages free pages, the map is extended if there is none */
+  page_id_t FindExtent(page_id_t num_pages, bool *reused);
+
+  std::mutex latch_;
+  // bit i of words_[w] is set if page w * 64 + i is allocated
+  std::vector<uint64_t> words_;
+  // bit i of reserved_[w] is set if page w * 64 + i belongs to a reserved extent
+  std::vector<uint64_t> reserved_;
+  page_id_t num_pages_ = 0;
+  // (stride, offset) -> first word that may have a free page of that residue
+  std::map<std::pair<uint32_t, uint32_t>, size_t> hints_;
+};
+
+}  // namespace bustub
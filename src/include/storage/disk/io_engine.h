@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_engine.h
+//
+// Identification: src/include/storage/disk/io_engine.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+/** The backends that execute asynchronous disk I/O. */
+enum class IOEngineType { THREAD_POOL, IO_URING };
+
+/**
+ * Transfer all of iov at offset with preadv/pwritev, one call per IOV_MAX buffers, continuing after partial transfers
+ * and EINTR. iov is consumed.
+ * @return the number of bytes transferred, less than requested if a read reaches the end of file; -1 on an I/O error
+ */
+ssize_t TransferAll(int fd, std::vector<struct iovec> *iov, off_t offset, bool write);
+
+/** One positional vectored read or write. */
+struct IORequest {
+  int fd_;
+  off_t offset_;
+  bool write_;
+  std::vector<struct iovec> iov_;
+  /** Called on an engine thread with the number of bytes transferred (short at end of file), or -1 on an error. */
+  std::function<void(ssize_t)> on_complete_;
+};
+
+/**
+ * IOEngine executes disk I/O asynchronously, so that a caller can keep many reads and writes in flight at once and
+ * wait for them together.
+ */
+class IOEngine {
+ public:
+  /**
+   * Create an engine. IO_URING falls back to THREAD_POOL if the kernel does not support io_uring or forbids it.
+   * @param type the preferred engine
+   * @param queue_depth the max number of requests in flight
+   */
+  static std::unique_ptr<IOEngine> Create(IOEngineType type, size_t queue_depth = IO_QUEUE_DEPTH);
+
+  IOEngine() = default;
+  DISALLOW_COPY_AND_MOVE(IOEngine);
+  /** Completes all requests that were submitted. */
+  virtual ~IOEngine() = default;
+
+  /** @return the engine type */
+  virtual IOEngineType GetType() const = 0;
+
+  /**
+   * Submit a batch of requests. They are queued and start in submission order, but may complete in any order.
+   * @param requests the requests
+   */
+  virtual void Submit(std::vector<IORequest> requests) = 0;
+};
+
+/**
+ * ThreadPoolIOEngine runs every request as a blocking preadv/pwritev on one of a fixed set of I/O threads, so at most
+ * that many requests are in flight. It works everywhere.
+ */
+class ThreadPoolIOEngine : public IOEngine {
+ public:
+  /** @param num_threads the number of I/O threads */
+  explicit ThreadPoolIOEngine(size_t num_threads = IO_THREADS);
+  ~ThreadPoolIOEngine() override;
+
+  IOEngineType GetType() const override { return IOEngineType::THREAD_POOL; }
+  void Submit(std::vector<IORequest> requests) override;
+
+ private:
+  void Worker();
+
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<IORequest> pending_;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+};
+
+/**
+ * IoUringIOEngine hands requests to the kernel through an io_uring submission queue. A single ring thread moves the
+ * pending requests into the queue and submits the whole batch with one io_uring_enter call, so up to queue_depth
+ * requests are in flight with no thread per request. It talks to the kernel with the raw system calls, liburing is not
+ * needed.
+ */
+class IoUringIOEngine : public IOEngine {
+ public:
+  /**
+   * Set up the ring.
+   * @param queue_depth the number of submission queue entries
+   * @throws Exception if the ring can not be set up
+   */
+  explicit IoUringIOEngine(size_t queue_depth = IO_QUEUE_DEPTH);
+  ~IoUringIOEngine() override;
+
+  IOEngineType GetType() const override { return IOEngineType::IO_URING; }
+  void Submit(std::vector<IORequest> requests) override;
+
+ private:
+  void RingWorker();
+  /** Finish a request whose completion reported res. */
+  void Complete(IORequest *request, int res);
+  void UnmapRing();
+
+  int ring_fd_ = -1;
+  // the rings shared with the kernel
+  void *sq_ring_ = nullptr;
+  void *cq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  struct io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  unsigned *sq_tail_ = nullptr;
+  unsigned *sq_mask_ = nullptr;
+  unsigned *sq_array_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned *cq_mask_ = nullptr;
+  struct io_uring_cqe *cqes_ = nullptr;
+
+  // requests in flight, indexed by the user_data of their queue entry; free_slots_ are the unused indexes
+  std::vector<std::unique_ptr<IORequest>> slots_;
+  std::vector<unsigned> free_slots_;
+
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<IORequest> pending_;
+  bool stop_ = false;
+  std::thread ring_thread_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_disk_manager.h
+//
+// Identification: src/include/storage/disk/memory_disk_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * The latency model of a simulated disk. A request for n consecutive pages takes request_ + n * per_page_, plus seek_
+ * if it does not start at the page where the previous request ended. A log write costs like a page request of its
+ * size, without the seek (the log is appended sequentially).
+ */
+struct DiskLatency {
+  std::chrono::nanoseconds request_{0};
+  std::chrono::nanoseconds per_page_{0};
+  std::chrono::nanoseconds seek_{0};
+
+  /** @return a model of an NVMe SSD: 80 us per request, about 2 GB/s, no seek */
+  static DiskLatency SSD() { return {std::chrono::microseconds(80), std::chrono::microseconds(2), {}}; }
+
+  /** @return a model of a 7200 rpm HDD: 8 ms seek and rotation, about 130 MB/s */
+  static DiskLatency HDD() {
+    return {std::chrono::microseconds(100), std::chrono::microseconds(30), std::chrono::milliseconds(8)};
+  }
+};
+
+/**
+ * MemoryDiskManager is a DiskManager that keeps the pages and the log in memory, so that tests and benchmarks measure
+ * the buffer pool and the indexes instead of the file system. No file is created.
+ *
+ * The pages live in a growable arena of PAGE_SIZE aligned chunks. Chunks never move once they are allocated, so the
+ * arena grows without copying the pages. Pages that were never written read as zeros. Checksums are written and
+ * verified like on disk, and page allocation is the one of DiskManager. Every tablespace has an arena of its own.
+ *
+ * Every request can be delayed by a DiskLatency, to simulate an SSD or an HDD. The caller waits for the modelled time,
+ * and the total is also accumulated in GetSimulatedIOTime(), which is deterministic for a single threaded workload.
+ * Asynchronous requests run on their own thread when there is a latency, so that requests in flight overlap.
+ */
+class MemoryDiskManager : public DiskManager {
+ public:
+  /** @param latency the latency of every request, none by default */
+  explicit MemoryDiskManager(DiskLatency latency = DiskLatency());
+
+  ~MemoryDiskManager() override;
+
+  DISALLOW_COPY_AND_MOVE(MemoryDiskManager);
+
+  /** Nothing to close, the pages stay readable. */
+  void ShutDown() override {}
+
+  /** The pages are always "durable", a sync only costs one request. */
+  void Sync() override;
+
+  /** Add a tablespace, in memory like the default one. db_file is only a name, no file is created. */
+  tablespace_id_t CreateTablespace(const std::string &db_file) override;
+
+  void WritePage(page_id_t page_id, char *page_data) override;
+  void WritePages(page_id_t page_id, int num_pages, char *const *page_data) override;
+  void ReadPage(page_id_t page_id, char *page_data) override;
+  void ReadPages(page_id_t page_id, int num_pages, char *page_data) override;
+  void ReadPages(page_id_t page_id, int num_pages, char *const *page_data) override;
+  std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data) override;
+  std::future<bool> ReadPagesAsync(page_id_t page_id, int num_pages, char *const *page_data) override;
+  std::future<bool> WritePageAsync(page_id_t page_id, char *page_data) override;
+  std::future<bool> WritePagesAsync(page_id_t page_id, int num_pages, char *const *page_data) override;
+  void WriteLog(char *log_data, int size) override;
+  bool ReadLog(char *log_data, int size, int offset) override;
+
+  /** Change the latency model, e.g. after the test data was loaded without latency. */
+  void SetLatency(const DiskLatency &latency);
+
+  /** @return the sum of the latencies of all requests so far */
+  std::chrono::nanoseconds GetSimulatedIOTime() const {
+    return std::chrono::nanoseconds(simulated_ns_.load(std::memory_order_relaxed));
+  }
+
+  /** @return one past the highest page number written so far in a tablespace */
+  page_id_t GetNumPages(tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID) const {
+    return num_pages_[tablespace_id].load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr size_t PAGES_PER_CHUNK = 256;
+
+  /** Grow the arena of a tablespace to hold at least num_pages pages. */
+  void Reserve(tablespace_id_t tablespace_id, size_t num_pages);
+  /** Copy num_pages consecutive pages between the arena and the buffers, after the modelled delay. */
+  void Transfer(page_id_t page_id, int num_pages, char *const *page_data, bool write);
+  /** Run Transfer asynchronously: at once if there is no latency, otherwise on its own thread. */
+  std::future<bool> TransferAsync(page_id_t page_id, int num_pages, char *const *page_data, bool write);
+  /** Account the latency of a request and wait for it. */
+  void Delay(page_id_t page_id, int num_pages, bool seek);
+
+  // 页面按 chunk 分配, chunk 一旦分配就不会移动; chunks_ 本身只在增长时加写锁. chunks_[i] 是 tablespace i 的页面
+  std::shared_mutex arena_latch_;
+  std::vector<std::unique_ptr<char, decltype(&std::free)>> chunks_[MAX_TABLESPACES];
+  std::atomic<page_id_t> num_pages_[MAX_TABLESPACES]{};
+
+  std::mutex log_latch_;
+  std::vector<char> log_;
+
+  std::mutex latency_latch_;
+  DiskLatency latency_;
+  // 上一个请求结束的页面, 不从这里开始的请求要付 seek 的代价
+  page_id_t next_page_id_ = 0;
+  std::atomic<int64_t> simulated_ns_{0};
+};
+
+}  // namespace bustub
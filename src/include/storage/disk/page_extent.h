@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_extent.h
+//
+// Identification: src/include/storage/disk/page_extent.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class DiskManager;
+
+/**
+ * PageExtent hands out the pages of one table or index from extents, runs of extent_size consecutive page ids that
+ * DiskManager::ReserveExtent reserves for this object alone. The pages of the object are therefore contiguous on
+ * disk, instead of interleaved with every other object's pages in the global page id sequence, and a sequential scan
+ * or a leaf chain walk mostly reads the file sequentially.
+ *
+ * A page the object deletes (e.g. a merged B+ tree node, see BufferPoolManager::DeletePage) is free again but stays in
+ * its extent, and is handed out again before another extent is reserved. The extents are searched in page id order
+ * from a cursor that only moves back when a page of the object is freed, so allocation is O(1) amortized.
+ *
+ * The object passes its extent to BufferPoolManager::NewPage, like a BufferAccessStrategy. It may be shared by
+ * threads. The extents are not persistent: their pages that were never used are free in the saved free space map, so
+ * they are reused after the database is reopened, and a reopened object starts a new extent.
+ */
+class PageExtent {
+ public:
+  /**
+   * @param extent_size the number of pages per extent
+   * @param tablespace_id the tablespace the extents are reserved in
+   */
+  explicit PageExtent(int extent_size = EXTENT_SIZE, tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID)
+      : extent_size_(extent_size), tablespace_id_(tablespace_id) {}
+  DISALLOW_COPY_AND_MOVE(PageExtent);
+  ~PageExtent() = default;
+
+  /**
+   * Take the lowest free page of the extents of the object, reserving a new extent when they are all used up.
+   * @param disk_manager the disk manager the extents are reserved from, the same one on every call
+   * @return the page id
+   */
+  page_id_t AllocatePage(DiskManager *disk_manager);
+
+  /**
+   * Give back a page that AllocatePage returned but that was never used, e.g. because no frame was free. It is
+   * deallocated and handed out again by the next AllocatePage.
+   * @param page_id the page id
+   */
+  void ReleasePage(page_id_t page_id);
+
+  /**
+   * Note that a page of the object was deallocated, so that AllocatePage hands it out again.
+   * @param page_id the page id
+   */
+  void FreePage(page_id_t page_id);
+
+  /** @return the number of pages per extent */
+  int GetExtentSize() const { return extent_size_; }
+
+  /** @return the tablespace of the pages */
+  tablespace_id_t GetTablespaceId() const { return tablespace_id_; }
+
+ private:
+  const int extent_size_;
+  const tablespace_id_t tablespace_id_;
+  std::mutex latch_;
+  DiskManager *disk_manager_ = nullptr;
+  // the first page ids of the extents of the object
+  std::set<page_id_t> extents_;
+  // the extents below next_extent_ have no free page
+  page_id_t next_extent_ = 0;
+};
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <fstream>
 #include <queue>
 #include <string>
 #include <vector>
@@ -47,8 +48,12 @@ class BPlusTree {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  // 插入时先插入再分裂, 结点会短暂地多存一个 kv 对, 所以默认的 max_size 要比一页能放下的个数少1,
+  // 否则会写出页面末尾(buffer pool 中各页面的数据是连续存放的, 会写坏下一个页面)
+  // 结点页面存放在 tablespace_id 中, 比如把热点索引放到单独的磁盘上
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE - 1, int internal_max_size = INTERNAL_PAGE_SIZE - 1,
+                     tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty();
@@ -88,7 +93,7 @@ class BPlusTree {
   LeafPage* FindLeafPage(const KeyType &key, bool leftMost, IndexOpType indexOp,Transaction *transaction);
 
  private:
-  void StartNewTree(const KeyType &key, const ValueType &value);
+  bool StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
@@ -129,6 +134,9 @@ class BPlusTree {
   void UnLatchAncestors(Page* page,IndexOpType indexOp,Transaction *transaction);
 
   void FreeAllPagesInTxn(IndexOpType indexOp,Transaction *transaction);
+
+  // 乐观地(不加页面读锁)查找 key; 返回 false 表示与并发的写操作冲突, 需要加锁重新查找
+  bool OptimisticGetValue(const KeyType &key, ValueType *value, bool *exist);
 ///////////////////////////////////////////////////////////////////////// end cdz
 
   // member variable
@@ -139,6 +147,7 @@ class BPlusTree {
   int leaf_max_size_;
   int internal_max_size_;
   std::mutex root_pgid_mutex_;      // 保护共享变量 root_page_id_ 的并发修改
+  PageExtent extent_;               // 结点页面从本索引自己的 extent 中分配, 叶子链在磁盘上基本是连续的
 };
 
 }  // namespace bustub
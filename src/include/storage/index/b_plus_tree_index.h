@@ -25,7 +25,8 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager);
+  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager,
+                 tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID);
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
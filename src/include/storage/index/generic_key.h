@@ -99,13 +99,71 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, prefix_size_{other.prefix_size_}, integer_key_{other.integer_key_} {}
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {
+    // 第一列是存放在键开头的整数时, 键的顺序首先由这个整数决定, 比较它不需要反序列化出 Value
+    if (key_schema_ == nullptr || key_schema_->GetColumnCount() == 0) {
+      return;
+    }
+    const Column &col = key_schema_->GetColumn(0);
+    switch (col.GetType()) {
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT:
+        if (col.GetOffset() == 0 && col.GetFixedLength() <= KeySize) {
+          prefix_size_ = col.GetFixedLength();
+          integer_key_ = key_schema_->GetColumnCount() == 1;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  /**
+   * @return the size in bytes of the integer the keys start with (their first column), 0 if the first column is not
+   * an integer. Keys are ordered by this integer first, see IntegerPrefix.
+   */
+  inline uint32_t GetIntegerPrefixSize() const { return prefix_size_; }
+
+  /** @return true if the key is a single integer column: keys with equal integer prefixes are equal */
+  inline bool IsIntegerKey() const { return integer_key_; }
+
+  /**
+   * The first column of the key as a plain integer, without building a Value. NULL is the minimum of the type, so
+   * it orders before every value instead of comparing equal to everything as in operator().
+   * Only valid if GetIntegerPrefixSize() > 0.
+   */
+  inline int64_t IntegerPrefix(const GenericKey<KeySize> &key) const {
+    switch (prefix_size_) {
+      case sizeof(int8_t):
+        return static_cast<int8_t>(key.data_[0]);
+      case sizeof(int16_t): {
+        int16_t prefix;
+        memcpy(&prefix, key.data_, sizeof(prefix));
+        return prefix;
+      }
+      case sizeof(int32_t): {
+        int32_t prefix;
+        memcpy(&prefix, key.data_, sizeof(prefix));
+        return prefix;
+      }
+      default: {
+        int64_t prefix;
+        memcpy(&prefix, key.data_, sizeof(prefix));
+        return prefix;
+      }
+    }
+  }
 
  private:
   Schema *key_schema_;
+  uint32_t prefix_size_{0};
+  bool integer_key_{false};
 };
 
 }  // namespace bustub
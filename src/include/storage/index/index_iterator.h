@@ -41,6 +41,9 @@ class IndexIterator {
   bool operator!=(const IndexIterator &itr) const;
 
  private:
+  // 异步预读叶子链表上当前结点之后的若干个结点
+  void PrefetchNextLeaves();
+
   // add your own private member variables here
   int index_;
   B_PLUS_TREE_LEAF_PAGE_TYPE* leaf_node_;
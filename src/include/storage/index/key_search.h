@@ -0,0 +1,161 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_search.h
+//
+// Identification: src/include/storage/index/key_search.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include <cstdint>
+#include <utility>
+
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+/**
+ * Search of a key among the sorted key/value pairs of a B+ tree page.
+ *
+ * KeyLowerBound / KeyUpperBound are a binary search with the comparator of the tree. For GenericKey<8> keys that
+ * start with an integer column (see GenericComparator::GetIntegerPrefixSize) they search the integers directly
+ * instead: the binary search narrows the range down to KEY_SEARCH_WINDOW pairs, whose keys are then compared at once
+ * with AVX2 (the 8 byte prefixes are gathered into a register, 4 at a time). The comparator is only called to order
+ * keys with equal prefixes, and never for single integer column keys.
+ */
+
+/** The number of pairs the binary search leaves to the SIMD compare. */
+static constexpr int KEY_SEARCH_WINDOW = 8;
+
+/** @return the first index i in [begin, end) so that items[i].first >= key, end if there is none */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int BinaryLowerBound(const std::pair<KeyType, ValueType> *items, int begin, int end, const KeyType &key,
+                     const KeyComparator &comparator) {
+  while (begin < end) {
+    const int mid = begin + (end - begin) / 2;
+    if (comparator(items[mid].first, key) < 0) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+/** @return the first index i in [begin, end) so that items[i].first > key, end if there is none */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int BinaryUpperBound(const std::pair<KeyType, ValueType> *items, int begin, int end, const KeyType &key,
+                     const KeyComparator &comparator) {
+  while (begin < end) {
+    const int mid = begin + (end - begin) / 2;
+    if (comparator(items[mid].first, key) <= 0) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+/**
+ * @return the number of the num_items pairs whose integer prefix is < prefix (upper: <= prefix). The pairs are few,
+ * they are all compared.
+ */
+template <typename ValueType>
+int CountIntegerPrefixesBelow(const std::pair<GenericKey<8>, ValueType> *items, int num_items, int64_t prefix,
+                              bool upper, const GenericComparator<8> &comparator) {
+  int i = 0;
+  int count = 0;
+#if defined(__AVX2__)
+  if (comparator.GetIntegerPrefixSize() == sizeof(int64_t)) {
+    // 键和值交错存放, 用 gather 按 pair 的步长取出 4 个键的前缀
+    const auto stride = static_cast<int64_t>(sizeof(items[0]));
+    const __m256i offsets = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+    const __m256i bound = _mm256_set1_epi64x(prefix);
+    for (; i + 4 <= num_items; i += 4) {
+      const auto *base = reinterpret_cast<const long long *>(items[i].first.data_);  // NOLINT
+      const __m256i prefixes = _mm256_i64gather_epi64(base, offsets, 1);
+      const __m256i greater =
+          upper ? _mm256_cmpgt_epi64(prefixes, bound) : _mm256_cmpgt_epi64(bound, prefixes);
+      const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(greater));
+      count += upper ? 4 - __builtin_popcount(mask) : __builtin_popcount(mask);
+    }
+  }
+#endif
+  for (; i < num_items; i++) {
+    const int64_t item_prefix = comparator.IntegerPrefix(items[i].first);
+    count += upper ? item_prefix <= prefix : item_prefix < prefix;
+  }
+  return count;
+}
+
+/** @return the first index i in [begin, end) whose integer prefix is >= prefix (upper: > prefix), end if none */
+template <typename ValueType>
+int IntegerPrefixBound(const std::pair<GenericKey<8>, ValueType> *items, int begin, int end, int64_t prefix,
+                       bool upper, const GenericComparator<8> &comparator) {
+  while (end - begin > KEY_SEARCH_WINDOW) {
+    const int mid = begin + (end - begin) / 2;
+    const int64_t mid_prefix = comparator.IntegerPrefix(items[mid].first);
+    if (mid_prefix < prefix || (upper && mid_prefix == prefix)) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin + CountIntegerPrefixesBelow(items + begin, end - begin, prefix, upper, comparator);
+}
+
+/** @return the first index i in [begin, end) so that items[i].first >= key, end if there is none */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int KeyLowerBound(const std::pair<KeyType, ValueType> *items, int begin, int end, const KeyType &key,
+                  const KeyComparator &comparator) {
+  return BinaryLowerBound(items, begin, end, key, comparator);
+}
+
+/** @return the first index i in [begin, end) so that items[i].first > key, end if there is none */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int KeyUpperBound(const std::pair<KeyType, ValueType> *items, int begin, int end, const KeyType &key,
+                  const KeyComparator &comparator) {
+  return BinaryUpperBound(items, begin, end, key, comparator);
+}
+
+template <typename ValueType>
+int KeyLowerBound(const std::pair<GenericKey<8>, ValueType> *items, int begin, int end, const GenericKey<8> &key,
+                  const GenericComparator<8> &comparator) {
+  if (comparator.GetIntegerPrefixSize() == 0) {
+    return BinaryLowerBound(items, begin, end, key, comparator);
+  }
+  const int64_t prefix = comparator.IntegerPrefix(key);
+  const int first = IntegerPrefixBound(items, begin, end, prefix, false, comparator);
+  if (comparator.IsIntegerKey()) {
+    return first;
+  }
+  // 前缀相同的键由后面的列决定顺序
+  const int last = IntegerPrefixBound(items, first, end, prefix, true, comparator);
+  return BinaryLowerBound(items, first, last, key, comparator);
+}
+
+template <typename ValueType>
+int KeyUpperBound(const std::pair<GenericKey<8>, ValueType> *items, int begin, int end, const GenericKey<8> &key,
+                  const GenericComparator<8> &comparator) {
+  if (comparator.GetIntegerPrefixSize() == 0) {
+    return BinaryUpperBound(items, begin, end, key, comparator);
+  }
+  const int64_t prefix = comparator.IntegerPrefix(key);
+  const int last = IntegerPrefixBound(items, begin, end, prefix, true, comparator);
+  if (comparator.IsIntegerKey()) {
+    return last;
+  }
+  const int first = IntegerPrefixBound(items, begin, last, prefix, false, comparator);
+  return BinaryUpperBound(items, first, last, key, comparator);
+}
+
+}  // namespace bustub
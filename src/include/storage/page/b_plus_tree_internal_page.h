@@ -18,7 +18,7 @@ namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
 #define INTERNAL_PAGE_HEADER_SIZE 24              // 24是由  BPlusTreePage 的字段决定的
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))    // 实际是 k/v 个数
+#define INTERNAL_PAGE_SIZE ((PAGE_DATA_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))  // 实际是 k/v 个数
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -27,17 +30,27 @@ namespace bustub {
  * pin count, dirty flag, page id, etc.
  * 理解:
  *   1.Page 是RAM中缓冲区的基本单位;
- *   2.一个Page实体中,在不同时刻存放的Disk Page可能是不同的;Disk Page 即成员data_[];
+ *   2.一个Page实体中,在不同时刻存放的Disk Page可能是不同的;Disk Page 即 data_ 指向的 PAGE_SIZE 字节;
+ *     buffer pool 中的 Page 只是元数据, data_ 指向 FrameArena 中按页对齐的一块内存
  *   3.成员page_id_描述的是Disk Page的编号,如果当前Page实例中没有Disk Page,则page_id_设置为INVALID_PAGE_ID;
  *   4.pin_count_代表同时访问该页面的线程/进程数;
+ *   5.pin_count_ 为 -1 表示该 frame 空闲, 或者 buffer pool manager 正在置换/装入它; 只有这时才会修改 page_id_ 和 data_.
+ *     BufferPoolManager 的 fetch 命中路径不加锁, 通过 CAS 把 pin_count_ 从 k(>=0) 加到 k+1 来 pin 住页面.
  */
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class MmapBufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a standalone page, which owns its zeroed data. */
+  Page() : owned_data_(new char[PAGE_SIZE]{}), data_(owned_data_.get()) {}
+
+  /**
+   * Constructor of a buffer pool frame.
+   * @param data PAGE_SIZE zeroed bytes owned by the buffer pool
+   */
+  explicit Page(char *data) : data_(data) {}
 
   /** Default destructor. */
   ~Page() = default;
@@ -49,16 +62,22 @@ class Page {
   inline page_id_t GetPageId() { return page_id_; }
 
   /** @return the pin count of this page */
-  inline int GetPinCount() { return pin_count_; }
+  inline int GetPinCount() { return std::max(pin_count_.load(), 0); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline bool IsDirty() { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  /** Acquire the page write latch. The version becomes odd, so optimistic readers see that a writer is inside. */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_acq_rel);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -66,6 +85,28 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read of the page: nothing is written, so concurrent readers do not contend on the latch.
+   * The page may change while it is read, so the reader must not trust what it read (nor follow pointers or sizes
+   * outside the page) until ValidateOptimisticLatch() succeeds, and retry under RLatch() otherwise.
+   * @param[out] version the version to validate against
+   * @return false if a writer holds the write latch right now
+   */
+  inline bool TryOptimisticLatch(uint64_t *version) {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * Finish an optimistic read.
+   * @param version the version returned by TryOptimisticLatch()
+   * @return true if no writer latched the page since, i.e. everything read in between is consistent
+   */
+  inline bool ValidateOptimisticLatch(uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -79,6 +120,8 @@ class Page {
   static constexpr size_t SIZE_PAGE_HEADER = 8;
   static constexpr size_t OFFSET_PAGE_START = 0;
   static constexpr size_t OFFSET_LSN = 4;
+  // 页面最后 PAGE_CHECKSUM_SIZE 字节是 DiskManager 写盘时填入的 crc32c, 各种页面布局都只使用它之前的部分
+  static constexpr size_t OFFSET_CHECKSUM = PAGE_DATA_SIZE;
 
  private:
   /** Zeroes out the data that is held within the page. */
@@ -86,16 +129,23 @@ class Page {
     memset(data_, OFFSET_PAGE_START, PAGE_SIZE); 
   }
 
+  /** The data of a standalone page, nullptr for buffer pool frames. */
+  std::unique_ptr<char[]> owned_data_;
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  char *data_;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The pin count of this page, -1 while the frame is free or being loaded/evicted. */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
   /** Page latch. => 见 include/common/rwlatch.h */
   ReaderWriterLatch rwlatch_;
+  /**
+   * Incremented by WLatch() and WUnlatch(): odd while a writer holds the latch.
+   * 乐观读通过比较读之前和读之后的版本, 判断页面是否被修改过
+   */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
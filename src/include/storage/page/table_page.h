@@ -46,7 +46,7 @@ class TablePage : public Page {
   /**
    * Initialize the TablePage header.
    * @param page_id the page ID of this table page
-   * @param page_size the size of this table page
+   * @param page_size the size of this table page, PAGE_DATA_SIZE: the checksum trailer is not part of it
    * @param prev_page_id the previous table page ID
    * @param log_manager the log manager in use
    * @param txn the transaction that this page is created in
@@ -122,6 +122,15 @@ class TablePage : public Page {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
 
+  /**
+   * Read a tuple under an optimistic latch (see Page::TryOptimisticLatch()). Takes no locks and never aborts the
+   * transaction; the caller validates the page version afterwards and falls back to GetTuple() on failure.
+   * @param rid rid of the tuple to read
+   * @param[out] tuple the tuple that was read
+   * @return true if the tuple exists and its slot points inside the page
+   */
+  bool GetTupleOptimistic(const RID &rid, Tuple *tuple);
+
   /** @return the rid of the first tuple in this page */
 
   /**
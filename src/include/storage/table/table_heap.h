@@ -31,7 +31,7 @@ class TableHeap {
   ~TableHeap() = default;
 
   /**
-   * Create a table heap without a transaction. (open table)
+   * Create a table heap without a transaction. (open table) New pages go to the tablespace of the first page.
    * @param buffer_pool_manager the buffer pool manager
    * @param lock_manager the lock manager
    * @param log_manager the log manager
@@ -46,18 +46,21 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param tablespace_id the tablespace the pages of the table are stored in
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, tablespace_id_t tablespace_id = DEFAULT_TABLESPACE_ID);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
+   * @param strategy access strategy of a bulk insert, nullptr for a normal insert. A BULK_WRITE strategy also
+   *        remembers the page it appended to last, so the next insert starts there instead of at the first page.
    * @return true iff the insert is successful
    */
-  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn);
+  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -109,10 +112,18 @@ class TableHeap {
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
  private:
+  /** Fetch a page of this table, through strategy if it is not nullptr. */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /** Create a new page for this table from its extent, through strategy if it is not nullptr. */
+  Page *NewPage(page_id_t *page_id, BufferAccessStrategy *strategy);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** The pages of this table are allocated from its own extents, so that they are contiguous on disk. */
+  PageExtent extent_;
 };
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -24,6 +25,7 @@ class TableHeap;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
+ * It reads the pages through a SEQUENTIAL_SCAN access strategy, so a full scan does not flush the buffer pool.
  */
 class TableIterator {
   friend class Cursor;
@@ -32,7 +34,11 @@ class TableIterator {
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        prefetch_page_id_(other.prefetch_page_id_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,6 +58,8 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    prefetch_page_id_ = other.prefetch_page_id_;
     return *this;
   }
 
@@ -59,6 +67,10 @@ class TableIterator {
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The scan's private ring of frames. */
+  BufferAccessStrategy strategy_{AccessType::SEQUENTIAL_SCAN};
+  /** The page whose successors were read ahead last. */
+  page_id_t prefetch_page_id_ = INVALID_PAGE_ID;
 };
 
 }  // namespace bustub
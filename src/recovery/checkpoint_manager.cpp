@@ -21,6 +21,9 @@ void CheckpointManager::BeginCheckpoint() {
     transaction_manager_->BlockAllTransactions();
     log_manager_->FlushLog(true);
     buffer_pool_manager_->FlushAllPages();
+    if (!warm_start_file_.empty()) {
+      buffer_pool_manager_->SaveResidentPages(warm_start_file_);
+    }
 }
 
 void CheckpointManager::EndCheckpoint() {
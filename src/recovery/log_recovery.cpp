@@ -167,7 +167,7 @@ void LogRecovery::Redo() {
             // 如果有数据尚未写入
             if(page->GetLSN()<log_record.GetLSN()){
               page->WLatch();
-              page->Init(log_record.page_id_,PAGE_SIZE,log_record.prev_page_id_,nullptr,nullptr);
+              page->Init(log_record.page_id_,PAGE_DATA_SIZE,log_record.prev_page_id_,nullptr,nullptr);
               page->WUnlatch();
               if (log_record.prev_page_id_ != INVALID_PAGE_ID) { // 重要
                 auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(log_record.prev_page_id_));
@@ -10,116 +10,508 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+/** Transfer one contiguous buffer, see TransferAll. */
+static ssize_t TransferAll(int fd, char *data, size_t size, off_t offset, bool write) {
+  std::vector<struct iovec> iov{{data, size}};
+  return TransferAll(fd, &iov, offset, write);
+}
+
+/** fsync the directory of a file, e.g. to make a rename in it durable. */
+static bool SyncParentDirectory(const std::string &file_name) {
+  const std::string::size_type n = file_name.rfind('/');
+  const std::string dir_name = n == std::string::npos ? "." : n == 0 ? "/" : file_name.substr(0, n);
+  int fd = open(dir_name.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return false;
+  }
+  const bool ok = fsync(fd) == 0;
+  close(fd);
+  return ok;
+}
+
+/** A PAGE_SIZE aligned buffer, O_DIRECT transfers need aligned memory. */
+static std::shared_ptr<char> AllocateAligned(size_t size) {
+  return std::shared_ptr<char>(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, size)), &std::free);
+}
+
+/** @return true if every buffer of iov and its length is PAGE_SIZE aligned */
+static bool IsAligned(const std::vector<struct iovec> &iov) {
+  return std::all_of(iov.begin(), iov.end(), [](const struct iovec &v) {
+    return reinterpret_cast<uintptr_t>(v.iov_base) % PAGE_SIZE == 0 && v.iov_len % PAGE_SIZE == 0;
+  });
+}
+
+void DiskManager::SetPageChecksum(char *page_data) {
+  const uint32_t checksum = Crc32cUtil::Crc32c(page_data, PAGE_DATA_SIZE);
+  memcpy(page_data + PAGE_DATA_SIZE, &checksum, sizeof(checksum));
+}
+
+bool DiskManager::IsPageChecksumValid(const char *page_data) {
+  uint32_t checksum;
+  memcpy(&checksum, page_data + PAGE_DATA_SIZE, sizeof(checksum));
+  if (Crc32cUtil::Crc32c(page_data, PAGE_DATA_SIZE) == checksum) {
+    return true;
+  }
+  // 从没写过的页面(文件中的空洞、文件末尾之后)读出来全是 0, 它没有校验和
+  return page_data[0] == 0 && memcmp(page_data, page_data + 1, PAGE_SIZE - 1) == 0;
+}
+
+/**
+ * Raise a tracked file size to end if it is smaller
+ */
+static void ExtendFileSize(std::atomic<int64_t> *file_size, int64_t end) {
+  int64_t size = file_size->load(std::memory_order_relaxed);
+  while (size < end && !file_size->compare_exchange_weak(size, end, std::memory_order_relaxed)) {
+  }
+}
+
+DiskManager::DiskManager() { AddTablespace(""); }
+
 /**
- * Constructor: open/create a single database file & log file
+ * Constructor: open/create the database file (the default tablespace) & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, IOEngineType io_engine, bool direct_io,
+                         const std::string &log_file)
+    : file_name_(db_file), direct_io_(direct_io), io_engine_type_(io_engine) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
+    AddTablespace("");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
-
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
+  log_name_ = log_file.empty() ? file_name_.substr(0, n) + ".log" : log_file;
+
+  // 日志只追加写; 两个文件都不存在时创建
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0666);
+  if (log_fd_ < 0) {
+    throw Exception("can't open dblog file");
+  }
+  try {
+    AddTablespace(db_file);
+  } catch (const Exception &) {
+    close(log_fd_);
+    log_fd_ = -1;
+    throw;
+  }
+  log_file_size_ = GetFileSize(log_fd_);
+  buffer_used = nullptr;
+}
+
+DiskManager::~DiskManager() {
+  // 引擎析构时会等已经提交的请求做完, 必须在关闭文件之前
+  for (int i = 0; i < num_tablespaces_; i++) {
+    tablespaces_[i]->io_engine_.reset();
+  }
+  ShutDown();
+}
+
+tablespace_id_t DiskManager::CreateTablespace(const std::string &db_file) {
+  if (db_file.empty()) {
+    throw Exception("a tablespace needs a data file");
   }
+  return AddTablespace(db_file);
+}
+
+tablespace_id_t DiskManager::AddTablespace(const std::string &db_file) {
+  std::lock_guard<std::mutex> guard(tablespace_latch_);
+  const int tablespace_id = num_tablespaces_.load(std::memory_order_relaxed);
+  if (tablespace_id == MAX_TABLESPACES) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "too many tablespaces");
+  }
+  auto tablespace = std::make_unique<Tablespace>();
+  if (!db_file.empty()) {
+    OpenTablespace(tablespace.get(), db_file);
+  }
+  tablespaces_[tablespace_id] = std::move(tablespace);
+  num_tablespaces_.store(tablespace_id + 1, std::memory_order_release);
+  return tablespace_id;
+}
 
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+void DiskManager::OpenTablespace(Tablespace *tablespace, const std::string &db_file) {
+  tablespace->file_name_ = db_file;
+  const std::string::size_type n = db_file.rfind('.');
+  tablespace->fsm_name_ = (n == std::string::npos ? db_file : db_file.substr(0, n)) + ".fsm";
+  int fd = -1;
+  if (direct_io_) {
+    fd = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0666);
+    // 不支持 O_DIRECT 的文件系统(比如老版本的 tmpfs)在 open 时返回 EINVAL
+    tablespace->direct_io_ = fd >= 0;
+    if (fd < 0 && errno == EINVAL) {
+      LOG_DEBUG("O_DIRECT is not supported for %s, using buffered I/O", db_file.c_str());
     }
   }
-  buffer_used = nullptr;
+  if (fd < 0) {
+    fd = open(db_file.c_str(), O_RDWR | O_CREAT, 0666);
+  }
+  if (fd < 0) {
+    throw Exception("can't open db file");
+  }
+  tablespace->fd_ = fd;
+  // 文件大小只在打开时 stat 一次, 之后由写操作维护, 读的时候不再需要系统调用
+  tablespace->file_size_ = GetFileSize(fd);
+
+  // 新建(空)的数据文件从空的位图开始, 即使旧的 .fsm 文件还在. 已有的文件没有可用的位图时(比如它是这个功能之前
+  // 创建的), 其中的页面都当作已分配, 宁可浪费也不能把在用的页面再分配出去
+  const int64_t file_size = tablespace->file_size_;
+  const auto file_pages = static_cast<page_id_t>((file_size + PAGE_SIZE - 1) / PAGE_SIZE);
+  if (file_size > 0 && !LoadFreeSpaceMap(tablespace)) {
+    tablespace->free_space_map_.MarkAllocated(file_pages);
+  } else if (file_size > 0) {
+    // 位图只在 Sync/ShutDown 时保存, 崩溃前最后一次保存之后分配并写入的页面在位图之外, 它们也是在用的.
+    // (之后释放的页面会当作已分配, 只是浪费)
+    const page_id_t map_pages = tablespace->free_space_map_.GetNumPages();
+    tablespace->free_space_map_.MarkRangeAllocated(map_pages, file_pages - map_pages);
+  }
+}
+
+DiskManager::Tablespace *DiskManager::GetTablespace(page_id_t page_id) const {
+  const tablespace_id_t tablespace_id = GetTablespaceId(page_id);
+  if (tablespace_id >= num_tablespaces_.load(std::memory_order_acquire)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "page " + std::to_string(page_id) + " has no tablespace");
+  }
+  return tablespaces_[tablespace_id].get();
 }
 
 /**
- * Close all file streams
+ * Make the data files durable and close all files
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
-  log_io_.close();
+  for (int i = 0; i < num_tablespaces_; i++) {
+    Tablespace *tablespace = tablespaces_[i].get();
+    if (tablespace->fd_ >= 0) {
+      SaveFreeSpaceMap(tablespace);
+      fdatasync(tablespace->fd_);
+      close(tablespace->fd_);
+      tablespace->fd_ = -1;
+    }
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
+ * The write reaches the OS page cache; Sync() makes it durable
+ */
+void DiskManager::WritePage(page_id_t page_id, char *page_data) {
+  Tablespace *tablespace = GetTablespace(page_id);
+  auto offset = static_cast<off_t>(GetPageNo(page_id)) * PAGE_SIZE;
+  num_writes_ += 1;
+  SetPageChecksum(page_data);
+  std::vector<struct iovec> iov{{page_data, PAGE_SIZE}};
+  if (TransferPages(tablespace, &iov, offset, true) < 0) {
+    LOG_DEBUG("I/O error while writing");
+    return;
+  }
+  ExtendFileSize(&tablespace->file_size_, offset + PAGE_SIZE);
+}
+
+/**
+ * Write num_pages consecutive pages with one pwritev call per IOV_MAX pages
  */
-void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+void DiskManager::WritePages(page_id_t page_id, int num_pages, char *const *page_data) {
+  Tablespace *tablespace = GetTablespace(page_id);
+  std::vector<struct iovec> iov(num_pages);
+  for (int i = 0; i < num_pages; i++) {
+    SetPageChecksum(page_data[i]);
+    iov[i].iov_base = page_data[i];
+    iov[i].iov_len = PAGE_SIZE;
+  }
+  auto offset = static_cast<off_t>(GetPageNo(page_id)) * PAGE_SIZE;
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
+  if (TransferPages(tablespace, &iov, offset, true) < 0) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  ExtendFileSize(&tablespace->file_size_, offset + static_cast<off_t>(num_pages) * PAGE_SIZE);
+}
+
+/**
+ * Force the pages written so far to disk, every data file with its own fdatasync
+ */
+void DiskManager::Sync() {
+  for (int i = 0; i < num_tablespaces_; i++) {
+    Tablespace *tablespace = tablespaces_[i].get();
+    if (tablespace->fd_ >= 0 && fdatasync(tablespace->fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing %s", tablespace->file_name_.c_str());
+    }
+    SaveFreeSpaceMap(tablespace);
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+  Tablespace *tablespace = GetTablespace(page_id);
+  auto offset = static_cast<off_t>(GetPageNo(page_id)) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset > tablespace->file_size_.load(std::memory_order_relaxed)) {
     LOG_DEBUG("I/O error reading past end of file");
     // std::cerr << "I/O error while reading" << std::endl;
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+    std::vector<struct iovec> iov{{page_data, PAGE_SIZE}};
+    ssize_t read_count = TransferPages(tablespace, &iov, offset, false);
+    if (read_count < 0) {
       LOG_DEBUG("I/O error while reading");
       return;
     }
     // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
     if (read_count < PAGE_SIZE) {
       LOG_DEBUG("Read less than a page");
-      db_io_.clear();
       // std::cerr << "Read less than a page" << std::endl;
       memset(page_data + read_count, 0, PAGE_SIZE - read_count);
     }
+    VerifyPages(page_id, 1, &page_data);
+  }
+}
+
+/**
+ * Read num_pages consecutive pages into the given memory area, pages past the end of file are zeroed
+ */
+void DiskManager::ReadPages(page_id_t page_id, int num_pages, char *page_data) {
+  Tablespace *tablespace = GetTablespace(page_id);
+  auto offset = static_cast<off_t>(GetPageNo(page_id)) * PAGE_SIZE;
+  size_t size = static_cast<size_t>(num_pages) * PAGE_SIZE;
+  ssize_t read_count = 0;
+  if (offset > tablespace->file_size_.load(std::memory_order_relaxed)) {
+    LOG_DEBUG("I/O error reading past end of file");
+  } else {
+    std::vector<struct iovec> iov{{page_data, size}};
+    read_count = TransferPages(tablespace, &iov, offset, false);
+    if (read_count < 0) {
+      LOG_DEBUG("I/O error while reading");
+      return;
+    }
+  }
+  if (static_cast<size_t>(read_count) < size) {
+    memset(page_data + read_count, 0, size - read_count);
+  }
+  std::vector<char *> pages(num_pages);
+  for (int i = 0; i < num_pages; i++) {
+    pages[i] = page_data + static_cast<size_t>(i) * PAGE_SIZE;
   }
+  VerifyPages(page_id, num_pages, pages.data());
+}
+
+/**
+ * Read num_pages consecutive pages into separate buffers with one preadv call per IOV_MAX pages
+ */
+void DiskManager::ReadPages(page_id_t page_id, int num_pages, char *const *page_data) {
+  Tablespace *tablespace = GetTablespace(page_id);
+  std::vector<struct iovec> iov(num_pages);
+  for (int i = 0; i < num_pages; i++) {
+    iov[i].iov_base = page_data[i];
+    iov[i].iov_len = PAGE_SIZE;
+  }
+  ssize_t read_count = TransferPages(tablespace, &iov, static_cast<off_t>(GetPageNo(page_id)) * PAGE_SIZE, false);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    read_count = 0;
+  }
+  // 文件末尾之后的页面清零
+  for (int i = 0; i < num_pages; i++) {
+    const ssize_t page_read = std::clamp<ssize_t>(read_count - static_cast<ssize_t>(i) * PAGE_SIZE, 0, PAGE_SIZE);
+    if (page_read < PAGE_SIZE) {
+      memset(page_data[i] + page_read, 0, PAGE_SIZE - page_read);
+    }
+  }
+  VerifyPages(page_id, num_pages, page_data);
+}
+
+/**
+ * Count every page that fails its checksum, then report the first one
+ */
+void DiskManager::VerifyPages(page_id_t page_id, int num_pages, const char *const *page_data) {
+  page_id_t corrupted = INVALID_PAGE_ID;
+  for (int i = 0; i < num_pages; i++) {
+    if (!IsPageChecksumValid(page_data[i])) {
+      num_checksum_failures_.fetch_add(1, std::memory_order_relaxed);
+      corrupted = corrupted == INVALID_PAGE_ID ? page_id + i : corrupted;
+    }
+  }
+  if (corrupted != INVALID_PAGE_ID) {
+    throw CorruptedPageException(corrupted);
+  }
+}
+
+/**
+ * O_DIRECT reads and writes the caller's memory directly, which must be aligned. Page frames are, other buffers
+ * (stack buffers, copies) are copied through an aligned bounce buffer
+ */
+ssize_t DiskManager::TransferPages(Tablespace *tablespace, std::vector<struct iovec> *iov, off_t offset, bool write) {
+  if (!tablespace->direct_io_.load(std::memory_order_relaxed)) {
+    return TransferAll(tablespace->fd_, iov, offset, write);
+  }
+  std::shared_ptr<char> bounce;
+  std::vector<struct iovec> bounce_iov;
+  std::vector<struct iovec> *target = iov;
+  if (!IsAligned(*iov)) {
+    size_t size = 0;
+    for (const auto &v : *iov) {
+      size += v.iov_len;
+    }
+    const size_t aligned_size = (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    bounce = AllocateAligned(aligned_size);
+    bounce_iov.push_back({bounce.get(), aligned_size});
+    if (write) {
+      char *dst = bounce.get();
+      for (const auto &v : *iov) {
+        memcpy(dst, v.iov_base, v.iov_len);
+        dst += v.iov_len;
+      }
+      memset(dst, 0, aligned_size - size);
+    }
+    target = &bounce_iov;
+  }
+  std::vector<struct iovec> retry = *target;
+  ssize_t n = TransferAll(tablespace->fd_, target, offset, write);
+  if (n < 0 && errno == EINVAL) {
+    // 有的文件系统 open 时接受 O_DIRECT, 读写时才拒绝: 去掉这个标志, 之后都走 OS 缓存
+    LOG_DEBUG("O_DIRECT transfer rejected, using buffered I/O");
+    tablespace->direct_io_ = false;
+    fcntl(tablespace->fd_, F_SETFL, fcntl(tablespace->fd_, F_GETFL) & ~O_DIRECT);
+    n = TransferAll(tablespace->fd_, &retry, offset, write);
+  }
+  if (!write && bounce != nullptr && n > 0) {
+    const char *src = bounce.get();
+    size_t remaining = n;
+    for (const auto &v : *iov) {
+      const size_t count = std::min(remaining, v.iov_len);
+      memcpy(v.iov_base, src, count);
+      src += count;
+      remaining -= count;
+    }
+  }
+  return n;
+}
+
+IOEngine *DiskManager::GetIOEngine(Tablespace *tablespace) {
+  std::call_once(tablespace->io_engine_once_, [&] { tablespace->io_engine_ = IOEngine::Create(io_engine_type_); });
+  return tablespace->io_engine_.get();
+}
+
+IOEngineType DiskManager::GetIOEngineType() {
+  return GetIOEngine(tablespaces_[DEFAULT_TABLESPACE_ID].get())->GetType();
+}
+
+std::future<bool> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  return SubmitPages(page_id, 1, &page_data, false);
+}
+
+std::future<bool> DiskManager::ReadPagesAsync(page_id_t page_id, int num_pages, char *const *page_data) {
+  return SubmitPages(page_id, num_pages, page_data, false);
+}
+
+std::future<bool> DiskManager::WritePageAsync(page_id_t page_id, char *page_data) {
+  return SubmitPages(page_id, 1, &page_data, true);
+}
+
+std::future<bool> DiskManager::WritePagesAsync(page_id_t page_id, int num_pages, char *const *page_data) {
+  return SubmitPages(page_id, num_pages, page_data, true);
+}
+
+/**
+ * Hand one vectored read or write to the I/O engine of the tablespace. The completion runs on an engine thread: it
+ * keeps the file size up to date after a write and zeroes the pages past the end of file and verifies the checksums
+ * after a read, like the synchronous versions. A checksum failure is handed to the future as its exception
+ */
+std::future<bool> DiskManager::SubmitPages(page_id_t page_id, int num_pages, char *const *page_data, bool write) {
+  Tablespace *tablespace = GetTablespace(page_id);
+  auto done = std::make_shared<std::promise<bool>>();
+  std::future<bool> future = done->get_future();
+  const auto offset = static_cast<off_t>(GetPageNo(page_id)) * PAGE_SIZE;
+  std::vector<char *> pages(page_data, page_data + num_pages);
+
+  IORequest request;
+  request.fd_ = tablespace->fd_;
+  request.offset_ = offset;
+  request.write_ = write;
+  for (char *data : pages) {
+    if (write) {
+      SetPageChecksum(data);
+    }
+    request.iov_.push_back({data, PAGE_SIZE});
+  }
+  // O_DIRECT 不能直接使用的缓冲区经过 bounce buffer 中转, 它要活到请求完成
+  std::shared_ptr<char> bounce;
+  if (tablespace->direct_io_.load(std::memory_order_relaxed) && !IsAligned(request.iov_)) {
+    bounce = AllocateAligned(static_cast<size_t>(num_pages) * PAGE_SIZE);
+    for (int i = 0; write && i < num_pages; i++) {
+      memcpy(bounce.get() + static_cast<size_t>(i) * PAGE_SIZE, pages[i], PAGE_SIZE);
+    }
+    request.iov_ = {{bounce.get(), static_cast<size_t>(num_pages) * PAGE_SIZE}};
+  }
+  if (write) {
+    num_writes_ += 1;
+    request.on_complete_ = [tablespace, done, offset, num_pages, bounce](ssize_t n) {
+      if (n < 0) {
+        LOG_DEBUG("I/O error while writing");
+        done->set_value(false);
+        return;
+      }
+      ExtendFileSize(&tablespace->file_size_, offset + static_cast<off_t>(num_pages) * PAGE_SIZE);
+      done->set_value(true);
+    };
+  } else {
+    request.on_complete_ = [this, done, page_id, pages = std::move(pages), bounce](ssize_t n) {
+      const bool ok = n >= 0;
+      if (!ok) {
+        LOG_DEBUG("I/O error while reading");
+        n = 0;
+      }
+      for (size_t i = 0; i < pages.size(); i++) {
+        const ssize_t page_read = std::clamp<ssize_t>(n - static_cast<ssize_t>(i) * PAGE_SIZE, 0, PAGE_SIZE);
+        if (bounce != nullptr) {
+          memcpy(pages[i], bounce.get() + i * PAGE_SIZE, page_read);
+        }
+        if (page_read < PAGE_SIZE) {
+          memset(pages[i] + page_read, 0, PAGE_SIZE - page_read);
+        }
+      }
+      try {
+        VerifyPages(page_id, static_cast<int>(pages.size()), pages.data());
+      } catch (const CorruptedPageException &) {
+        done->set_exception(std::current_exception());
+        return;
+      }
+      done->set_value(ok);
+    };
+  }
+  std::vector<IORequest> requests;
+  requests.emplace_back(std::move(request));
+  GetIOEngine(tablespace)->Submit(std::move(requests));
+  return future;
 }
 
 /**
@@ -143,16 +535,25 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
+  // sequence write: log_fd_ 以 O_APPEND 打开, 每次 write 都追加到文件末尾
+  for (int written = 0; written < size;) {
+    ssize_t n = write(log_fd_, log_data + written, size - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing log");
+      return;
+    }
+    written += n;
+  }
+  log_file_size_ += size;
+  // needs to sync to make the log durable before returning
+  if (fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log");
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
   flush_log_ = false;
 }
 
@@ -162,40 +563,132 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * @return: false means already reach the end
  */
 bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
+  const int64_t log_file_size = log_file_size_.load(std::memory_order_relaxed);
+  if (offset >= log_file_size) {
     LOG_DEBUG("end of log file");
-    LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+    LOG_DEBUG("file size is %ld", log_file_size);
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
+  ssize_t read_count = TransferAll(log_fd_, log_data, size, offset, false);
+  if (read_count < 0) {
     LOG_DEBUG("I/O error while reading log");
     return false;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
   return true;
 }
 
+/**
+ * The default tablespace has 2^31 page numbers, the others 2^TABLESPACE_PAGE_BITS. Runs of consecutive pages are cut
+ * at the end of a tablespace by IsNextPage, so its last page number can be allocated too
+ */
+page_id_t DiskManager::ToAllocatedPageId(tablespace_id_t tablespace_id, page_id_t page_no, int num_pages) {
+  const int page_bits = tablespace_id == DEFAULT_TABLESPACE_ID ? 31 : TABLESPACE_PAGE_BITS;
+  if (static_cast<int64_t>(page_no) + num_pages > static_cast<int64_t>(1) << page_bits) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "tablespace " + std::to_string(tablespace_id) + " is full");
+  }
+  return MakePageId(tablespace_id, page_no);
+}
+
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * The lowest free page of the free space map, the file only grows when there is none
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() { return AllocatePage(1, 0); }
+
+page_id_t DiskManager::AllocatePage(uint32_t stride, uint32_t offset) {
+  Tablespace *tablespace = tablespaces_[DEFAULT_TABLESPACE_ID].get();
+  const page_id_t page_no = tablespace->free_space_map_.Allocate(stride, offset);
+  const page_id_t page_id = ToAllocatedPageId(DEFAULT_TABLESPACE_ID, page_no, 1);
+  // 位图只在 Sync/ShutDown 时保存, 分配时不做任何 I/O(调用者可能持有 buffer pool 的 latch)
+  tablespace->fsm_dirty_.store(true, std::memory_order_release);
+  return page_id;
+}
+
+page_id_t DiskManager::AllocateExtent(int num_pages, tablespace_id_t tablespace_id) {
+  Tablespace *tablespace = GetTablespace(MakePageId(tablespace_id, 0));
+  const page_id_t page_id =
+      ToAllocatedPageId(tablespace_id, tablespace->free_space_map_.AllocateExtent(num_pages), num_pages);
+  tablespace->fsm_dirty_.store(true, std::memory_order_release);
+  return page_id;
+}
+
+page_id_t DiskManager::ReserveExtent(int num_pages, tablespace_id_t tablespace_id) {
+  Tablespace *tablespace = GetTablespace(MakePageId(tablespace_id, 0));
+  // 预留的页面仍是空闲的, 不需要保存位图
+  return ToAllocatedPageId(tablespace_id, tablespace->free_space_map_.ReserveExtent(num_pages), num_pages);
+}
+
+page_id_t DiskManager::AllocatePageInExtent(page_id_t extent, int num_pages) {
+  Tablespace *tablespace = GetTablespace(extent);
+  const page_id_t page_no = tablespace->free_space_map_.AllocateInRange(GetPageNo(extent), num_pages);
+  if (page_no == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  tablespace->fsm_dirty_.store(true, std::memory_order_release);
+  return MakePageId(GetTablespaceId(extent), page_no);
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * The page is marked free in the map of its tablespace and will be reused by AllocatePage
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  Tablespace *tablespace = GetTablespace(page_id);
+  tablespace->free_space_map_.Free(GetPageNo(page_id));
+  tablespace->fsm_dirty_.store(true, std::memory_order_release);
+}
+
+bool DiskManager::LoadFreeSpaceMap(Tablespace *tablespace) {
+  int fd = open(tablespace->fsm_name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  std::vector<char> data(GetFileSize(fd));
+  const ssize_t read_count = TransferAll(fd, data.data(), data.size(), 0, false);
+  close(fd);
+  return read_count == static_cast<ssize_t>(data.size()) && tablespace->free_space_map_.Deserialize(data);
+}
+
+/**
+ * Write the map to a temporary file and rename it over the old one, so a crash leaves either the old or the new map.
+ * A map that has not changed since the last save is not written again
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::SaveFreeSpaceMap(Tablespace *tablespace) {
+  if (tablespace->fsm_name_.empty()) {
+    return;
+  }
+  // 在 fsm_file_latch_ 中清除 dirty: 并发的 Sync 看到 false 时, 另一个线程已经把位图保存完了.
+  // 清除之后的修改会重新设置 dirty, 留给下一次保存
+  std::lock_guard<std::mutex> guard(tablespace->fsm_file_latch_);
+  if (!tablespace->fsm_dirty_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  std::vector<char> data = tablespace->free_space_map_.Serialize();
+  const std::string tmp_name = tablespace->fsm_name_ + ".tmp";
+  int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    LOG_DEBUG("can't open free space map file");
+    return;
+  }
+  const bool ok = TransferAll(fd, data.data(), data.size(), 0, true) == static_cast<ssize_t>(data.size()) &&
+                  fdatasync(fd) == 0;
+  close(fd);
+  if (!ok || rename(tmp_name.c_str(), tablespace->fsm_name_.c_str()) != 0) {
+    LOG_DEBUG("I/O error while saving the free space map");
+    remove(tmp_name.c_str());
+    tablespace->fsm_dirty_.store(true, std::memory_order_release);
+    return;
+  }
+  // rename 修改的是目录, 目录也要 fsync, 否则崩溃后可能还是旧的位图
+  if (!SyncParentDirectory(tablespace->fsm_name_)) {
+    LOG_DEBUG("I/O error while syncing the directory of %s", tablespace->fsm_name_.c_str());
+  }
+}
 
 /**
  * Returns number of flushes made so far
@@ -213,12 +706,12 @@ int DiskManager::GetNumWrites() const { return num_writes_; }
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
 /**
- * Private helper function to get disk file size
+ * Private helper function to get disk file size, only used when the file is opened
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(int fd) {
   struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  int rc = fstat(fd, &stat_buf);
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : 0;
 }
 
 }  // namespace bustub
@@ -0,0 +1,236 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/disk/free_space_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+uint64_t FreeSpaceMap::CandidateMask(size_t w, uint32_t stride, uint32_t offset) const {
+  const auto first = static_cast<page_id_t>(w) * BITS_PER_WORD;
+  uint64_t mask = ~static_cast<uint64_t>(0);
+  if (num_pages_ - first < BITS_PER_WORD) {  // 最后一个 word 只有一部分页面有效
+    mask = (static_cast<uint64_t>(1) << (num_pages_ - first)) - 1;
+  }
+  if (stride == 1) {
+    return mask;
+  }
+  uint64_t stripe = 0;
+  // 本 word 中第一个 page_id % stride == offset 的位置, 之后每隔 stride 一个
+  for (auto b = static_cast<page_id_t>((offset + stride - static_cast<uint32_t>(first) % stride) % stride);
+       b < BITS_PER_WORD; b += static_cast<page_id_t>(stride)) {
+    stripe |= static_cast<uint64_t>(1) << b;
+  }
+  return mask & stripe;
+}
+
+void FreeSpaceMap::SetAllocated(page_id_t page_id, bool allocated) {
+  const uint64_t bit = static_cast<uint64_t>(1) << (page_id % BITS_PER_WORD);
+  if (allocated) {
+    words_[page_id / BITS_PER_WORD] |= bit;
+  } else {
+    words_[page_id / BITS_PER_WORD] &= ~bit;
+  }
+}
+
+void FreeSpaceMap::Extend(page_id_t num_pages) {
+  num_pages_ = num_pages;
+  words_.resize((num_pages_ + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
+  reserved_.resize(words_.size(), 0);
+}
+
+uint64_t FreeSpaceMap::RangeMask(page_id_t page_id, page_id_t first, page_id_t num_pages) {
+  const page_id_t bit = page_id % BITS_PER_WORD;
+  const page_id_t count = std::min(BITS_PER_WORD - bit, first + num_pages - page_id);
+  return (count == BITS_PER_WORD ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << count) - 1) << bit;
+}
+
+page_id_t FreeSpaceMap::Allocate(uint32_t stride, uint32_t offset, bool *reused) {
+  BUSTUB_ASSERT(stride > 0 && offset < stride, "invalid page id stripe");
+  std::lock_guard<std::mutex> guard(latch_);
+  // hint 之前的 word 中没有这个余数的空闲页面; 整个 word 已分配时跳过它只需要一次比较.
+  // 预留给 extent 的页面只能由它的所有者分配, 和已分配的页面一样跳过
+  size_t &hint = hints_[{stride, offset}];
+  for (; hint < words_.size(); hint++) {
+    const uint64_t free = ~(words_[hint] | reserved_[hint]) & CandidateMask(hint, stride, offset);
+    if (free != 0) {
+      const auto page_id = static_cast<page_id_t>(hint) * BITS_PER_WORD + __builtin_ctzll(free);
+      SetAllocated(page_id, true);
+      if (reused != nullptr) {
+        *reused = true;
+      }
+      return page_id;
+    }
+  }
+  // 没有空闲页面, 在文件末尾之后分配第一个余数为 offset 的页面
+  const page_id_t page_id =
+      num_pages_ + static_cast<page_id_t>((offset + stride - static_cast<uint32_t>(num_pages_) % stride) % stride);
+  Extend(page_id + 1);
+  SetAllocated(page_id, true);
+  hint = page_id / BITS_PER_WORD;
+  if (reused != nullptr) {
+    *reused = false;
+  }
+  return page_id;
+}
+
+bool FreeSpaceMap::IsRangeFree(page_id_t first, page_id_t num_pages) const {
+  // 逐个 word 检查, 每个 word 只取落在范围内的位
+  for (page_id_t page_id = first; page_id < first + num_pages;
+       page_id = (page_id / BITS_PER_WORD + 1) * BITS_PER_WORD) {
+    const size_t w = page_id / BITS_PER_WORD;
+    if (((words_[w] | reserved_[w]) & RangeMask(page_id, first, num_pages)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+page_id_t FreeSpaceMap::FindExtent(page_id_t num_pages, bool *reused) {
+  BUSTUB_ASSERT(num_pages > 0, "empty extent");
+  // 先找已有的完全空闲的对齐 extent(比如删掉的表留下的), 找不到再在末尾扩展.
+  // extent 很少分配(每 num_pages 个页面一次), 所以这里直接线性扫描
+  page_id_t first = 0;
+  for (; first + num_pages <= num_pages_; first += num_pages) {
+    if (IsRangeFree(first, num_pages)) {
+      break;
+    }
+  }
+  const bool found = first + num_pages <= num_pages_;
+  if (!found) {
+    first = (num_pages_ + num_pages - 1) / num_pages * num_pages;
+    Extend(first + num_pages);
+  }
+  if (reused != nullptr) {
+    *reused = found;
+  }
+  return first;
+}
+
+page_id_t FreeSpaceMap::AllocateExtent(page_id_t num_pages, bool *reused) {
+  std::lock_guard<std::mutex> guard(latch_);
+  const page_id_t first = FindExtent(num_pages, reused);
+  for (page_id_t page_id = first; page_id < first + num_pages; page_id++) {
+    SetAllocated(page_id, true);
+  }
+  return first;
+}
+
+page_id_t FreeSpaceMap::ReserveExtent(page_id_t num_pages) {
+  std::lock_guard<std::mutex> guard(latch_);
+  const page_id_t first = FindExtent(num_pages, nullptr);
+  for (page_id_t page_id = first; page_id < first + num_pages; page_id++) {
+    reserved_[page_id / BITS_PER_WORD] |= static_cast<uint64_t>(1) << (page_id % BITS_PER_WORD);
+  }
+  return first;
+}
+
+page_id_t FreeSpaceMap::AllocateInRange(page_id_t first, page_id_t num_pages) {
+  std::lock_guard<std::mutex> guard(latch_);
+  const page_id_t end = std::min(first + num_pages, num_pages_);
+  for (page_id_t page_id = std::max<page_id_t>(first, 0); page_id < end;
+       page_id = (page_id / BITS_PER_WORD + 1) * BITS_PER_WORD) {
+    const uint64_t free = ~words_[page_id / BITS_PER_WORD] & RangeMask(page_id, first, end - first);
+    if (free != 0) {
+      const auto free_page_id = static_cast<page_id_t>(page_id / BITS_PER_WORD * BITS_PER_WORD) + __builtin_ctzll(free);
+      SetAllocated(free_page_id, true);
+      return free_page_id;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::Free(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (page_id < 0 || page_id >= num_pages_) {
+    return;
+  }
+  SetAllocated(page_id, false);
+  const size_t w = page_id / BITS_PER_WORD;
+  for (auto &hint : hints_) {
+    hint.second = std::min(hint.second, w);
+  }
+}
+
+bool FreeSpaceMap::IsAllocated(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (page_id < 0 || page_id >= num_pages_) {
+    return false;
+  }
+  return (words_[page_id / BITS_PER_WORD] >> (page_id % BITS_PER_WORD) & 1) != 0;
+}
+
+void FreeSpaceMap::MarkAllocated(page_id_t num_pages) { MarkRangeAllocated(0, num_pages); }
+
+void FreeSpaceMap::MarkRangeAllocated(page_id_t first, page_id_t num_pages) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (first < 0 || num_pages <= 0) {
+    return;
+  }
+  if (first + num_pages > num_pages_) {
+    Extend(first + num_pages);
+  }
+  for (page_id_t page_id = first; page_id < first + num_pages; page_id++) {
+    SetAllocated(page_id, true);
+  }
+}
+
+page_id_t FreeSpaceMap::GetNumPages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return num_pages_;
+}
+
+size_t FreeSpaceMap::GetNumFreePages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  size_t allocated = 0;
+  for (uint64_t word : words_) {
+    allocated += __builtin_popcountll(word);
+  }
+  return num_pages_ - allocated;
+}
+
+std::vector<char> FreeSpaceMap::Serialize() {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<char> data(sizeof(MAGIC) + sizeof(num_pages_) + words_.size() * sizeof(uint64_t));
+  memcpy(data.data(), &MAGIC, sizeof(MAGIC));
+  memcpy(data.data() + sizeof(MAGIC), &num_pages_, sizeof(num_pages_));
+  memcpy(data.data() + sizeof(MAGIC) + sizeof(num_pages_), words_.data(), words_.size() * sizeof(uint64_t));
+  return data;
+}
+
+bool FreeSpaceMap::Deserialize(const std::vector<char> &data) {
+  uint32_t magic;
+  page_id_t num_pages;
+  const size_t header_size = sizeof(magic) + sizeof(num_pages);
+  if (data.size() < header_size) {
+    return false;
+  }
+  memcpy(&magic, data.data(), sizeof(magic));
+  memcpy(&num_pages, data.data() + sizeof(magic), sizeof(num_pages));
+  const size_t num_words = num_pages < 0 ? 0 : (num_pages + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  if (magic != MAGIC || num_pages < 0 || data.size() != header_size + num_words * sizeof(uint64_t)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  num_pages_ = num_pages;
+  words_.assign(num_words, 0);
+  memcpy(words_.data(), data.data() + header_size, num_words * sizeof(uint64_t));
+  reserved_.assign(num_words, 0);
+  hints_.clear();
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,324 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_engine.cpp
+//
+// Identification: src/storage/disk/io_engine.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_engine.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+ssize_t TransferAll(int fd, std::vector<struct iovec> *iov, off_t offset, bool write) {
+  ssize_t total = 0;
+  size_t done = 0;
+  while (done < iov->size()) {
+    const int count = static_cast<int>(std::min<size_t>(iov->size() - done, IOV_MAX));
+    ssize_t n = write ? pwritev(fd, &(*iov)[done], count, offset) : preadv(fd, &(*iov)[done], count, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {  // 读到了文件末尾, 或者出错
+      return n < 0 ? -1 : total;
+    }
+    offset += n;
+    total += n;
+    // 跳过已经传输完的 iovec, 剩下的从中间继续
+    while (done < iov->size() && n >= static_cast<ssize_t>((*iov)[done].iov_len)) {
+      n -= (*iov)[done].iov_len;
+      done++;
+    }
+    if (n > 0) {
+      (*iov)[done].iov_base = static_cast<char *>((*iov)[done].iov_base) + n;
+      (*iov)[done].iov_len -= n;
+    }
+  }
+  return total;
+}
+
+/** Run a request synchronously on the calling thread. */
+static void ExecuteRequest(IORequest *request) {
+  const ssize_t n = TransferAll(request->fd_, &request->iov_, request->offset_, request->write_);
+  request->on_complete_(n);
+}
+
+std::unique_ptr<IOEngine> IOEngine::Create(IOEngineType type, size_t queue_depth) {
+  if (type == IOEngineType::IO_URING) {
+    try {
+      return std::make_unique<IoUringIOEngine>(queue_depth);
+    } catch (Exception &e) {
+      // 内核太老, 或者 io_uring 被禁用了(比如容器的 seccomp 策略), 退回到线程池
+      LOG_DEBUG("io_uring is not available, using the thread pool engine");
+    }
+  }
+  return std::make_unique<ThreadPoolIOEngine>();
+}
+
+/*****************************************************************************
+ * THREAD POOL
+ *****************************************************************************/
+ThreadPoolIOEngine::ThreadPoolIOEngine(size_t num_threads) {
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&ThreadPoolIOEngine::Worker, this);
+  }
+}
+
+ThreadPoolIOEngine::~ThreadPoolIOEngine() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPoolIOEngine::Submit(std::vector<IORequest> requests) {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (auto &request : requests) {
+      pending_.emplace_back(std::move(request));
+    }
+  }
+  cv_.notify_all();
+}
+
+void ThreadPoolIOEngine::Worker() {
+  while (true) {
+    std::unique_lock<std::mutex> lock(latch_);
+    cv_.wait(lock, [&] { return stop_ || !pending_.empty(); });
+    if (pending_.empty()) {  // 停止时先把已经提交的请求做完
+      return;
+    }
+    IORequest request = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+    ExecuteRequest(&request);
+  }
+}
+
+/*****************************************************************************
+ * IO_URING
+ *****************************************************************************/
+IoUringIOEngine::IoUringIOEngine(size_t queue_depth) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth), &params));
+  if (ring_fd_ < 0) {
+    throw Exception("can't set up io_uring");
+  }
+
+  // 提交队列, 完成队列和 SQE 数组都是和内核共享的内存, 5.4 之后的内核中两个队列可以一次映射
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+  } else if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_CQ_RING);
+    cq_ring_ = cq_ring_ == MAP_FAILED ? nullptr : cq_ring_;
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  sqes_ = sqes == MAP_FAILED ? nullptr : static_cast<struct io_uring_sqe *>(sqes);
+  if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+    UnmapRing();
+    throw Exception("can't map io_uring");
+  }
+
+  char *sq = static_cast<char *>(sq_ring_);
+  char *cq = static_cast<char *>(cq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+  // 在途请求数不超过 SQ 的大小, 完成队列(至少是 SQ 的两倍大)就不会溢出
+  slots_.resize(std::min<size_t>(queue_depth, params.sq_entries));
+  for (size_t i = slots_.size(); i > 0; i--) {
+    free_slots_.push_back(static_cast<unsigned>(i - 1));
+  }
+  ring_thread_ = std::thread(&IoUringIOEngine::RingWorker, this);
+}
+
+IoUringIOEngine::~IoUringIOEngine() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  ring_thread_.join();
+  UnmapRing();
+}
+
+void IoUringIOEngine::UnmapRing() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  sqes_ = nullptr;
+  sq_ring_ = cq_ring_ = nullptr;
+  close(ring_fd_);
+  ring_fd_ = -1;
+}
+
+void IoUringIOEngine::Submit(std::vector<IORequest> requests) {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (auto &request : requests) {
+      pending_.emplace_back(std::move(request));
+    }
+  }
+  cv_.notify_one();
+}
+
+void IoUringIOEngine::RingWorker() {
+  size_t in_flight = 0;    // 已经放进 SQ 还没有完成的请求
+  unsigned unsubmitted = 0;  // 已经放进 SQ 但 io_uring_enter 还没有提交给内核的请求
+  std::vector<IORequest> batch;
+  std::vector<std::unique_ptr<IORequest>> completed;
+  while (true) {
+    batch.clear();
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      if (in_flight == 0) {
+        cv_.wait(lock, [&] { return stop_ || !pending_.empty(); });
+        if (pending_.empty()) {  // 停止时先把已经提交的请求做完
+          return;
+        }
+      }
+      // 一次取走空闲 slot 能容纳的全部请求, 它们用一次 io_uring_enter 提交
+      while (!pending_.empty() && batch.size() < free_slots_.size()) {
+        batch.emplace_back(std::move(pending_.front()));
+        pending_.pop_front();
+      }
+    }
+
+    unsigned tail = *sq_tail_;  // SQ 的 tail 只有这个线程写
+    for (auto &request : batch) {
+      if (request.iov_.empty() || request.iov_.size() > IOV_MAX) {  // 内核不接受的请求直接同步执行
+        ExecuteRequest(&request);
+        continue;
+      }
+      const unsigned slot = free_slots_.back();
+      free_slots_.pop_back();
+      slots_[slot] = std::make_unique<IORequest>(std::move(request));
+      const IORequest &r = *slots_[slot];
+      const unsigned index = tail & *sq_mask_;
+      struct io_uring_sqe *sqe = &sqes_[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = r.write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->fd = r.fd_;
+      sqe->off = static_cast<uint64_t>(r.offset_);
+      sqe->addr = reinterpret_cast<uint64_t>(r.iov_.data());
+      sqe->len = static_cast<uint32_t>(r.iov_.size());
+      sqe->user_data = slot;
+      sq_array_[index] = index;
+      tail++;
+      in_flight++;
+      unsubmitted++;
+    }
+    // SQE 的内容必须先于新的 tail 对内核可见
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    if (in_flight == 0) {
+      continue;
+    }
+
+    // 提交新请求; 没有新请求时阻塞到至少一个请求完成
+    const unsigned min_complete = unsubmitted == 0 ? 1 : 0;
+    const int ret = static_cast<int>(
+        syscall(__NR_io_uring_enter, ring_fd_, unsubmitted, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (ret >= 0) {
+      unsubmitted -= std::min<unsigned>(unsubmitted, ret);
+    } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+    }
+
+    // 先收走所有的 CQE 并归还 CQ 中的位置, 再执行完成回调
+    unsigned head = *cq_head_;
+    const unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    std::vector<int> results;
+    for (; head != cq_tail; head++) {
+      const struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      const auto slot = static_cast<unsigned>(cqe->user_data);
+      completed.emplace_back(std::move(slots_[slot]));
+      results.push_back(cqe->res);
+      free_slots_.push_back(slot);
+      in_flight--;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < completed.size(); i++) {
+      Complete(completed[i].get(), results[i]);
+    }
+    completed.clear();
+  }
+}
+
+void IoUringIOEngine::Complete(IORequest *request, int res) {
+  if (res == -EINTR || res == -EAGAIN) {  // 请求没有执行, 同步重做
+    ExecuteRequest(request);
+    return;
+  }
+  if (res < 0) {
+    request->on_complete_(-1);
+    return;
+  }
+  size_t requested = 0;
+  for (const auto &iov : request->iov_) {
+    requested += iov.iov_len;
+  }
+  if (static_cast<size_t>(res) == requested || (res == 0 && !request->write_)) {
+    request->on_complete_(res);
+    return;
+  }
+  // 只传输了一部分, 剩下的同步完成. 读在文件末尾会这样, 那时 TransferAll 读到 0 字节就返回了
+  size_t skip = res;
+  std::vector<struct iovec> rest;
+  for (const auto &iov : request->iov_) {
+    if (skip >= iov.iov_len) {
+      skip -= iov.iov_len;
+      continue;
+    }
+    rest.push_back({static_cast<char *>(iov.iov_base) + skip, iov.iov_len - skip});
+    skip = 0;
+  }
+  const ssize_t n = TransferAll(request->fd_, &rest, request->offset_ + res, request->write_);
+  request->on_complete_(n < 0 ? -1 : res + n);
+}
+
+}  // namespace bustub
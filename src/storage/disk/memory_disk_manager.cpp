@@ -0,0 +1,213 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_disk_manager.cpp
+//
+// Identification: src/storage/disk/memory_disk_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/memory_disk_manager.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+MemoryDiskManager::MemoryDiskManager(DiskLatency latency) : latency_(latency) {}
+
+MemoryDiskManager::~MemoryDiskManager() = default;
+
+void MemoryDiskManager::SetLatency(const DiskLatency &latency) {
+  std::lock_guard<std::mutex> guard(latency_latch_);
+  latency_ = latency;
+}
+
+/**
+ * The modelled time is waited for precisely: sleep for most of it, spin for the rest, since a sleep overshoots by
+ * tens of microseconds
+ */
+void MemoryDiskManager::Delay(page_id_t page_id, int num_pages, bool seek) {
+  std::chrono::nanoseconds delay;
+  {
+    std::lock_guard<std::mutex> guard(latency_latch_);
+    delay = latency_.request_ + num_pages * latency_.per_page_;
+    if (seek && page_id != next_page_id_) {
+      delay += latency_.seek_;
+    }
+    if (seek) {
+      next_page_id_ = page_id + num_pages;
+    }
+  }
+  if (delay.count() == 0) {
+    return;
+  }
+  simulated_ns_.fetch_add(delay.count(), std::memory_order_relaxed);
+  const auto deadline = std::chrono::steady_clock::now() + delay;
+  if (delay > std::chrono::microseconds(200)) {
+    std::this_thread::sleep_for(delay - std::chrono::microseconds(100));
+  }
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+void MemoryDiskManager::Reserve(tablespace_id_t tablespace_id, size_t num_pages) {
+  auto &chunks = chunks_[tablespace_id];
+  {
+    std::shared_lock<std::shared_mutex> guard(arena_latch_);
+    if (num_pages <= chunks.size() * PAGES_PER_CHUNK) {
+      return;
+    }
+  }
+  std::unique_lock<std::shared_mutex> guard(arena_latch_);
+  while (num_pages > chunks.size() * PAGES_PER_CHUNK) {
+    auto *chunk = static_cast<char *>(std::aligned_alloc(PAGE_SIZE, PAGES_PER_CHUNK * PAGE_SIZE));
+    memset(chunk, 0, PAGES_PER_CHUNK * PAGE_SIZE);
+    chunks.emplace_back(chunk, &std::free);
+  }
+}
+
+void MemoryDiskManager::Transfer(page_id_t page_id, int num_pages, char *const *page_data, bool write) {
+  GetTablespace(page_id);  // 不存在的 tablespace 抛出异常, 和 DiskManager 一样
+  const tablespace_id_t tablespace_id = GetTablespaceId(page_id);
+  const page_id_t page_no = GetPageNo(page_id);
+  Delay(page_id, num_pages, true);
+  const auto end = static_cast<size_t>(page_no) + num_pages;
+  if (write) {
+    num_writes_ += 1;
+    Reserve(tablespace_id, end);
+  }
+  const auto &chunks = chunks_[tablespace_id];
+  std::shared_lock<std::shared_mutex> guard(arena_latch_);
+  for (int i = 0; i < num_pages; i++) {
+    const size_t n = static_cast<size_t>(page_no) + i;
+    char *page = n < chunks.size() * PAGES_PER_CHUNK
+                     ? chunks[n / PAGES_PER_CHUNK].get() + (n % PAGES_PER_CHUNK) * PAGE_SIZE
+                     : nullptr;
+    if (write) {
+      SetPageChecksum(page_data[i]);
+      memcpy(page, page_data[i], PAGE_SIZE);
+    } else if (page != nullptr) {
+      memcpy(page_data[i], page, PAGE_SIZE);
+    } else {  // 从没写过的页面读出 0, 和文件末尾之后一样
+      memset(page_data[i], 0, PAGE_SIZE);
+    }
+  }
+  guard.unlock();
+  if (write) {
+    auto &num_pages_written = num_pages_[tablespace_id];
+    page_id_t num_pages_before = num_pages_written.load(std::memory_order_relaxed);
+    while (num_pages_before < page_no + num_pages &&
+           !num_pages_written.compare_exchange_weak(num_pages_before, page_no + num_pages, std::memory_order_relaxed)) {
+    }
+  } else {
+    VerifyPages(page_id, num_pages, page_data);
+  }
+}
+
+std::future<bool> MemoryDiskManager::TransferAsync(page_id_t page_id, int num_pages, char *const *page_data,
+                                                   bool write) {
+  std::vector<char *> pages(page_data, page_data + num_pages);
+  bool has_latency;
+  {
+    std::lock_guard<std::mutex> guard(latency_latch_);
+    has_latency = latency_.request_.count() != 0 || latency_.per_page_.count() != 0 || latency_.seek_.count() != 0;
+  }
+  if (!has_latency) {
+    std::promise<bool> done;
+    try {
+      Transfer(page_id, num_pages, pages.data(), write);
+      done.set_value(true);
+    } catch (const CorruptedPageException &) {
+      done.set_exception(std::current_exception());
+    }
+    return done.get_future();
+  }
+  // 写入的校验和要在返回之前填好, 和 DiskManager 的异步写一样
+  for (int i = 0; write && i < num_pages; i++) {
+    SetPageChecksum(pages[i]);
+  }
+  return std::async(std::launch::async, [this, page_id, num_pages, write, pages = std::move(pages)] {
+    Transfer(page_id, num_pages, pages.data(), write);
+    return true;
+  });
+}
+
+void MemoryDiskManager::Sync() { Delay(0, 0, false); }
+
+tablespace_id_t MemoryDiskManager::CreateTablespace(const std::string &db_file) { return AddTablespace(""); }
+
+void MemoryDiskManager::WritePage(page_id_t page_id, char *page_data) { Transfer(page_id, 1, &page_data, true); }
+
+void MemoryDiskManager::WritePages(page_id_t page_id, int num_pages, char *const *page_data) {
+  Transfer(page_id, num_pages, page_data, true);
+}
+
+void MemoryDiskManager::ReadPage(page_id_t page_id, char *page_data) { Transfer(page_id, 1, &page_data, false); }
+
+void MemoryDiskManager::ReadPages(page_id_t page_id, int num_pages, char *page_data) {
+  std::vector<char *> pages(num_pages);
+  for (int i = 0; i < num_pages; i++) {
+    pages[i] = page_data + static_cast<size_t>(i) * PAGE_SIZE;
+  }
+  Transfer(page_id, num_pages, pages.data(), false);
+}
+
+void MemoryDiskManager::ReadPages(page_id_t page_id, int num_pages, char *const *page_data) {
+  Transfer(page_id, num_pages, page_data, false);
+}
+
+std::future<bool> MemoryDiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  return TransferAsync(page_id, 1, &page_data, false);
+}
+
+std::future<bool> MemoryDiskManager::ReadPagesAsync(page_id_t page_id, int num_pages, char *const *page_data) {
+  return TransferAsync(page_id, num_pages, page_data, false);
+}
+
+std::future<bool> MemoryDiskManager::WritePageAsync(page_id_t page_id, char *page_data) {
+  return TransferAsync(page_id, 1, &page_data, true);
+}
+
+std::future<bool> MemoryDiskManager::WritePagesAsync(page_id_t page_id, int num_pages, char *const *page_data) {
+  return TransferAsync(page_id, num_pages, page_data, true);
+}
+
+/**
+ * Append to the in-memory log, counted as a flush like DiskManager::WriteLog
+ */
+void MemoryDiskManager::WriteLog(char *log_data, int size) {
+  if (size == 0) {
+    return;
+  }
+  flush_log_ = true;
+  num_flushes_ += 1;
+  Delay(0, (size + PAGE_SIZE - 1) / PAGE_SIZE, false);
+  {
+    std::lock_guard<std::mutex> guard(log_latch_);
+    log_.insert(log_.end(), log_data, log_data + size);
+  }
+  flush_log_ = false;
+}
+
+bool MemoryDiskManager::ReadLog(char *log_data, int size, int offset) {
+  std::lock_guard<std::mutex> guard(log_latch_);
+  if (offset < 0 || static_cast<size_t>(offset) >= log_.size()) {
+    return false;
+  }
+  const int read_count = std::min(size, static_cast<int>(log_.size()) - offset);
+  memcpy(log_data, log_.data() + offset, read_count);
+  // if log ends before reading "size"
+  memset(log_data + read_count, 0, size - read_count);
+  return true;
+}
+
+}  // namespace bustub
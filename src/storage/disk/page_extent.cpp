@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_extent.cpp
+//
+// Identification: src/storage/disk/page_extent.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_extent.h"
+
+#include <algorithm>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+page_id_t PageExtent::AllocatePage(DiskManager *disk_manager) {
+  std::lock_guard<std::mutex> guard(latch_);
+  disk_manager_ = disk_manager;
+  // 先用自己 extent 中的空闲页面(包括删除后释放的); 满了的 extent 在它有页面被释放之前不再查看
+  for (auto it = extents_.lower_bound(next_extent_); it != extents_.end(); ++it) {
+    next_extent_ = *it;
+    const page_id_t page_id = disk_manager_->AllocatePageInExtent(*it, extent_size_);
+    if (page_id != INVALID_PAGE_ID) {
+      return page_id;
+    }
+  }
+  // 所有 extent 都满了才预留新的
+  next_extent_ = disk_manager_->ReserveExtent(extent_size_, tablespace_id_);
+  extents_.insert(next_extent_);
+  return disk_manager_->AllocatePageInExtent(next_extent_, extent_size_);
+}
+
+void PageExtent::ReleasePage(page_id_t page_id) {
+  if (disk_manager_ != nullptr) {
+    disk_manager_->DeallocatePage(page_id);
+  }
+  FreePage(page_id);
+}
+
+void PageExtent::FreePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  // extent 按自己的大小对齐, 页面所在的 extent 由页号向下取整得到
+  const page_id_t page_no = DiskManager::GetPageNo(page_id);
+  next_extent_ = std::min(next_extent_, DiskManager::MakePageId(DiskManager::GetTablespaceId(page_id),
+                                                                page_no - page_no % extent_size_));
+}
+
+}  // namespace bustub
@@ -20,13 +20,14 @@ namespace bustub {
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, tablespace_id_t tablespace_id)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(internal_max_size),
+      extent_(EXTENT_SIZE, tablespace_id) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
@@ -50,17 +51,75 @@ bool BPLUSTREE_TYPE::IsEmpty(){
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  LeafPage* leaf_node = FindLeafPage(key,false,IndexOpType::FIND,transaction);
   ValueType val;
-  bool exist = leaf_node->Lookup(key,&val,comparator_);
+  bool exist;
+  // 先乐观查找, 不写任何页面的 latch; 只有与写操作冲突时才退化为加读锁的查找
+  if(!OptimisticGetValue(key,&val,&exist)){
+    LeafPage* leaf_node = FindLeafPage(key,false,IndexOpType::FIND,transaction);
+    exist = leaf_node->Lookup(key,&val,comparator_);
+    if(transaction) FreeAllPagesInTxn(IndexOpType::FIND,transaction);
+  }
   if(!exist) return false;
 
   result[0].clear();
   result[0].push_back(val);
-  FreeAllPagesInTxn(IndexOpType::FIND,transaction);
   return true;
 }
 
+/*
+ * 乐观查找(optimistic lock coupling):
+ *   1.每个结点读之前记下版本(Page::TryOptimisticLatch), 读完后验证版本没有变化;
+ *   2.拿到子结点的版本之后再验证一次父结点: 子结点分裂/合并时写线程持有父结点的写锁, 父结点的版本一定会变;
+ *   3.读到的 size 在验证之前不可信, 超出结点容量时直接放弃, 避免读出页面之外;
+ *   4.结点被 pin 住, 不会在查找过程中被置换成别的页面.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticGetValue(const KeyType &key, ValueType *value, bool *exist) {
+  root_pgid_mutex_.lock();
+  page_id_t page_id = root_page_id_;
+  root_pgid_mutex_.unlock();
+  if(page_id == INVALID_PAGE_ID){
+    *exist = false;
+    return true;
+  }
+  Page* page = buffer_pool_manager_->FetchPage(page_id);
+  if(page == nullptr) return false;
+  uint64_t version;
+  bool ok = page->TryOptimisticLatch(&version);
+  // 拿到版本之后根结点没有换, 之后根结点的分裂会体现在它的版本上
+  root_pgid_mutex_.lock();
+  ok = ok && page_id == root_page_id_;
+  root_pgid_mutex_.unlock();
+
+  while(ok){
+    BPlusTreePage* node = reinterpret_cast<BPlusTreePage*>(page->GetData());
+    int max_size = node->IsLeafPage() ? leaf_max_size_ : internal_max_size_;
+    if(node->GetSize() < 0 || node->GetSize() > max_size + 1){
+      break;
+    }
+    if(node->IsLeafPage()){
+      *exist = reinterpret_cast<LeafPage*>(node)->Lookup(key,value,comparator_);
+      ok = page->ValidateOptimisticLatch(version);
+      break;
+    }
+    page_id_t child_page_id = reinterpret_cast<InternalPage*>(node)->Lookup(key,comparator_);
+    if(!page->ValidateOptimisticLatch(version)){
+      break;
+    }
+    Page* child_page = buffer_pool_manager_->FetchPage(child_page_id);
+    if(child_page == nullptr){
+      break;
+    }
+    uint64_t child_version;
+    bool child_ok = child_page->TryOptimisticLatch(&child_version) && page->ValidateOptimisticLatch(version);
+    buffer_pool_manager_->UnpinPage(page_id,false);
+    page = child_page; page_id = child_page_id; version = child_version;
+    ok = child_ok;
+  }
+  buffer_pool_manager_->UnpinPage(page_id,false);
+  return ok && page->ValidateOptimisticLatch(version);
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -74,8 +133,7 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
   bool duplicate = false;
-  if(IsEmpty()){
-    StartNewTree(key,value);
+  if(IsEmpty() && StartNewTree(key,value)){
     duplicate = false;    
   }
   else{
@@ -90,25 +148,31 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then update b+
  * tree's root page id and insert entry directly into leaf page.
+ * @return: false if another thread started the tree first, then insert into its leaf page instead
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+bool BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  // 几个线程可能同时看到空树: 在 root_pgid_mutex_ 中再检查一次, 只有一个线程创建根结点
+  std::lock_guard<std::mutex> guard(root_pgid_mutex_);
+  if(root_page_id_ != INVALID_PAGE_ID){
+    return false;
+  }
   page_id_t new_page_id;
-  Page* new_page=buffer_pool_manager_->NewPage(&new_page_id);
+  Page* new_page=buffer_pool_manager_->NewPage(&new_page_id,extent_);
   if(new_page==nullptr){
     throw Exception(ExceptionType::OUT_OF_MEMORY,"b_plus_tree.cpp,StartNewTree");
   }
   // 新创建的root page,其内容被视为一个叶子结点; ValueType 类型为RID
-  LeafPage* root_page=reinterpret_cast<LeafPage*>(new_page);
+  LeafPage* root_page=reinterpret_cast<LeafPage*>(new_page->GetData());
   root_page->Init(new_page_id, INVALID_PAGE_ID, leaf_max_size_);
 
   // 插入kv
   root_page->Insert(key,value,comparator_);
   // 在索引文件中新增一棵B+树
-  root_pgid_mutex_.lock();
   root_page_id_ = new_page_id;
   UpdateRootPageId(true);
-  root_pgid_mutex_.unlock();
+  buffer_pool_manager_->UnpinPage(new_page_id,true);
+  return true;
 }
 
 /*
@@ -149,7 +213,7 @@ INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 N *BPLUSTREE_TYPE::Split(N *node) {
   page_id_t new_page_id;
-  Page* new_page=buffer_pool_manager_->NewPage(&new_page_id);
+  Page* new_page=buffer_pool_manager_->NewPage(&new_page_id,extent_);
   if(new_page==nullptr){
     throw Exception(ExceptionType::OUT_OF_MEMORY,"b_plus_tree.cpp,Split");
   }
@@ -159,7 +223,7 @@ N *BPLUSTREE_TYPE::Split(N *node) {
   if(node->IsRootPage()){
     // 需要创建新的根结点
     page_id_t new_root_pgid;
-    Page* new_root_page=buffer_pool_manager_->NewPage(&new_root_pgid);
+    Page* new_root_page=buffer_pool_manager_->NewPage(&new_root_pgid,extent_);
     if(new_root_page==nullptr){
       throw Exception(ExceptionType::OUT_OF_MEMORY,"b_plus_tree.cpp,Split");
     }
@@ -175,6 +239,7 @@ N *BPLUSTREE_TYPE::Split(N *node) {
     UpdateRootPageId(false);
     root_pgid_mutex_.unlock();
     node->SetParentPageId(new_root_pgid);
+    buffer_pool_manager_->UnpinPage(new_root_pgid,true);  // 下面作为父结点再 fetch
   }
 
   /////////////////////////////// a.分裂
@@ -208,6 +273,9 @@ N *BPLUSTREE_TYPE::Split(N *node) {
     Split(parent_node);
   }
 
+  // 新结点和父结点是这里 NewPage/FetchPage 的, 分裂完成后 unpin; node 由调用者 unpin
+  buffer_pool_manager_->UnpinPage(parent_id,true);
+  buffer_pool_manager_->UnpinPage(new_page_id,true);
   return r_brother;
 }
 
@@ -244,7 +312,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
 
   // 需要合并 或者 重构, 具体哪种操作由CoalesceOrRedistribute()内部决定
   if(leaf_node->GetSize() < leaf_node->GetMinSize()){
-    CoalesceOrRedistribute(leaf_node,nullptr);
+    CoalesceOrRedistribute(leaf_node,transaction);
   }
 
   FreeAllPagesInTxn(IndexOpType::DELETE,transaction);
@@ -262,13 +330,16 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
  *   2.重构时,优先从左兄弟借还是从右兄弟借都可(本文优先从左兄弟借);
  *   3.合并时,优先合并到左兄弟;如果没有左兄弟,则将右兄弟合并到当前结点(主要是为了方便叶子结点调整nextPageId指针)!
  *   4.对于返回值,true代表node需要被删除(与兄弟合并、或者node作为根结点被删除); false代表node没有被删除(从兄弟结点借到了kv);
+ *   5.被合并掉的结点记录在 transaction 的 deleted page set 中, 由 FreeAllPagesInTxn 在 unpin 之后删除;
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
   if(node->IsRootPage()){
-    return AdjustRoot(node);
     // 即使root page的 GetSize()<GetMinSize(),也无需/无法做合并、重构,因而直接退出
+    bool deleted = AdjustRoot(node);
+    if(deleted && transaction) transaction->AddIntoDeletedPageSet(node->GetPageId());
+    return deleted;
   }
 
   // 找到父结点
@@ -278,37 +349,51 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
   // 找到左右兄弟
   int idx = parent_node->ValueIndex(node->GetPageId());
   N *l_brother=nullptr,*r_brother=nullptr;
+  page_id_t l_page_id=INVALID_PAGE_ID,r_page_id=INVALID_PAGE_ID;
+  bool redistributed=false;
   if(idx>0){                          // 存在左兄弟
-    page_id_t page_id = parent_node->ValueAt(idx-1);
-    Page* l_page = buffer_pool_manager_->FetchPage(page_id);
+    l_page_id = parent_node->ValueAt(idx-1);
+    Page* l_page = buffer_pool_manager_->FetchPage(l_page_id);
     l_brother = reinterpret_cast<N*>(l_page->GetData());
     if(l_brother->GetSize()>l_brother->GetMinSize()){
-      // 借左兄弟的最后一个kv对
+      // 借左兄弟的最后一个kv对; 叶子结点的重构不会更新父结点, node 的分隔键变为借来的key
       Redistribute(l_brother,node,l_brother->GetSize()-1);
-      return false;
+      if(node->IsLeafPage()) parent_node->SetKeyAt(idx,node->KeyAt(0));
+      redistributed=true;
     }
   }
-  if(idx<parent_node->GetSize()-1){  // 存在右兄弟
-    page_id_t page_id = parent_node->ValueAt(idx+1);
-    Page* r_page = buffer_pool_manager_->FetchPage(page_id);
+  if(!redistributed && idx<parent_node->GetSize()-1){  // 存在右兄弟
+    r_page_id = parent_node->ValueAt(idx+1);
+    Page* r_page = buffer_pool_manager_->FetchPage(r_page_id);
     r_brother = reinterpret_cast<N*>(r_page->GetData());
     if(r_brother->GetSize()>r_brother->GetMinSize()){
-      // 借右兄弟的第一个kv对
+      // 借右兄弟的第一个kv对; 右兄弟的分隔键变为它新的第一个key
       Redistribute(r_brother,node,0);
-      return false;
+      if(node->IsLeafPage()) parent_node->SetKeyAt(idx+1,r_brother->KeyAt(0));
+      redistributed=true;
     }
   }
 
   // 到此,说明左右兄弟都不能借,则需合并,然后更改父结点
-  if(l_brother){
-    Coalesce(l_brother,node,parent_node,idx,nullptr);
-    return true;
-  }
-  else if(r_brother){
-    Coalesce(node,r_brother,parent_node,idx+1,nullptr);
-    return false;
+  bool deleted=false;
+  if(!redistributed){
+    if(l_brother){
+      Coalesce(l_brother,node,parent_node,idx,transaction);
+      deleted=true;
+    }
+    else if(r_brother){
+      Coalesce(node,r_brother,parent_node,idx+1,transaction);
+    }
+    else{
+      deleted=true;
+    }
   }
-  return true;
+
+  // 释放这里 fetch 的父结点和兄弟结点; 被合并掉的兄弟结点此时没有 pin 了, 之后可以删除
+  if(l_page_id!=INVALID_PAGE_ID) buffer_pool_manager_->UnpinPage(l_page_id,true);
+  if(r_page_id!=INVALID_PAGE_ID) buffer_pool_manager_->UnpinPage(r_page_id,true);
+  buffer_pool_manager_->UnpinPage(parent_page_id,true);
+  return deleted;
 }
 
 /*
@@ -333,11 +418,12 @@ bool BPLUSTREE_TYPE::Coalesce(N *neighbor_node, N *node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent, int index,
                               Transaction *transaction) {
   node->MoveAllTo(neighbor_node,buffer_pool_manager_);
+  if(transaction) transaction->AddIntoDeletedPageSet(node->GetPageId());
 
   // 在父结点中删除node的kv对,判断是否需要递归合并/重构
   parent->Remove(index);
   if(parent->GetSize() < parent->GetMinSize()){
-    CoalesceOrRedistribute(parent,nullptr);
+    CoalesceOrRedistribute(parent,transaction);
     return true;
   }
   return false;
@@ -382,6 +468,7 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
     Page* child_page = buffer_pool_manager_->FetchPage(child_page_id);
     LeafPage* child_node = reinterpret_cast<LeafPage*>(child_page->GetData());
     child_node->SetParentPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(child_page_id,true);
     root_pgid_mutex_.lock();
     root_page_id_ = child_page_id;
     UpdateRootPageId(0);
@@ -394,6 +481,7 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
     root_page_id_ = INVALID_PAGE_ID;
     UpdateRootPageId(0);
     root_pgid_mutex_.unlock();
+    return true;
   }
 
   // 其他情况不做任何处理,即使 GetSize()<GetMinSize()
@@ -675,50 +763,40 @@ void BPLUSTREE_TYPE::LatchPage(Page* page,IndexOpType indexOp,Transaction *trans
 }
 
 /*
- * 1.unlatch 所有祖先,但是不包括 page 自身;
+ * 1.unlatch 并 unpin 所有祖先,但是不包括 page 自身;
  * 2.同时从txn 中 page_set中删除 unlatch的Page;
+ * 注: page_set 中按从根到叶子的顺序存放着还 latch 着的结点, page 是最后一个. 释放的祖先还没有被修改过
  */ 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UnLatchAncestors(Page* page,IndexOpType indexOp,Transaction *transaction){
-  InternalPage* node = reinterpret_cast<InternalPage*>(page->GetData());
-  // 从参数 page 的父结点开始 unlatch
-  page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  node = reinterpret_cast<InternalPage*>(page->GetData());
-  while(!node->IsRootPage()){
-    if(indexOp == IndexOpType::FIND) page->RUnlatch();
-    else page->WUnlatch();
-    auto itr = std::find(transaction->GetPageSet()->begin(),transaction->GetPageSet()->end(),page);
-    transaction->GetPageSet()->erase(itr);
-    // 找到上一个结点
-    page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-    node = reinterpret_cast<InternalPage*>(page->GetData());
+  auto latched_pgset = transaction->GetPageSet();
+  while(latched_pgset->front() != page){
+    Page* ancestor = latched_pgset->front();
+    if(indexOp == IndexOpType::FIND) ancestor->RUnlatch();
+    else ancestor->WUnlatch();
+    buffer_pool_manager_->UnpinPage(ancestor->GetPageId(),false);
+    latched_pgset->pop_front();
   }
-
-  if(indexOp == IndexOpType::FIND) page->RUnlatch();    // unlatch根结点
-  else page->WUnlatch();
-  auto itr = std::find(transaction->GetPageSet()->begin(),transaction->GetPageSet()->end(),page);
-  transaction->GetPageSet()->erase(itr);
 }
 
 /*
  * 在对数据库的操作完成后调用,释放transaction中的Page...
+ * 1.unlatch 并 unpin 还 latch 着的结点(插入/删除时它们可能被修改过);
+ * 2.删除合并掉的结点, 页面还给 free space map 供之后重用. 删除要在它们的 pin 都释放之后
  */ 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::FreeAllPagesInTxn(IndexOpType indexOp,Transaction *transaction){
   auto latched_pgset = transaction->GetPageSet();
   auto deleted_pgset = transaction->GetDeletedPageSet();
-  for(size_t i=0;i<latched_pgset->size();i++){
-    Page* page = (*latched_pgset)[i];
+  for(Page* page : *latched_pgset){
+    page_id_t page_id = page->GetPageId();
     if(indexOp == IndexOpType::FIND) page->RUnlatch();
     else page->WUnlatch();
-
-    // TODO:某个结点可能已经被删除,需要进行相应处理...
-    page_id_t page_id = reinterpret_cast<BPlusTreePage*>(page->GetData())->GetPageId();
-    if(std::find(deleted_pgset->begin(),deleted_pgset->end(),page_id) != deleted_pgset->end()){
-
-    }
+    buffer_pool_manager_->UnpinPage(page_id,indexOp != IndexOpType::FIND);
+  }
+  for(page_id_t page_id : *deleted_pgset){
+    buffer_pool_manager_->DeletePage(page_id, extent_);
   }
-
 
   latched_pgset->clear();
   deleted_pgset->clear();
@@ -19,6 +19,7 @@ INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE* leaf_node,BufferPo
     leaf_node_ = leaf_node;
     index_ = 0;
     buffer_pool_manager_ = buffer_pool_manager;
+    PrefetchNextLeaves();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -26,6 +27,7 @@ INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE* leaf_node,int inde
     leaf_node_ = leaf_node;
     index_ = index;
     buffer_pool_manager_ = buffer_pool_manager;
+    PrefetchNextLeaves();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -63,11 +65,26 @@ INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
             Page* next_page = buffer_pool_manager_->FetchPage(next_page_id);
             leaf_node_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE*>(next_page->GetData());
             index_ = 0;
+            PrefetchNextLeaves();
         }
     }
     return *this;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::PrefetchNextLeaves() {
+    if(leaf_node_ == nullptr || buffer_pool_manager_ == nullptr){
+        return;
+    }
+    size_t prefetch_window = buffer_pool_manager_->GetPrefetchWindow();
+    if(prefetch_window == 0 || leaf_node_->GetNextPageId() == INVALID_PAGE_ID){
+        return;
+    }
+    buffer_pool_manager_->Prefetch(leaf_node_->GetNextPageId(), prefetch_window, [](Page* page){
+        return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE*>(page->GetData())->GetNextPageId();
+    });
+}
+
 /*
  * Return whether two iterators are equal
  */ 
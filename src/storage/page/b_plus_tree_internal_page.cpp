@@ -11,8 +11,11 @@
 
 #include <iostream>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
+#include "storage/index/key_search.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 
 namespace bustub {
@@ -89,23 +92,8 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const {
-  // assert(GetSize()>1);
-  // int start=1; int end=GetSize()-1;
-  // // 二分查找,找到第一个 >= 参数key 的 key,但是返回其前一个!!!
-  // while(start <= end){
-  //   int mid = start + (end-start)/2;
-  //   if(comparator(array[mid].first, key) == 0) return array[mid].second;
-  //   else if(comparator(array[mid].first, key) < 0 ) start = mid+1;
-  //   else end = mid -1;
-  // }
-  // return array[start-1].second;
-
-  // TODO:改为二分查找
-  // 找到第一个比key大的 kv 对
-  int i=1;
-  while(i<GetSize() && comparator(key,KeyAt(i))>=0){
-    i++;
-  }
+  // 二分查找第一个比key大的 kv 对(跳过无效的第一个key), 返回它前一个的val
+  int i = KeyUpperBound(array, 1, GetSize(), key, comparator);
   return ValueAt(i-1);
 }
 
@@ -142,7 +130,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value,
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
                                                     const ValueType &new_value) {
-  assert(GetSize() < GetMaxSize());
+  assert(GetSize() <= GetMaxSize());   // 先插入再分裂, 插入后可以比 max_size 多一个
   int i=GetSize()-1;
   // 元素后移
   while(i>=0 && array[i].second != old_value){
@@ -209,13 +197,24 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
   for(int i=0;i<size;i++){
     // 拷贝
     array[start+i] = items[i];
-    // 更新被移动的子结点的父指针(注意fetch时进行了pin, 后面需要unpin)
-    page_id_t child_page_id = reinterpret_cast<page_id_t>(items[i].second);
-    Page* child_page = buffer_pool_manager->FetchPage(child_page_id);
-    char* child_page_data = child_page->GetData();
-    BPlusTreePage*  child_hdr =  reinterpret_cast<BPlusTreePage*>(child_page_data);
-    child_hdr->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(child_page_id,true);
+  }
+  // 更新被移动的子结点的父指针: 每 PIN_BATCH_SIZE 个子结点一起 fetch/unpin, 只加一次 buffer pool 的锁
+  std::vector<page_id_t> child_page_ids;
+  std::vector<std::pair<page_id_t,bool>> unpin_pages;
+  for(int begin=0;begin<size;begin+=PIN_BATCH_SIZE){
+    child_page_ids.clear(); unpin_pages.clear();
+    for(int i=begin;i<size && i<begin+PIN_BATCH_SIZE;i++){
+      child_page_ids.push_back(reinterpret_cast<page_id_t>(items[i].second));
+    }
+    std::vector<Page*> child_pages = buffer_pool_manager->FetchPages(child_page_ids);
+    for(size_t i=0;i<child_pages.size();i++){
+      // 批量 fetch 失败(没有空闲 frame)的退回到逐个 fetch
+      Page* child_page = child_pages[i]!=nullptr ? child_pages[i] : buffer_pool_manager->FetchPage(child_page_ids[i]);
+      BPlusTreePage*  child_hdr =  reinterpret_cast<BPlusTreePage*>(child_page->GetData());
+      child_hdr->SetParentPageId(GetPageId());
+      unpin_pages.emplace_back(child_page_ids[i],true);
+    }
+    buffer_pool_manager->UnpinPages(unpin_pages);
   }
   IncreaseSize(size);
 }
@@ -246,7 +245,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
-  ValueType val = array[1].second;
+  ValueType val = array[0].second;   // 只剩下的一个指针在第一个kv对中
   IncreaseSize(-1);
   return val;
 }
@@ -283,6 +282,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient,
 
   // 删除父结点中middle_key对应的kv对(即currnode对应的kv对)
   parent_node->Remove(middle_idx);
+  buffer_pool_manager->UnpinPage(parent_node->GetPageId(),true);
 }
 
 
@@ -321,6 +321,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *rec
   // 更新:此时父结点中 middle_key 的位置应该是当前结点第一个kv对的key!
   Remove(0);  // 当前结点中删除第一个record
   parent_node->SetKeyAt(middle_idx,array[0].first);
+  buffer_pool_manager->UnpinPage(parent_node->GetPageId(),true);
 }
 
 /* Append an entry at the end.
@@ -338,6 +339,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, Buffe
   Page* child_page = buffer_pool_manager->FetchPage(child_pgid);
   BPlusTreePage* child_node = reinterpret_cast<BPlusTreePage*>(child_page->GetData());
   child_node->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child_pgid,true);
 }
 
 /*
@@ -367,6 +369,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *re
   // 更新:currnode最后一个kv对的key需要作为中间键放到父结点对应位置
   parent_node->SetKeyAt(middle_idx,array[size-1].first);
   Remove(size-1);
+  buffer_pool_manager->UnpinPage(parent_node->GetPageId(),true);
 }
 
 /* Append an entry at the beginning.
@@ -388,6 +391,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, Buff
   Page* child_page = buffer_pool_manager->FetchPage(child_pgid);
   BPlusTreePage* child_node = reinterpret_cast<BPlusTreePage*>(child_page->GetData());
   child_node->SetParentPageId(GetPageId());  
+  buffer_pool_manager->UnpinPage(child_pgid,true);
 }
 
 
@@ -9,10 +9,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <sstream>
 
 #include "common/exception.h"
 #include "common/rid.h"
+#include "storage/index/key_search.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -57,12 +59,8 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const {
-  int i=0;
-  int size=GetSize();
-  while (i<size && comparator(key,array[i].first)>0){
-    i++;
-  }
-  return i;
+  // 二分查找, 整数开头的 8 字节键直接比较整数(见 key_search.h)
+  return KeyLowerBound(array, 0, GetSize(), key, comparator);
 }
 
 /*
@@ -93,18 +91,14 @@ const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
 /*
  * Insert key & value pair into leaf page ordered by key
  * @return  page size after insertion
- * TODO:改为二分查找
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) {
-  int i=GetSize()-1;
-  // 找到kv对应该存放的位置(i+1)  => 也可改用上面的 KeyIndex()函数
-  while(i>=0 && comparator(key,array[i].first)<0 ){
-    array[i+1]=array[i];
-    i--;
-  }
-  array[i+1].first=key;
-  array[i+1].second=value;
+  // 二分查找kv应该存放的位置: 第一个大于key的位置, 之后的kv整体后移一位
+  int idx = KeyUpperBound(array, 0, GetSize(), key, comparator);
+  std::copy_backward(array + idx, array + GetSize(), array + GetSize() + 1);
+  array[idx].first=key;
+  array[idx].second=value;
 
   SetSize(GetSize()+1);
 
@@ -159,15 +153,13 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
  * 注意:
  *   1.当key存在时,需要通过参数value返回对应的值;
  *   2.leaf_page,不需要舍弃第一个kv对;
- * TODO:改为二分查找
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const {
-  for(int i=0;i<GetSize();i++){
-    if(comparator(key,array[i].first)==0){
-      *value=array[i].second;
-      return true;
-    }
+  int idx = KeyIndex(key,comparator);
+  if(idx<GetSize() && comparator(key,array[idx].first)==0){
+    *value=array[idx].second;
+    return true;
   }
   return false;
 }
@@ -180,18 +172,14 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
  * exist, perform deletion, otherwise return immediately.
  * NOTE: store key&value pair continuously after deletion
  * @return   page size after deletion
- * TODO:改为二分查找
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) {
-  ValueType tmp_val;
-  if(!Lookup(key,&tmp_val,comparator)) return GetSize();
   int idx = KeyIndex(key,comparator);
   int size=GetSize();
+  if(idx==size || comparator(key,array[idx].first)!=0) return size;
   // 元素往前移
-  for(int i=idx;i+1<size;i++){
-    array[i]=array[i+1];
-  }
+  std::copy(array + idx + 1, array + size, array + idx);
   SetSize(size-1);
   return GetSize();
 }
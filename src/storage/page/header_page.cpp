@@ -21,7 +21,7 @@ namespace bustub {
  */
 bool HeaderPage::InsertRecord(const std::string &name, const page_id_t root_id) {
   assert(name.length() < 32);
-  assert(root_id > INVALID_PAGE_ID);
+  assert(root_id != INVALID_PAGE_ID);
 
   int record_num = GetRecordCount();
   int offset = 4 + record_num * 36;
@@ -308,6 +308,29 @@ bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
   return true;
 }
 
+bool TablePage::GetTupleOptimistic(const RID &rid, Tuple *tuple) {
+  // 页面可能正在被修改, 读到的 slot 和 tuple 位置都要检查是否在页面内, 之后由调用者验证版本
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || OFFSET_TUPLE_OFFSET + SIZE_TUPLE * (slot_num + 1) > PAGE_DATA_SIZE) {
+    return false;
+  }
+  uint32_t tuple_size = GetTupleSize(slot_num);
+  uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
+  if (IsDeleted(tuple_size) || tuple_offset < SIZE_TABLE_PAGE_HEADER || tuple_size > PAGE_DATA_SIZE - tuple_offset) {
+    return false;
+  }
+
+  tuple->size_ = tuple_size;
+  if (tuple->allocated_) {
+    delete[] tuple->data_;
+  }
+  tuple->data_ = new char[tuple->size_];
+  memcpy(tuple->data_, GetData() + tuple_offset, tuple->size_);
+  tuple->rid_ = rid;
+  tuple->allocated_ = true;
+  return true;
+}
+
 bool TablePage::GetFirstTupleRid(RID *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); ++i) {
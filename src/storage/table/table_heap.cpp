@@ -22,27 +22,36 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
     : buffer_pool_manager_(buffer_pool_manager),
       lock_manager_(lock_manager),
       log_manager_(log_manager),
-      first_page_id_(first_page_id) {}
+      first_page_id_(first_page_id),
+      extent_(EXTENT_SIZE, DiskManager::GetTablespaceId(first_page_id)) {}
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     Transaction *txn)
-    : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
+                     Transaction *txn, tablespace_id_t tablespace_id)
+    : buffer_pool_manager_(buffer_pool_manager),
+      lock_manager_(lock_manager),
+      log_manager_(log_manager),
+      extent_(EXTENT_SIZE, tablespace_id) {
   // Initialize the first table page.
-  auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
+  auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_, extent_));
   BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
   first_page->WLatch();
-  first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  first_page->Init(first_page_id_, PAGE_DATA_SIZE, INVALID_LSN, log_manager_, txn);
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
-bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
-  if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
+bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy) {
+  if (tuple.size_ + 32 > PAGE_DATA_SIZE) {  // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  // 批量插入从上次插入的页面开始找空闲空间, 不用每次都从第一个页面走一遍链表
+  page_id_t start_page_id = first_page_id_;
+  if (strategy != nullptr && strategy->GetCurrentPageId() != INVALID_PAGE_ID) {
+    start_page_id = strategy->GetCurrentPageId();
+  }
+  auto cur_page = static_cast<TablePage *>(FetchPage(start_page_id, strategy));
   if (cur_page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
     return false;
@@ -59,11 +68,11 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
       cur_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
       // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+      cur_page = static_cast<TablePage *>(FetchPage(next_page_id, strategy));
       cur_page->WLatch();
     } else {
       // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
+      auto new_page = static_cast<TablePage *>(NewPage(&next_page_id, strategy));
       // If we could not create a new page,
       if (new_page == nullptr) {
         // Then life sucks and we abort the transaction.
@@ -75,7 +84,7 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
       // Otherwise we were able to create a new page. We initialize it now.
       new_page->WLatch();
       cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
+      new_page->Init(next_page_id, PAGE_DATA_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
       cur_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
       cur_page = new_page;
@@ -89,6 +98,9 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
   
   // This line has caused most of us to double-take and "whoa double unlatch".
   // We are not, in fact, double unlatching. See the invariant above.
+  if (strategy != nullptr) {
+    strategy->SetCurrentPageId(cur_page->GetTablePageId());
+  }
   cur_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
   // Update the transaction's write set.
@@ -170,6 +182,15 @@ bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  // 乐观读: 不加页面读锁, 读完后验证页面版本. 需要申请行锁时走下面加读锁的路径(申请行锁可能阻塞)
+  if (!enable_logging || txn->IsSharedLocked(rid) || txn->IsExclusiveLocked(rid)) {
+    uint64_t version;
+    if (page->TryOptimisticLatch(&version) && page->GetTupleOptimistic(rid, tuple) &&
+        page->ValidateOptimisticLatch(version)) {
+      buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+      return true;
+    }
+  }
   // Read the tuple from the page.
   page->RLatch();
   bool res = page->GetTuple(rid, tuple, txn, lock_manager_); 
@@ -200,4 +221,16 @@ TableIterator TableHeap::Begin(Transaction *txn) {
 
 TableIterator TableHeap::End() { return TableIterator(this, RID(INVALID_PAGE_ID, 0), nullptr); }
 
+Page *TableHeap::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  if (strategy == nullptr) {
+    return buffer_pool_manager_->FetchPage(page_id);
+  }
+  return buffer_pool_manager_->FetchPage(page_id, *strategy);
+}
+
+Page *TableHeap::NewPage(page_id_t *page_id, BufferAccessStrategy *strategy) {
+  // 表的页面从它自己的 extent 中分配, 顺序扫描时基本是顺序读盘
+  return buffer_pool_manager_->NewPage(page_id, extent_, strategy);
+}
+
 }  // namespace bustub
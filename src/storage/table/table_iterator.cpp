@@ -38,7 +38,7 @@ Tuple *TableIterator::operator->() {
  */ 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId(), strategy_));
   cur_page->RLatch();
   assert(cur_page != nullptr);  // all pages are pinned
 
@@ -46,7 +46,7 @@ TableIterator &TableIterator::operator++() {
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId(), strategy_));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
@@ -58,6 +58,14 @@ TableIterator &TableIterator::operator++() {
   }
   tuple_->rid_ = next_tuple_rid;
 
+  // 第一次进入一个页面时, 异步预读它之后的若干个页面, 扫描到页面边界时就不用同步等待读盘了
+  const size_t prefetch_window = buffer_pool_manager->GetPrefetchWindow();
+  if (prefetch_window > 0 && cur_page->GetTablePageId() != prefetch_page_id_) {
+    prefetch_page_id_ = cur_page->GetTablePageId();
+    buffer_pool_manager->Prefetch(cur_page->GetNextPageId(), prefetch_window,
+                                  [](Page *page) { return static_cast<TablePage *>(page)->GetNextPageId(); });
+  }
+
   if (*this != table_heap_->End()) {
     // GetTuple 填充了 tuple_ 的内容...
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
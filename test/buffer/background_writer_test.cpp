@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// background_writer_test.cpp
+//
+// Identification: test/buffer/background_writer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Create num_pages dirty pages holding "page <id>" and unpin them.
+static void CreatePages(BufferPoolManager *bpm, int num_pages) {
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+}
+
+// @return true if the page on disk holds "page <page_id>"
+static bool IsOnDisk(DiskManager *disk_manager, page_id_t page_id) {
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(page_id, data);
+  return strcmp(data, ("page " + std::to_string(page_id)).c_str()) == 0;
+}
+
+TEST(BackgroundWriterTest, WriteTest) {
+  const std::string db_name = "background_writer_test.db";
+  const size_t buffer_pool_size = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, log_manager, ReplacerPolicy::LRU);
+  CreatePages(bpm, buffer_pool_size);
+
+  // Scenario: a round writes back the least recently used pages, a pinned page is skipped.
+  Page *pinned = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, pinned);
+  EXPECT_EQ(3, bpm->BackgroundWrite(3));
+  for (page_id_t i = 1; i <= 3; i++) {
+    EXPECT_FALSE(bpm->GetPages()[i].IsDirty());
+    EXPECT_TRUE(IsOnDisk(disk_manager, i));
+  }
+  EXPECT_TRUE(pinned->IsDirty());
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  // Scenario: the pages written by the background writer are still resident, and are evicted clean.
+  Page *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 1"));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  // Scenario: with logging enabled, a page whose log records are not persistent yet is not written.
+  EXPECT_EQ(5, bpm->BackgroundWrite(buffer_pool_size));
+  enable_logging = true;
+  page = bpm->FetchPage(4);
+  ASSERT_NE(nullptr, page);
+  page->SetLSN(10);
+  EXPECT_TRUE(bpm->UnpinPage(4, true));
+  log_manager->SetPersistentLSN(9);
+  EXPECT_EQ(0, bpm->BackgroundWrite(buffer_pool_size));
+  EXPECT_TRUE(page->IsDirty());
+  log_manager->SetPersistentLSN(10);
+  EXPECT_EQ(1, bpm->BackgroundWrite(buffer_pool_size));
+  EXPECT_FALSE(page->IsDirty());
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(4, data);
+  EXPECT_EQ(0, memcmp(data, page->GetData(), PAGE_DATA_SIZE));
+  enable_logging = false;
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("background_writer_test.fsm");
+  remove("background_writer_test.log");
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+}
+
+TEST(BackgroundWriterTest, ThreadTest) {
+  const std::string db_name = "background_writer_test.db";
+  const int num_pages = 12;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(3, 4, disk_manager, nullptr, ReplacerPolicy::LRU);
+  CreatePages(bpm, num_pages);
+
+  // Scenario: the background writers of all shards clean every page.
+  bpm->StartBackgroundWriter(4, std::chrono::milliseconds(5));
+  bool all_clean = false;
+  for (int round = 0; round < 200 && !all_clean; round++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    all_clean = true;
+    for (page_id_t i = 0; i < num_pages; i++) {
+      all_clean = all_clean && IsOnDisk(disk_manager, i);
+    }
+  }
+  EXPECT_TRUE(all_clean);
+  bpm->StopBackgroundWriter();
+  bpm->StopBackgroundWriter();
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("background_writer_test.fsm");
+  remove("background_writer_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// batch_pin_test.cpp
+//
+// Identification: test/buffer/batch_pin_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Create num_pages dirty pages holding "page <id>" and unpin them.
+static void CreatePages(BufferPoolManager *bpm, int num_pages) {
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+}
+
+// @return true if the page holds "page <page_id>"
+static bool HoldsPage(Page *page, page_id_t page_id) {
+  return page != nullptr && page->GetPageId() == page_id &&
+         strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()) == 0;
+}
+
+TEST(BatchPinTest, FetchUnpinTest) {
+  const std::string db_name = "batch_pin_test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  CreatePages(bpm, 8);
+
+  // Scenario: pages 4..7 are resident. A batch mixes a hit, misses, a duplicate and an invalid page id.
+  std::vector<Page *> pages = bpm->FetchPages({1, 5, 2, 1, INVALID_PAGE_ID, 3});
+  ASSERT_EQ(6, pages.size());
+  EXPECT_TRUE(HoldsPage(pages[0], 1));
+  EXPECT_TRUE(HoldsPage(pages[1], 5));
+  EXPECT_TRUE(HoldsPage(pages[2], 2));
+  EXPECT_EQ(pages[0], pages[3]);
+  EXPECT_EQ(nullptr, pages[4]);
+  EXPECT_TRUE(HoldsPage(pages[5], 3));
+  EXPECT_EQ(2, pages[0]->GetPinCount());
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.fetch_hits_);
+  EXPECT_EQ(3, stats.fetch_misses_);
+
+  // Scenario: every frame is pinned by the batch, so nothing else can be fetched.
+  EXPECT_EQ(nullptr, bpm->FetchPages({6})[0]);
+  EXPECT_EQ(nullptr, bpm->FetchPage(6));
+
+  // Scenario: a batch unpin releases every pin, and marks the pages dirty.
+  EXPECT_TRUE(bpm->UnpinPages({{1, false}, {5, false}, {2, true}, {1, false}, {3, false}}));
+  EXPECT_EQ(0, pages[0]->GetPinCount());
+  EXPECT_TRUE(pages[2]->IsDirty());
+  EXPECT_FALSE(bpm->UnpinPages({{1, false}, {3, false}}));
+  EXPECT_FALSE(bpm->UnpinPages({{6, false}}));
+
+  // Scenario: all pages of a batch can be hits.
+  pages = bpm->FetchPages({3, 2, 1});
+  EXPECT_TRUE(HoldsPage(pages[0], 3));
+  EXPECT_TRUE(HoldsPage(pages[1], 2));
+  EXPECT_TRUE(HoldsPage(pages[2], 1));
+  EXPECT_EQ(5, bpm->GetStats().fetch_misses_);  // the two failed fetches of page 6 were misses too
+  EXPECT_TRUE(bpm->UnpinPages({{1, false}, {2, false}, {3, false}}));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("batch_pin_test.fsm");
+  remove("batch_pin_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BatchPinTest, ParallelTest) {
+  const std::string db_name = "batch_pin_test.db";
+  const int num_pages = 12;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(3, 2, disk_manager);
+  CreatePages(bpm, num_pages);
+
+  // Every shard loads the pages it owns, and the pages come back in the requested order.
+  std::vector<page_id_t> page_ids{11, 0, 7, 3, 4, 8};
+  std::vector<Page *> pages = bpm->FetchPages(page_ids);
+  std::vector<std::pair<page_id_t, bool>> unpin_pages;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    EXPECT_TRUE(HoldsPage(pages[i], page_ids[i]));
+    unpin_pages.emplace_back(page_ids[i], false);
+  }
+  EXPECT_TRUE(bpm->UnpinPages(unpin_pages));
+  EXPECT_FALSE(bpm->UnpinPages(unpin_pages));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("batch_pin_test.fsm");
+  remove("batch_pin_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
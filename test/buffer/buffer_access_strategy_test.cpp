@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <set>
+#include <string>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// @return the ids of the pages that are resident in the buffer pool
+static std::set<page_id_t> ResidentPages(BufferPoolManager *bpm) {
+  std::set<page_id_t> resident;
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    if (bpm->GetPages()[i].GetPageId() != INVALID_PAGE_ID) {
+      resident.insert(bpm->GetPages()[i].GetPageId());
+    }
+  }
+  return resident;
+}
+
+TEST(BufferAccessStrategyTest, RingTest) {
+  const std::string db_name = "buffer_access_strategy_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_hot_pages = 4;
+  const int num_scan_pages = 40;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: a few hot pages are created and accessed normally.
+  page_id_t page_id;
+  for (int i = 0; i < num_hot_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a bulk write creates many more pages than the pool holds. It only ever uses its ring (a quarter of the
+  // pool), so the hot pages stay resident.
+  BufferAccessStrategy bulk_write(AccessType::BULK_WRITE);
+  for (int i = 0; i < num_scan_pages; i++) {
+    Page *page = bpm->NewPage(&page_id, bulk_write);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  auto resident = ResidentPages(bpm);
+  for (int i = 0; i < num_hot_pages; i++) {
+    EXPECT_EQ(1, resident.count(i));
+  }
+  EXPECT_GE(static_cast<size_t>(num_hot_pages + buffer_pool_size / 4), resident.size());
+
+  // Scenario: a sequential scan reads them all back through its own ring, the hot pages still stay resident.
+  BufferAccessStrategy scan(AccessType::SEQUENTIAL_SCAN);
+  for (int i = num_hot_pages; i < num_hot_pages + num_scan_pages; i++) {
+    Page *page = bpm->FetchPage(i, scan);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  resident = ResidentPages(bpm);
+  for (int i = 0; i < num_hot_pages; i++) {
+    EXPECT_EQ(1, resident.count(i));
+  }
+
+  // Scenario: a ring frame that somebody else still pins is not recycled; the scan falls back to the replacer.
+  Page *pinned = bpm->FetchPage(num_hot_pages + num_scan_pages - 1);
+  ASSERT_NE(nullptr, pinned);
+  for (int i = num_hot_pages; i < num_hot_pages + num_scan_pages; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i, scan));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(num_hot_pages + num_scan_pages - 1, pinned->GetPageId());
+  EXPECT_TRUE(bpm->UnpinPage(num_hot_pages + num_scan_pages - 1, false));
+
+  // Scenario: without a strategy the same scan pushes the hot pages out.
+  for (int i = num_hot_pages; i < num_hot_pages + num_scan_pages; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  resident = ResidentPages(bpm);
+  for (int i = 0; i < num_hot_pages; i++) {
+    EXPECT_EQ(0, resident.count(i));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("buffer_access_strategy_test.fsm");
+  remove("buffer_access_strategy_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -72,14 +72,16 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
     EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
     bpm->UnpinPage(page_id_temp, false);
   }
-  // Scenario: We should be able to fetch the data we wrote a while ago.
+  // Scenario: We should be able to fetch the data we wrote a while ago. The checksum trailer was written by the
+  // disk manager.
   page0 = bpm->FetchPage(0);
-  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, PAGE_DATA_SIZE));
   EXPECT_EQ(true, bpm->UnpinPage(0, true));
 
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.fsm");
 
   delete bpm;
   delete disk_manager;
@@ -136,6 +138,7 @@ TEST(BufferPoolManagerTest, SampleTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.fsm");
 
   delete bpm;
   delete disk_manager;
@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_resize_test.cpp
+//
+// Identification: test/buffer/buffer_pool_resize_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// @return true if the page holds "page <page_id>"
+static bool HoldsPage(const char *data, page_id_t page_id) {
+  return strcmp(data, ("page " + std::to_string(page_id)).c_str()) == 0;
+}
+
+TEST(BufferPoolResizeTest, GrowShrinkTest) {
+  const std::string db_name = "buffer_pool_resize_test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, disk_manager, nullptr, ReplacerPolicy::LRU, 8);
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  EXPECT_EQ(8, bpm->GetMaxPoolSize());
+
+  // Scenario: a full pool grows, and the new frames are used for new pages.
+  page_id_t page_ids[4];
+  Page *pinned = bpm->NewPage(&page_ids[0]);
+  ASSERT_NE(nullptr, pinned);
+  snprintf(pinned->GetData(), PAGE_SIZE, "page %d", page_ids[0]);
+  Page *page = bpm->NewPage(&page_ids[1]);
+  ASSERT_NE(nullptr, page);
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(2, bpm->GrowPool(2));
+  EXPECT_EQ(4, bpm->GetPoolSize());
+  for (int i = 1; i < 4; i++) {
+    if (i > 1) {
+      page = bpm->NewPage(&page_ids[i]);
+      ASSERT_NE(nullptr, page);
+    }
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_ids[i]);
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+
+  // Scenario: shrinking evicts the retired frames and writes their dirty pages back; the pinned page does not move.
+  EXPECT_EQ(3, bpm->ShrinkPool(3));
+  EXPECT_EQ(1, bpm->GetPoolSize());
+  char data[PAGE_SIZE];
+  for (int i = 1; i < 4; i++) {
+    disk_manager->ReadPage(page_ids[i], data);
+    EXPECT_TRUE(HoldsPage(data, page_ids[i]));
+  }
+  EXPECT_EQ(pinned, bpm->FetchPage(page_ids[0]));
+  EXPECT_TRUE(HoldsPage(pinned->GetData(), page_ids[0]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  // Scenario: a pinned frame can not be retired, and the pool can not grow beyond its maximum size.
+  EXPECT_EQ(0, bpm->ShrinkPool(1));
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[1]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], true));
+  EXPECT_EQ(7, bpm->GrowPool(100));
+  EXPECT_EQ(8, bpm->GetPoolSize());
+  for (page_id_t id : page_ids) {
+    page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(HoldsPage(page->GetData(), id));
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+
+  // Scenario: a pool without headroom can shrink and grow back to its original size.
+  auto *fixed_bpm = new BufferPoolManager(4, disk_manager);
+  EXPECT_EQ(0, fixed_bpm->GrowPool(1));
+  EXPECT_EQ(4, fixed_bpm->ShrinkPool(10));
+  EXPECT_EQ(nullptr, fixed_bpm->FetchPage(page_ids[0]));
+  EXPECT_EQ(4, fixed_bpm->GrowPool(10));
+  delete fixed_bpm;
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("buffer_pool_resize_test.fsm");
+  remove("buffer_pool_resize_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolResizeTest, ConcurrentTest) {
+  const std::string db_name = "buffer_pool_resize_test.db";
+  const int num_pages = 32;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(2, 8, disk_manager, nullptr, ReplacerPolicy::LRU, 16);
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the pool shrinks and grows while other threads keep fetching pages; every fetch sees the right data.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([bpm, &stop, t] {
+      std::mt19937 rng(t);
+      while (!stop) {
+        const auto page_id = static_cast<page_id_t>(rng() % num_pages);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {  // every frame of the shard is pinned
+          continue;
+        }
+        EXPECT_TRUE(HoldsPage(page->GetData(), page_id));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (int i = 0; i < 200; i++) {
+    bpm->ShrinkPool(12);
+    std::this_thread::yield();
+    bpm->GrowPool(16);
+  }
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(32, bpm->GetPoolSize());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("buffer_pool_resize_test.fsm");
+  remove("buffer_pool_resize_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,181 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats_test.cpp
+//
+// Identification: test/buffer/buffer_pool_stats_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <future>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/memory_disk_manager.h"
+
+namespace bustub {
+
+TEST(BufferPoolStatsTest, CounterTest) {
+  const std::string db_name = "buffer_pool_stats_test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  // With a single frame every new page or miss evicts the previous page.
+  auto *bpm = new BufferPoolManager(1, disk_manager, log_manager, ReplacerPolicy::LRU);
+
+  // Scenario: the first page gets the free frame, the second one evicts it.
+  page_id_t page_id0;
+  page_id_t page_id1;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id0));
+  EXPECT_TRUE(bpm->UnpinPage(page_id0, true));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id1));
+  EXPECT_TRUE(bpm->UnpinPage(page_id1, true));
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.free_list_victims_);
+  EXPECT_EQ(1, stats.replacer_victims_);
+  EXPECT_EQ(1, stats.eviction_writes_);
+  EXPECT_EQ(0, stats.HitRatio());
+
+  // Scenario: a miss and a hit.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id0));
+  EXPECT_TRUE(bpm->UnpinPage(page_id0, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id0));
+  EXPECT_TRUE(bpm->UnpinPage(page_id0, true));
+  EXPECT_TRUE(bpm->FlushPage(page_id0));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.fetch_hits_);
+  EXPECT_EQ(1, stats.fetch_misses_);
+  EXPECT_EQ(0.5, stats.HitRatio());
+  EXPECT_EQ(2, stats.replacer_victims_);
+  EXPECT_EQ(2, stats.eviction_writes_);
+  EXPECT_EQ(1, stats.flush_writes_);
+  EXPECT_EQ(0, stats.forced_log_flushes_);
+
+  // Scenario: evicting a page whose log records are not persistent forces a log flush.
+  enable_logging = true;
+  Page *page = bpm->FetchPage(page_id0);
+  ASSERT_NE(nullptr, page);
+  page->SetLSN(10);
+  EXPECT_TRUE(bpm->UnpinPage(page_id0, true));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id1));
+  enable_logging = false;
+  EXPECT_TRUE(bpm->UnpinPage(page_id1, true));
+  EXPECT_EQ(1, bpm->BackgroundWrite(1));
+
+  // Scenario: a snapshot with reset returns the counters and starts over from 0.
+  stats = bpm->GetStats(true);
+  EXPECT_EQ(2, stats.fetch_hits_);
+  EXPECT_EQ(2, stats.fetch_misses_);
+  EXPECT_EQ(1, stats.forced_log_flushes_);
+  EXPECT_EQ(3, stats.eviction_writes_);
+  EXPECT_EQ(1, stats.bgwriter_writes_);
+  EXPECT_EQ(0, stats.ring_victims_);
+  // Nobody else uses the buffer pool, so the latch never had to be waited for.
+  EXPECT_LT(0, stats.latch_wait_[0]);
+  for (size_t i = 1; i < BufferPoolStats::LATCH_WAIT_BUCKETS; i++) {
+    EXPECT_EQ(0, stats.latch_wait_[i]);
+  }
+  stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.fetch_hits_);
+  EXPECT_EQ(0, stats.eviction_writes_);
+  EXPECT_EQ(0, stats.latch_wait_[0]);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("buffer_pool_stats_test.fsm");
+  remove("buffer_pool_stats_test.log");
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+}
+
+// A disk whose asynchronous writes fail while fail_writes_ is set.
+class FailingDiskManager : public MemoryDiskManager {
+ public:
+  std::future<bool> WritePageAsync(page_id_t page_id, char *page_data) override {
+    return fail_writes_ ? Failed() : MemoryDiskManager::WritePageAsync(page_id, page_data);
+  }
+  std::future<bool> WritePagesAsync(page_id_t page_id, int num_pages, char *const *page_data) override {
+    return fail_writes_ ? Failed() : MemoryDiskManager::WritePagesAsync(page_id, num_pages, page_data);
+  }
+
+  bool fail_writes_ = false;
+
+ private:
+  static std::future<bool> Failed() {
+    std::promise<bool> result;
+    result.set_value(false);
+    return result.get_future();
+  }
+};
+
+TEST(BufferPoolStatsTest, WriteErrorTest) {
+  FailingDiskManager disk_manager;
+  BufferPoolManager bpm(4, &disk_manager, nullptr, ReplacerPolicy::LRU);
+  page_id_t page_ids[2];
+  for (page_id_t &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    EXPECT_TRUE(bpm.UnpinPage(page_id, true));
+  }
+
+  // Scenario: the pages that could not be written are reported and stay dirty.
+  disk_manager.fail_writes_ = true;
+  EXPECT_FALSE(bpm.FlushPage(page_ids[0]));
+  bpm.FlushAllPages();
+  EXPECT_EQ(0, bpm.BackgroundWrite(4));
+  BufferPoolStats stats = bpm.GetStats();
+  EXPECT_EQ(1 + 2 + 2, stats.write_errors_);
+  EXPECT_EQ(0, stats.flush_writes_);
+  EXPECT_EQ(0, stats.bgwriter_writes_);
+
+  // Scenario: once the disk works again they are written.
+  disk_manager.fail_writes_ = false;
+  EXPECT_EQ(2, bpm.BackgroundWrite(4));
+  bpm.FlushAllPages();
+  stats = bpm.GetStats();
+  EXPECT_EQ(2, stats.bgwriter_writes_);
+  EXPECT_EQ(0, stats.flush_writes_);
+}
+
+TEST(BufferPoolStatsTest, ParallelTest) {
+  const std::string db_name = "buffer_pool_stats_test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(2, 4, disk_manager);
+
+  // Every shard counts the fetches of the pages it owns.
+  std::vector<page_id_t> page_ids(6);
+  for (page_id_t &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  for (page_id_t page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  std::vector<BufferPoolStats> instance_stats = bpm->GetInstanceStats();
+  ASSERT_EQ(2, instance_stats.size());
+  EXPECT_EQ(3, instance_stats[0].fetch_hits_);
+  EXPECT_EQ(3, instance_stats[1].fetch_hits_);
+  BufferPoolStats stats = bpm->GetStats(true);
+  EXPECT_EQ(6, stats.fetch_hits_);
+  EXPECT_EQ(6, stats.free_list_victims_);
+  EXPECT_EQ(1, stats.HitRatio());
+  EXPECT_EQ(0, bpm->GetStats().fetch_hits_);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("buffer_pool_stats_test.fsm");
+  remove("buffer_pool_stats_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -14,12 +14,13 @@
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "buffer/buffer_pool_manager.h"
 #include "buffer/clock_replacer.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +60,78 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// Concurrent Pin/Unpin/Victim must never hand out the same frame twice and must keep Size() consistent.
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const int num_frames = 64;
+  const int num_threads = 4;
+  ClockReplacer clock_replacer(num_frames);
+  for (int i = 0; i < num_frames; i++) {
+    clock_replacer.Unpin(i);
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&clock_replacer, num_frames] {
+      for (int i = 0; i < 10000; i++) {
+        frame_id_t frame_id;
+        // every victim is "pinned" by this thread only, then given back
+        if (clock_replacer.Victim(&frame_id)) {
+          EXPECT_LE(0, frame_id);
+          EXPECT_GT(num_frames, frame_id);
+          clock_replacer.Pin(frame_id);
+          clock_replacer.Unpin(frame_id);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+
+  int value;
+  for (int i = 0; i < num_frames; i++) {
+    EXPECT_TRUE(clock_replacer.Victim(&value));
+  }
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, BufferPoolManagerTest) {
+  const std::string db_name = "clock_replacer_test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::CLOCK);
+
+  // Fill the pool, unpin everything, then keep creating pages: the clock has to evict the old ones.
+  page_id_t page_id;
+  for (int i = 0; i < 16; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (int i = 0; i < 16; i++) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Once every frame is pinned there is no victim.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_NE(nullptr, bpm->FetchPage(i));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("clock_replacer_test.fsm");
+  remove("clock_replacer_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -0,0 +1,217 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// direct_io_test.cpp
+//
+// Identification: test/buffer/direct_io_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// @return for every page of the file, whether (any part of) it is in the OS page cache
+static std::vector<bool> PageCacheResidency(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  struct stat stat_buf;
+  if (fd < 0 || fstat(fd, &stat_buf) != 0 || stat_buf.st_size == 0) {
+    close(fd);
+    return {};
+  }
+  // mmap 本身不会把页面读进来, mincore 只报告已经在 page cache 中的页面
+  void *addr = mmap(nullptr, stat_buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  const size_t os_page_size = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> resident((stat_buf.st_size + os_page_size - 1) / os_page_size);
+  std::vector<bool> pages((stat_buf.st_size + PAGE_SIZE - 1) / PAGE_SIZE);
+  if (addr != MAP_FAILED && mincore(addr, stat_buf.st_size, resident.data()) == 0) {
+    for (size_t i = 0; i < resident.size(); i++) {
+      if ((resident[i] & 1) != 0) {
+        pages[i * os_page_size / PAGE_SIZE] = true;
+      }
+    }
+  }
+  munmap(addr, stat_buf.st_size);
+  return pages;
+}
+
+// @return the number of pages of the file that are in the OS page cache
+static size_t PageCachePages(const std::string &file_name) {
+  std::vector<bool> pages = PageCacheResidency(file_name);
+  return std::count(pages.begin(), pages.end(), true);
+}
+
+// Drop the file from the OS page cache.
+static void EvictFromPageCache(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+TEST(DirectIOTest, ReadWriteTest) {
+  const std::string db_name = "direct_io_test.db";
+  remove(db_name.c_str());
+  remove("direct_io_test.fsm");
+  remove("direct_io_test.log");
+  DiskManager disk_manager(db_name, IOEngineType::IO_URING, true);
+  // the file system may not support O_DIRECT, the disk manager then works with buffered I/O
+  if (!disk_manager.IsDirectIO()) {
+    std::cout << "O_DIRECT is not supported here, testing the buffered fallback" << std::endl;
+  }
+
+  // Scenario: aligned buffers are transferred directly, unaligned buffers go through a bounce buffer.
+  auto *aligned = static_cast<char *>(std::aligned_alloc(PAGE_SIZE, 2 * PAGE_SIZE));
+  std::vector<char> unaligned(2 * PAGE_SIZE + 1);
+  char *odd = unaligned.data() + 1;
+  memset(aligned, 'a', PAGE_SIZE);
+  memset(odd, 'b', PAGE_SIZE);
+  disk_manager.WritePage(0, aligned);
+  disk_manager.WritePage(1, odd);
+  EXPECT_TRUE(disk_manager.WritePageAsync(2, odd).get());
+  char *run[2] = {odd, aligned};
+  disk_manager.WritePages(3, 2, run);
+
+  memset(odd, 0, PAGE_SIZE);
+  disk_manager.ReadPage(0, odd);
+  EXPECT_EQ('a', odd[0]);
+  EXPECT_EQ('a', odd[PAGE_DATA_SIZE - 1]);
+  disk_manager.ReadPage(1, aligned);
+  EXPECT_EQ('b', aligned[PAGE_DATA_SIZE - 1]);
+  EXPECT_TRUE(disk_manager.ReadPageAsync(2, odd + PAGE_SIZE).get());
+  EXPECT_EQ('b', odd[PAGE_SIZE + PAGE_DATA_SIZE - 1]);
+  char *pages[2] = {odd, aligned + PAGE_SIZE};
+  disk_manager.ReadPages(3, 2, pages);
+  EXPECT_EQ('b', odd[0]);
+  EXPECT_EQ('a', aligned[PAGE_SIZE + PAGE_DATA_SIZE - 1]);
+
+  // Scenario: past the end of file is zeroed through the bounce buffer as well.
+  char *past_end[2] = {odd, aligned};
+  EXPECT_TRUE(disk_manager.ReadPagesAsync(4, 2, past_end).get());
+  EXPECT_EQ('a', odd[0]);
+  EXPECT_EQ(0, aligned[0]);
+  EXPECT_EQ(0, aligned[PAGE_SIZE - 1]);
+
+  // Scenario: the pages never entered the OS page cache.
+  if (disk_manager.IsDirectIO()) {
+    EXPECT_EQ(0, PageCachePages(db_name));
+  }
+
+  std::free(aligned);
+  disk_manager.ShutDown();
+  remove(db_name.c_str());
+  remove("direct_io_test.fsm");
+  remove("direct_io_test.log");
+}
+
+TEST(DirectIOTest, BufferPoolTest) {
+  const std::string db_name = "direct_io_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 32;
+  remove(db_name.c_str());
+  remove("direct_io_test.fsm");
+  remove("direct_io_test.log");
+
+  auto *disk_manager = new DiskManager(db_name, IOEngineType::IO_URING, true);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: pages are evicted, flushed, written back in the background and read back into aligned frames.
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->BackgroundWrite(buffer_pool_size / 2);
+  bpm->FlushAllPages();
+  for (int i = 0; i < num_pages; i++) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  if (disk_manager->IsDirectIO()) {
+    EXPECT_EQ(0, PageCachePages(db_name));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("direct_io_test.fsm");
+  remove("direct_io_test.log");
+  delete disk_manager;
+}
+
+// Shows how many distinct pages are held in memory when the buffer pool reads a table that is larger than the pool.
+// With buffered I/O the OS page cache keeps a second copy of every page the buffer pool holds, so the memory of those
+// pages is spent twice; with O_DIRECT all of it can be given to the buffer pool instead.
+TEST(DirectIOTest, DISABLED_CacheCapacityBenchmark) {
+  const std::string db_name = "direct_io_test.db";
+  const size_t buffer_pool_size = 4096;
+  const int num_pages = 4 * buffer_pool_size;
+
+  for (bool direct_io : {false, true}) {
+    remove(db_name.c_str());
+    remove("direct_io_test.fsm");
+    remove("direct_io_test.log");
+    auto *disk_manager = new DiskManager(db_name, IOEngineType::IO_URING, direct_io);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    bpm->FlushAllPages();
+    EvictFromPageCache(db_name);
+
+    // a random read of the table, with a hot set that fits the buffer pool
+    auto start = std::chrono::steady_clock::now();
+    srand(0);
+    for (int i = 0; i < 4 * num_pages; i++) {
+      const page_id_t page_id = rand() % 4 == 0 ? rand() % num_pages : rand() % buffer_pool_size;
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const std::vector<bool> in_page_cache = PageCacheResidency(db_name);
+    const size_t page_cache = std::count(in_page_cache.begin(), in_page_cache.end(), true);
+    size_t cached_twice = 0;
+    for (page_id_t page_id : bpm->GetResidentPages()) {
+      cached_twice += static_cast<size_t>(page_id) < in_page_cache.size() && in_page_cache[page_id] ? 1 : 0;
+    }
+    std::cout << (disk_manager->IsDirectIO() ? "O_DIRECT" : "buffered") << ": " << buffer_pool_size
+              << " buffer pool pages, " << page_cache << " os page cache pages of the table, hit ratio "
+              << bpm->GetStats().HitRatio() << ", " << seconds << " s" << std::endl;
+    std::cout << "  memory holding table pages: " << buffer_pool_size + page_cache << " pages, " << cached_twice
+              << " of them cached twice, distinct pages: " << buffer_pool_size + page_cache - cached_twice << std::endl;
+
+    delete bpm;
+    disk_manager->ShutDown();
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+  remove("direct_io_test.fsm");
+  remove("direct_io_test.log");
+}
+
+}  // namespace bustub
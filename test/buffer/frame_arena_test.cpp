@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstring>
+
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(FrameArenaTest, LayoutTest) {
+  // Large enough to try huge pages, which may or may not be available.
+  const size_t num_frames = 2 * HUGE_PAGE_SIZE / PAGE_SIZE + 3;
+  FrameArena arena(num_frames);
+
+  // Page data is contiguous, page aligned and zeroed, and it is not inside the Page objects.
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetData()) % PAGE_SIZE);
+  for (size_t i = 0; i < num_frames; i++) {
+    Page *page = &arena.GetPages()[i];
+    EXPECT_EQ(arena.GetData() + i * PAGE_SIZE, page->GetData());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page) % CACHE_LINE_SIZE);
+    EXPECT_EQ(INVALID_PAGE_ID, page->GetPageId());
+    EXPECT_EQ(0, page->GetData()[0]);
+    EXPECT_EQ(0, page->GetData()[PAGE_SIZE - 1]);
+  }
+
+  // Writing a whole frame does not touch its neighbours.
+  memset(arena.GetPages()[1].GetData(), 'x', PAGE_SIZE);
+  EXPECT_EQ(0, arena.GetPages()[0].GetData()[PAGE_SIZE - 1]);
+  EXPECT_EQ(0, arena.GetPages()[2].GetData()[0]);
+
+  FrameArena empty(0);
+  EXPECT_EQ(nullptr, empty.GetData());
+}
+
+TEST(FrameArenaTest, StandalonePageTest) {
+  // A page that is not a buffer pool frame owns its data.
+  Page page;
+  ASSERT_NE(nullptr, page.GetData());
+  EXPECT_EQ(0, page.GetData()[PAGE_SIZE - 1]);
+  page.SetLSN(7);
+  EXPECT_EQ(7, page.GetLSN());
+}
+
+}  // namespace bustub
@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+
+  // Scenario: access six frames, frame 1 twice, and unpin them.
+  for (int i = 1; i <= 6; i++) {
+    lru_k_replacer.RecordAccess(i);
+  }
+  lru_k_replacer.RecordAccess(1);
+  for (int i = 1; i <= 6; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with fewer than K references go first, oldest reference first.
+  int value;
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.RecordAccess(3);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+
+  // Scenario: pinned frames are not evicted.
+  lru_k_replacer.Pin(6);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+
+  // Scenario: among frames with K references, the largest backward K-distance goes first.
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 2);
+
+  // Interleaved references to frames 0 and 1 are all within the correlated period: one reference each.
+  lru_k_replacer.RecordAccess(0);  // t = 1
+  lru_k_replacer.RecordAccess(1);  // t = 2
+  lru_k_replacer.RecordAccess(0);  // t = 3
+  lru_k_replacer.RecordAccess(1);  // t = 4
+  lru_k_replacer.RecordAccess(0);  // t = 5
+  lru_k_replacer.RecordAccess(2);  // t = 6
+  lru_k_replacer.RecordAccess(3);  // t = 7
+  for (int i = 0; i < 3; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+
+  // Frame 0 has the oldest reference but is still in its correlated period, so frame 1 goes first.
+  int value;
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  // Every remaining frame is in its correlated period: fall back to the regular order.
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(0, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+}
+
+// A sequential scan must only ever evict its own pages, never the pages referenced K times.
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 0);
+
+  for (int i = 0; i < 2; i++) {
+    lru_k_replacer.RecordAccess(0);
+    lru_k_replacer.RecordAccess(1);
+  }
+  lru_k_replacer.Unpin(0);
+  lru_k_replacer.Unpin(1);
+
+  lru_k_replacer.RecordAccess(2);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.RecordAccess(3);
+  lru_k_replacer.Unpin(3);
+
+  for (int i = 0; i < 100; i++) {
+    int value;
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    EXPECT_TRUE(value == 2 || value == 3);
+    lru_k_replacer.RecordAccess(value);
+    lru_k_replacer.Unpin(value);
+  }
+  EXPECT_EQ(4, lru_k_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, BufferPoolManagerTest) {
+  const std::string db_name = "lru_k_replacer_test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU_K);
+
+  page_id_t page_id;
+  for (int i = 0; i < 16; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (int i = 0; i < 16; i++) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Deleted pages are forgotten by the replacer, and pinned pages are never evicted.
+  EXPECT_TRUE(bpm->DeletePage(15));
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_NE(nullptr, bpm->FetchPage(i));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("lru_k_replacer_test.fsm");
+  remove("lru_k_replacer_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
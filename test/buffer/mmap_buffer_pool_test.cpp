@@ -0,0 +1,234 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_test.cpp
+//
+// Identification: test/buffer/mmap_buffer_pool_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/mmap_buffer_pool_manager.h"
+#include "common/exception.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// Write num_pages pages "page <id>" to a new database file.
+static void CreateDatabase(const std::string &db_name, int num_pages) {
+  remove(db_name.c_str());
+  remove("mmap_buffer_pool_test.fsm");
+  remove("mmap_buffer_pool_test.log");
+  DiskManager disk_manager(db_name);
+  auto *bpm = new BufferPoolManager(16, &disk_manager);
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager.ShutDown();
+}
+
+static void RemoveDatabase(const std::string &db_name) {
+  remove(db_name.c_str());
+  remove("mmap_buffer_pool_test.fsm");
+  remove("mmap_buffer_pool_test.log");
+}
+
+TEST(MmapBufferPoolTest, ReadOnlyTest) {
+  const std::string db_name = "mmap_buffer_pool_test.db";
+  CreateDatabase(db_name, 100);
+  auto *bpm = new MmapBufferPoolManager(db_name);
+  EXPECT_EQ(100, bpm->GetNumPages());
+
+  // Scenario: pages are served from the mapping, a page is the same object and the same memory on every fetch.
+  Page *page = bpm->FetchPage(42);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(42, page->GetPageId());
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 42"));
+  EXPECT_EQ(page, bpm->FetchPage(42));
+  EXPECT_EQ(2, page->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(42, false));
+  EXPECT_TRUE(bpm->UnpinPage(42, false));
+  EXPECT_FALSE(bpm->UnpinPage(42, false));
+  EXPECT_EQ(nullptr, bpm->FetchPage(100));
+  std::vector<Page *> pages = bpm->FetchPages({0, 99, 0});
+  ASSERT_EQ(3, pages.size());
+  EXPECT_EQ(pages[0], pages[2]);
+  EXPECT_EQ(0, strcmp(pages[1]->GetData(), "page 99"));
+  EXPECT_TRUE(bpm->UnpinPages({{0, false}, {99, false}, {0, false}}));
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(3, stats.fetch_misses_);
+  EXPECT_EQ(2, stats.fetch_hits_);
+
+  // Scenario: nothing can be written: new pages, deletes and dirty unpins are rejected; a dirty unpin still unpins.
+  page_id_t page_id = 0;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(INVALID_PAGE_ID, page_id);
+  EXPECT_FALSE(bpm->DeletePage(42));
+  ASSERT_NE(nullptr, bpm->FetchPage(42));
+  EXPECT_FALSE(bpm->UnpinPage(42, true));
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_FALSE(page->IsDirty());
+  EXPECT_FALSE(bpm->FlushPage(42));
+  bpm->FlushAllPages();
+
+  delete bpm;
+  RemoveDatabase(db_name);
+}
+
+TEST(MmapBufferPoolTest, CorruptedPageTest) {
+  const std::string db_name = "mmap_buffer_pool_test.db";
+  CreateDatabase(db_name, 4);
+  int fd = open(db_name.c_str(), O_WRONLY);
+  ASSERT_GE(fd, 0);
+  const char garbage[] = "garbage";
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(garbage)), pwrite(fd, garbage, sizeof(garbage), 2 * PAGE_SIZE + 10));
+  close(fd);
+  auto *bpm = new MmapBufferPoolManager(db_name);
+
+  // Scenario: a corrupted page is detected on every fetch, FetchPages does not leave the other pages pinned.
+  EXPECT_THROW(bpm->FetchPage(2), CorruptedPageException);
+  EXPECT_THROW(bpm->FetchPage(2), CorruptedPageException);
+  EXPECT_THROW(bpm->FetchPages({1, 2, 3}), CorruptedPageException);
+  Page *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  delete bpm;
+  RemoveDatabase(db_name);
+}
+
+TEST(MmapBufferPoolTest, TableScanTest) {
+  const std::string db_name = "mmap_buffer_pool_test.db";
+  remove(db_name.c_str());
+  remove("mmap_buffer_pool_test.fsm");
+  remove("mmap_buffer_pool_test.log");
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(16, disk_manager);
+  auto *txn = new Transaction(0);
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 200}});
+  const int num_tuples = 2000;
+  page_id_t first_page_id;
+  {
+    TableHeap table(bpm, nullptr, nullptr, txn);
+    RID rid;
+    for (int i = 0; i < num_tuples; i++) {
+      Tuple tuple(std::vector<Value>{ValueFactory::GetIntegerValue(i),
+                                     ValueFactory::GetVarcharValue(std::string(200, 'a' + i % 26))},
+                  &schema);
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, txn));
+    }
+    first_page_id = table.GetFirstPageId();
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: a table written by a regular buffer pool is scanned from the mapping, and no page is left pinned.
+  auto *mmap_bpm = new MmapBufferPoolManager(db_name);
+  mmap_bpm->SetPrefetchWindow(0);
+  TableHeap table(mmap_bpm, nullptr, nullptr, first_page_id);
+  int count = 0;
+  for (auto it = table.Begin(txn); it != table.End(); ++it) {
+    EXPECT_EQ(count, it->GetValue(&schema, 0).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(mmap_bpm->GetNumPages()); page_id++) {
+    Page *page = mmap_bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_TRUE(mmap_bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: read-ahead follows the page chain of the table on the prefetch threads.
+  mmap_bpm->Prefetch(first_page_id, 3,
+                     [](Page *page) { return reinterpret_cast<TablePage *>(page)->GetNextPageId(); });
+  for (int i = 0; i < 1000 && mmap_bpm->GetPrefetchStats().prefetched_ < 3; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(3, mmap_bpm->GetPrefetchStats().prefetched_);
+
+  delete mmap_bpm;
+  delete txn;
+  RemoveDatabase(db_name);
+}
+
+// @return the anonymous (not file backed) resident memory of the process, in KB
+static size_t AnonymousRssKB() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("RssAnon:", 0) == 0) {
+      return std::stoul(line.substr(8));
+    }
+  }
+  return 0;
+}
+
+// Shows the cold start of a read-only replica: the time to open the database and run a first query of random page
+// reads, and the memory that takes, with a buffer pool large enough for the whole file and with the mapping.
+TEST(MmapBufferPoolTest, DISABLED_ColdStartBenchmark) {
+  const std::string db_name = "mmap_buffer_pool_test.db";
+  const int num_pages = 32768;
+  const int num_fetches = 8192;
+  CreateDatabase(db_name, num_pages);
+
+  auto run = [&](auto &&open) {
+    const size_t rss_before = AnonymousRssKB();
+    auto start = std::chrono::steady_clock::now();
+    BufferPoolManager *bpm = open();
+    std::mt19937 rng(15445);
+    for (int i = 0; i < num_fetches; i++) {
+      const auto page_id = static_cast<page_id_t>(rng() % num_pages);
+      bpm->FetchPage(page_id);
+      bpm->UnpinPage(page_id, false);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const size_t rss = AnonymousRssKB() - std::min(rss_before, AnonymousRssKB());
+    delete bpm;
+    return std::make_pair(seconds, rss);
+  };
+
+  DiskManager *disk_manager = nullptr;
+  const auto frames = run([&] {
+    disk_manager = new DiskManager(db_name);
+    return new BufferPoolManager(num_pages, disk_manager);
+  });
+  disk_manager->ShutDown();
+  delete disk_manager;
+  const auto mapped = run([&] { return new MmapBufferPoolManager(db_name); });
+  std::cout << num_fetches << " random fetches after opening a " << num_pages * PAGE_SIZE / 1024 / 1024
+            << " MB database: buffer pool " << frames.first << " s, " << frames.second << " KB; mmap " << mapped.first
+            << " s, " << mapped.second << " KB" << std::endl;
+  RemoveDatabase(db_name);
+}
+
+}  // namespace bustub
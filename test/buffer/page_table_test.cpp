@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(4);
+  frame_id_t frame_id;
+
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+  page_table.Insert(0, 3);
+  page_table.Insert(7, 1);
+  page_table.Insert(12, 2);
+  EXPECT_EQ(3, page_table.Size());
+
+  EXPECT_TRUE(page_table.Find(0, &frame_id));
+  EXPECT_EQ(3, frame_id);
+  EXPECT_TRUE(page_table.Find(12, &frame_id));
+  EXPECT_EQ(2, frame_id);
+
+  // Insert overwrites an existing mapping.
+  page_table.Insert(7, 0);
+  EXPECT_EQ(3, page_table.Size());
+  EXPECT_TRUE(page_table.Find(7, &frame_id));
+  EXPECT_EQ(0, frame_id);
+
+  EXPECT_TRUE(page_table.Remove(7));
+  EXPECT_FALSE(page_table.Remove(7));
+  EXPECT_FALSE(page_table.Find(7, &frame_id));
+  EXPECT_EQ(2, page_table.Size());
+}
+
+// Random inserts/removes with strided page ids (like a shard of a ParallelBufferPoolManager) must agree with
+// std::unordered_map, i.e. backward shift deletion never loses an entry.
+TEST(PageTableTest, RandomTest) {
+  const size_t num_frames = 64;
+  PageTable page_table(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> expected;
+  std::mt19937 rng(15445);
+
+  for (int round = 0; round < 20000; round++) {
+    const auto page_id = static_cast<page_id_t>((rng() % 256) * 8 + 3);
+    if (expected.count(page_id) == 0 && expected.size() < num_frames) {
+      const auto frame_id = static_cast<frame_id_t>(rng() % num_frames);
+      page_table.Insert(page_id, frame_id);
+      expected[page_id] = frame_id;
+    } else {
+      EXPECT_EQ(expected.erase(page_id) == 1, page_table.Remove(page_id));
+    }
+  }
+
+  EXPECT_EQ(expected.size(), page_table.Size());
+  for (page_id_t page_id = 0; page_id < 256 * 8 + 8; page_id++) {
+    frame_id_t frame_id;
+    auto it = expected.find(page_id);
+    ASSERT_EQ(it != expected.end(), page_table.Find(page_id, &frame_id));
+    if (it != expected.end()) {
+      EXPECT_EQ(it->second, frame_id);
+    }
+  }
+}
+
+// Threads that keep hitting resident pages while other threads force evictions must always get the page they asked
+// for, pinned.
+TEST(PageTableTest, ConcurrentFetchTest) {
+  const std::string db_name = "page_table_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 32;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid, num_pages] {
+      std::mt19937 rng(tid);
+      char expected[16];
+      for (int i = 0; i < 5000; i++) {
+        // half of the fetches hit a small hot set, the rest cause evictions
+        const auto page_id = static_cast<page_id_t>(i % 2 == 0 ? rng() % 4 : rng() % num_pages);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_LT(0, page->GetPinCount());
+        snprintf(expected, sizeof(expected), "%d", page_id);
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("page_table_test.fsm");
+  remove("page_table_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
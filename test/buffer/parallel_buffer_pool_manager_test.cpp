@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(num_instances * buffer_pool_size, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: We should be able to create new pages until we fill up the buffer pool.
+  // Page allocation goes round-robin, so every shard owns the pages with page_id % num_instances == shard index.
+  for (size_t i = 1; i < num_instances * buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(static_cast<page_id_t>(i), page_id_temp);
+    EXPECT_EQ(bpm->GetBufferPoolManager(page_id_temp), bpm->GetBufferPoolManager(static_cast<page_id_t>(i)));
+  }
+
+  // Scenario: Once the buffer pool is full, we should not be able to create any new pages.
+  for (size_t i = 0; i < num_instances * buffer_pool_size; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning pages {0, 1, 2, 3, 4} and pinning another 4 new pages,
+  // there would still be one buffer page left for reading page 0.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: We should be able to fetch the data we wrote a while ago.
+  page0 = bpm->FetchPage(0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.fsm");
+  remove("parallel_buffer_pool_manager_test.log");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t num_threads = 4;
+  const size_t pages_per_thread = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_threads, 8, disk_manager);
+
+  // Every thread creates its own pages, writes its page id into them, and unpins them.
+  std::vector<std::vector<page_id_t>> page_ids(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (size_t i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id;
+        Page *page = bpm->NewPage(&page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+        page_ids[tid].push_back(page_id);
+        EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Every page must be readable back through whichever shard owns it, even after being evicted.
+  for (const auto &ids : page_ids) {
+    for (auto page_id : ids) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id, std::stoi(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.fsm");
+  remove("parallel_buffer_pool_manager_test.log");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FrameAccessTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, 2, disk_manager, nullptr, ReplacerPolicy::LRU, 4);
+  BufferPoolManager *base = bpm;
+
+  // Scenario: the sizes are those of the shards, also through the BufferPoolManager interface.
+  EXPECT_EQ(6, base->GetPoolSize());
+  EXPECT_EQ(12, base->GetMaxPoolSize());
+  EXPECT_EQ(nullptr, base->GetPages());
+  EXPECT_EQ(3, bpm->GrowPool(3));
+  EXPECT_EQ(9, base->GetPoolSize());
+
+  // Scenario: the frames of all shards hold every page that was created.
+  page_id_t page_id;
+  for (int i = 0; i < 9; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  std::set<page_id_t> resident;
+  for (size_t i = 0; i < base->GetPoolSize(); i++) {
+    Page *page = base->GetFrame(i);
+    ASSERT_NE(nullptr, page);
+    resident.insert(page->GetPageId());
+  }
+  EXPECT_EQ(9, resident.size());
+  EXPECT_EQ(0, *resident.begin());
+  EXPECT_EQ(8, *resident.rbegin());
+  for (int i = 0; i < 9; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  EXPECT_EQ(3, bpm->ShrinkPool(3));
+  EXPECT_EQ(6, base->GetPoolSize());
+  EXPECT_EQ(12, base->GetMaxPoolSize());
+
+  disk_manager->ShutDown();
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.fsm");
+  remove("parallel_buffer_pool_manager_test.log");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
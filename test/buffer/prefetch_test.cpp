@@ -0,0 +1,237 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetch_test.cpp
+//
+// Identification: test/buffer/prefetch_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/memory_disk_manager.h"
+
+namespace bustub {
+
+// The first 4 bytes of every test page hold the id of the next page of the chain.
+static page_id_t NextPageId(Page *page) {
+  page_id_t next_page_id;
+  memcpy(&next_page_id, page->GetData(), sizeof(page_id_t));
+  return next_page_id;
+}
+
+// Create num_pages pages chained in reverse order: num_pages - 1 -> num_pages - 2 -> ... -> 0.
+static void CreateChain(BufferPoolManager *bpm, int num_pages) {
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id);
+    const page_id_t next_page_id = page_id == 0 ? INVALID_PAGE_ID : page_id - 1;
+    memcpy(page->GetData(), &next_page_id, sizeof(page_id_t));
+    snprintf(page->GetData() + sizeof(page_id_t), PAGE_SIZE - sizeof(page_id_t), "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+}
+
+// Wait until the prefetcher has read at least count pages.
+static bool WaitForPrefetch(BufferPoolManager *bpm, uint64_t count) {
+  for (int i = 0; i < 1000; i++) {
+    if (bpm->GetPrefetchStats().prefetched_ >= count) {
+      // give the prefetch thread time to unpin the last page it read
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return false;
+}
+
+TEST(PrefetchTest, ChainTest) {
+  const std::string db_name = "prefetch_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  CreateChain(bpm, num_pages);
+
+  // Scenario: only pages 12..19 are still resident. Reading ahead 4 pages of the chain brings 7..4 in.
+  bpm->Prefetch(7, 4, NextPageId);
+  ASSERT_TRUE(WaitForPrefetch(bpm, 4));
+  for (int i = 7; i >= 4; i--) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData() + sizeof(page_id_t), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  PrefetchStats stats = bpm->GetPrefetchStats();
+  EXPECT_EQ(4, stats.prefetched_);
+  EXPECT_EQ(4, stats.hits_);
+  EXPECT_EQ(0, stats.wasted_);
+
+  // Scenario: prefetched pages that are evicted before anybody fetches them are counted as wasted.
+  bpm->Prefetch(std::vector<page_id_t>{0, 1});
+  ASSERT_TRUE(WaitForPrefetch(bpm, 6));
+  for (int i = 8; i < 18; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  stats = bpm->GetPrefetchStats();
+  EXPECT_EQ(6, stats.prefetched_);
+  EXPECT_EQ(4, stats.hits_);
+  EXPECT_EQ(2, stats.wasted_);
+
+  // Scenario: already resident pages are not read again.
+  bpm->Prefetch(17);
+  bpm->SetPrefetchWindow(0);
+  EXPECT_EQ(0, bpm->GetPrefetchWindow());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(6, bpm->GetPrefetchStats().prefetched_);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("prefetch_test.fsm");
+  remove("prefetch_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(PrefetchTest, DeleteTest) {
+  MemoryDiskManager disk_manager;
+  BufferPoolManager bpm(2, &disk_manager);
+  CreateChain(&bpm, 3);
+
+  // Scenario: a page deleted while the prefetcher reads it is not put back into the buffer pool.
+  disk_manager.SetLatency({std::chrono::milliseconds(200), {}, {}});
+  bpm.Prefetch(0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(bpm.DeletePage(0));
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  disk_manager.SetLatency({});
+  const std::vector<page_id_t> resident_pages = bpm.GetResidentPages();
+  EXPECT_EQ(resident_pages.end(), std::find(resident_pages.begin(), resident_pages.end(), 0));
+  EXPECT_EQ(0, bpm.GetPrefetchStats().prefetched_);
+
+  // Scenario: the deleted page id is reused by a new page, which is not overwritten by the cancelled read.
+  page_id_t page_id;
+  Page *page = bpm.NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, page_id);
+  EXPECT_EQ(0, page->GetData()[sizeof(page_id_t)]);
+  EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+}
+
+// Holds the next page read after it has read the page, until it is released; the caller then gets what was on disk
+// when the read started.
+class BlockingDiskManager : public MemoryDiskManager {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    MemoryDiskManager::ReadPage(page_id, page_data);
+    std::unique_lock<std::mutex> lock(latch_);
+    if (block_next_read_) {
+      block_next_read_ = false;
+      blocked_ = true;
+      cv_.notify_all();
+      cv_.wait(lock, [this] { return !blocked_; });
+    }
+  }
+
+  void BlockNextRead() {
+    std::lock_guard<std::mutex> lock(latch_);
+    block_next_read_ = true;
+  }
+
+  void WaitUntilBlocked() {
+    std::unique_lock<std::mutex> lock(latch_);
+    cv_.wait(lock, [this] { return blocked_; });
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(latch_);
+    blocked_ = false;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex latch_;
+  std::condition_variable cv_;
+  bool block_next_read_ = false;
+  bool blocked_ = false;
+};
+
+TEST(PrefetchTest, StaleReadTest) {
+  BlockingDiskManager disk_manager;
+  BufferPoolManager bpm(3, &disk_manager);
+  CreateChain(&bpm, 4);
+
+  // Scenario: while the prefetcher reads page 0, the page is fetched, changed, written back and evicted. The read
+  // it finishes afterwards is older than what is on disk, and must not be put into the buffer pool.
+  disk_manager.BlockNextRead();
+  bpm.Prefetch(0);
+  disk_manager.WaitUntilBlocked();
+  Page *page = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData() + sizeof(page_id_t), PAGE_SIZE - sizeof(page_id_t), "page 0 changed");
+  EXPECT_TRUE(bpm.UnpinPage(0, true));
+  page_id_t page_ids[2];
+  for (page_id_t &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  }
+  for (page_id_t page_id : page_ids) {
+    EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+  }
+  const std::vector<page_id_t> resident_pages = bpm.GetResidentPages();
+  EXPECT_EQ(resident_pages.end(), std::find(resident_pages.begin(), resident_pages.end(), 0));
+  disk_manager.Release();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(0, bpm.GetPrefetchStats().prefetched_);
+
+  page = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData() + sizeof(page_id_t), "page 0 changed"));
+  EXPECT_TRUE(bpm.UnpinPage(0, false));
+}
+
+TEST(PrefetchTest, ParallelTest) {
+  const std::string db_name = "prefetch_test.db";
+  const int num_pages = 24;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(3, 4, disk_manager);
+  CreateChain(bpm, num_pages);
+
+  // Only pages 12..23 are still resident. The chain 11..6 crosses all shards, every shard reads the pages it owns.
+  bpm->Prefetch(11, 6, NextPageId);
+  ASSERT_TRUE(WaitForPrefetch(bpm, 6));
+  for (int i = 11; i >= 6; i--) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData() + sizeof(page_id_t), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(6, bpm->GetPrefetchStats().hits_);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("prefetch_test.fsm");
+  remove("prefetch_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// warm_start_test.cpp
+//
+// Identification: test/buffer/warm_start_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Create num_pages pages holding "page <id>" and write them to disk.
+static void CreatePages(BufferPoolManager *bpm, int num_pages) {
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+}
+
+// @return the ids of the pages that are resident in the buffer pool
+static std::set<page_id_t> ResidentPages(BufferPoolManager *bpm) {
+  std::vector<page_id_t> page_ids = bpm->GetResidentPages();
+  return std::set<page_id_t>(page_ids.begin(), page_ids.end());
+}
+
+TEST(WarmStartTest, SaveLoadTest) {
+  const std::string db_name = "warm_start_test.db";
+  const std::string warm_start_file = "warm_start_test.warm";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU);
+  CreatePages(bpm, 10);
+
+  // Scenario: the resident pages are listed most recently used first, pinned pages count as most recent.
+  for (page_id_t page_id : {2, 3, 7, 8}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  EXPECT_EQ((std::vector<page_id_t>{3, 8, 7, 2}), bpm->GetResidentPages());
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+  EXPECT_TRUE(bpm->SaveResidentPages(warm_start_file));
+  delete bpm;
+
+  // Scenario: a restarted buffer pool is warmed up with the saved pages.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU);
+  EXPECT_EQ(buffer_pool_size, bpm->LoadResidentPages(warm_start_file));
+  EXPECT_EQ((std::set<page_id_t>{2, 3, 7, 8}), ResidentPages(bpm));
+  for (page_id_t page_id : {2, 3, 7, 8}) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  delete bpm;
+
+  // Scenario: a smaller buffer pool keeps the most recently used pages, in the saved eviction order.
+  bpm = new BufferPoolManager(2, disk_manager, nullptr, ReplacerPolicy::LRU);
+  EXPECT_EQ(2, bpm->LoadResidentPages(warm_start_file));
+  EXPECT_EQ((std::vector<page_id_t>{3, 8}), bpm->GetResidentPages());
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  EXPECT_EQ((std::set<page_id_t>{3, page_id}), ResidentPages(bpm));
+  delete bpm;
+
+  // Scenario: a missing file leaves the buffer pool cold.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU);
+  EXPECT_EQ(0, bpm->LoadResidentPages("missing.warm"));
+  EXPECT_TRUE(ResidentPages(bpm).empty());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("warm_start_test.fsm");
+  remove("warm_start_test.log");
+  remove(warm_start_file.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(WarmStartTest, ParallelTest) {
+  const std::string db_name = "warm_start_test.db";
+  const std::string warm_start_file = "warm_start_test.warm";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(3, 2, disk_manager);
+  CreatePages(bpm, 12);
+  const std::set<page_id_t> resident = ResidentPages(bpm);
+  EXPECT_EQ(6, resident.size());
+  EXPECT_TRUE(bpm->SaveResidentPages(warm_start_file));
+  delete bpm;
+
+  // Every shard reads back the pages it owns.
+  bpm = new ParallelBufferPoolManager(3, 2, disk_manager);
+  EXPECT_EQ(6, bpm->LoadResidentPages(warm_start_file));
+  EXPECT_EQ(resident, ResidentPages(bpm));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("warm_start_test.fsm");
+  remove("warm_start_test.log");
+  remove(warm_start_file.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// write_combining_test.cpp
+//
+// Identification: test/buffer/write_combining_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Fetch a page, write "<tag> <page_id>" into it and unpin it dirty.
+static void WritePage(BufferPoolManager *bpm, page_id_t page_id, const std::string &tag) {
+  Page *page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "%s %d", tag.c_str(), page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+}
+
+// @return true if the page on disk holds "<tag> <page_id>"
+static bool IsOnDisk(DiskManager *disk_manager, page_id_t page_id, const std::string &tag) {
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(page_id, data);
+  return strcmp(data, (tag + " " + std::to_string(page_id)).c_str()) == 0;
+}
+
+TEST(WriteCombiningTest, FlushAllPagesTest) {
+  const std::string db_name = "write_combining_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    WritePage(bpm, page_id, "old");
+  }
+
+  // Scenario: sequentially allocated pages are flushed with a single write.
+  int num_writes = disk_manager->GetNumWrites();
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_writes + 1, disk_manager->GetNumWrites());
+  for (page_id_t i = 0; i < num_pages; i++) {
+    EXPECT_TRUE(IsOnDisk(disk_manager, i, "old"));
+  }
+
+  // Scenario: clean pages are skipped, every run of adjacent dirty pages is one write.
+  for (page_id_t page_id : {8, 2, 7, 1, 3}) {
+    WritePage(bpm, page_id, "new");
+  }
+  num_writes = disk_manager->GetNumWrites();
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_writes + 2, disk_manager->GetNumWrites());
+  for (page_id_t i = 0; i < num_pages; i++) {
+    EXPECT_TRUE(IsOnDisk(disk_manager, i, (i >= 1 && i <= 3) || i == 7 || i == 8 ? "new" : "old"));
+  }
+  num_writes = disk_manager->GetNumWrites();
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_writes, disk_manager->GetNumWrites());
+
+  // Scenario: FlushPage only writes a dirty page.
+  EXPECT_TRUE(bpm->FlushPage(4));
+  EXPECT_EQ(num_writes, disk_manager->GetNumWrites());
+  WritePage(bpm, 4, "new");
+  EXPECT_TRUE(bpm->FlushPage(4));
+  EXPECT_EQ(num_writes + 1, disk_manager->GetNumWrites());
+  EXPECT_TRUE(IsOnDisk(disk_manager, 4, "new"));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("write_combining_test.fsm");
+  remove("write_combining_test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
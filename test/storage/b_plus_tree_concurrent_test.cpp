@@ -147,6 +147,7 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   delete transaction;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
 
@@ -201,6 +202,7 @@ TEST(BPlusTreeConcurrentTest, InsertTest2) {
   delete transaction;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
 
@@ -244,6 +246,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   delete disk_manager;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
 
@@ -288,6 +291,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   delete disk_manager;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
 
@@ -334,6 +338,7 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   delete disk_manager;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
 
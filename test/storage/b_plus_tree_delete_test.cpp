@@ -91,6 +91,7 @@ TEST(BPlusTreeTests, DeleteTest1) {
   delete disk_manager;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
 
@@ -172,6 +173,119 @@ TEST(BPlusTreeTests, DeleteTest2) {
   delete disk_manager;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
+TEST(BPlusTreeTests, DeleteReuseTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("b_plus_tree_reuse_test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t header_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&header_page_id));
+  // 4 keys per leaf: the tree has two levels and about twice as many pages as the buffer pool has frames.
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4);
+  Transaction *transaction = new Transaction(0);
+  GenericKey<8> index_key;
+  RID rid;
+  auto insert = [&](int64_t num_keys) {
+    for (int64_t key = 0; key < num_keys; key++) {
+      rid.Set(0, static_cast<uint32_t>(key));
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+  };
+  const int64_t num_keys = 300;
+  insert(num_keys);
+  FreeSpaceMap *free_space_map = disk_manager->GetFreeSpaceMap();
+  const page_id_t num_pages = free_space_map->GetNumPages();
+
+  // Scenario: removing every key deletes the merged nodes and the root, their pages are freed.
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+  page_id_t num_free_pages = 0;
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    num_free_pages += free_space_map->IsAllocated(page_id) ? 0 : 1;
+  }
+  EXPECT_LE(num_keys / 4, num_free_pages);
+
+  // Scenario: new keys reuse the freed pages instead of growing the file.
+  insert(num_keys / 2);
+  EXPECT_EQ(num_pages, free_space_map->GetNumPages());
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys / 2; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids, transaction)) << key;
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("b_plus_tree_reuse_test.db");
+  remove("b_plus_tree_reuse_test.fsm");
+  remove("b_plus_tree_reuse_test.log");
+}
+
+TEST(BPlusTreeTests, PartialDeleteReuseTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("b_plus_tree_partial_reuse_test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t header_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&header_page_id));
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4);
+  Transaction *transaction = new Transaction(0);
+  GenericKey<8> index_key;
+  RID rid;
+  auto insert = [&](int64_t begin, int64_t end) {
+    for (int64_t key = begin; key < end; key++) {
+      rid.Set(0, static_cast<uint32_t>(key));
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+  };
+  const int64_t num_keys = 600;
+  insert(0, num_keys);
+  FreeSpaceMap *free_space_map = disk_manager->GetFreeSpaceMap();
+  const page_id_t num_pages = free_space_map->GetNumPages();
+  const size_t num_free_pages = free_space_map->GetNumFreePages();
+
+  // Scenario: removing half of the keys frees the merged nodes, in extents the tree still uses.
+  for (int64_t key = 0; key < num_keys / 2; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  EXPECT_LE(num_free_pages + num_keys / 8, free_space_map->GetNumFreePages());
+
+  // Scenario: inserting the keys again reuses those pages instead of growing the file.
+  insert(0, num_keys / 2);
+  EXPECT_EQ(num_pages, free_space_map->GetNumPages());
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids, transaction)) << key;
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete transaction;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("b_plus_tree_partial_reuse_test.db");
+  remove("b_plus_tree_partial_reuse_test.fsm");
+  remove("b_plus_tree_partial_reuse_test.log");
+}
+
 }  // namespace bustub
@@ -71,6 +71,7 @@ TEST(BPlusTreeTests, InsertTest1) {
   delete disk_manager;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
 
@@ -142,6 +143,7 @@ TEST(BPlusTreeTests, InsertTest2) {
   delete disk_manager;
   delete bpm;
   remove("test.db");
+  remove("test.fsm");
   remove("test.log");
 }
 }  // namespace bustub
@@ -123,6 +123,7 @@ TEST(BptTreeTest, UnitTest) {
   delete transaction;
   delete disk_manager;
   remove("test.db");                // cpp函数,删除文件
+  remove("test.fsm");
   remove("test.log");
 }
 }  // namespace bustub
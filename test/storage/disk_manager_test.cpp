@@ -11,6 +11,8 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -22,7 +24,7 @@ namespace bustub {
 TEST(DiskManagerTest, ReadWritePageTest) {
   char buf[PAGE_SIZE] = {0};
   char data[PAGE_SIZE] = {0};
-  std::string db_file("test.db");
+  std::string db_file("disk_manager_test.db");
   auto dm = DiskManager(db_file);
   std::strncpy(data, "A test string.", sizeof(data));
 
@@ -39,12 +41,114 @@ TEST(DiskManagerTest, ReadWritePageTest) {
 
   dm.ShutDown();
   remove(db_file.c_str());
+  remove("disk_manager_test.fsm");
+  remove("disk_manager_test.log");
+}
+
+TEST(DiskManagerTest, WritePagesTest) {
+  char data[3][PAGE_SIZE] = {{0}};
+  char buf[3 * PAGE_SIZE] = {0};
+  std::string db_file("disk_manager_test.db");
+  auto dm = DiskManager(db_file);
+  for (int i = 0; i < 3; i++) {
+    std::memset(data[i], 'a' + i, PAGE_SIZE);
+  }
+
+  // pages 2..4 are written with a single vectored write, from buffers in reverse memory order
+  char *pages[3] = {data[2], data[1], data[0]};
+  const int num_writes = dm.GetNumWrites();
+  dm.WritePages(2, 3, pages);
+  EXPECT_EQ(num_writes + 1, dm.GetNumWrites());
+  dm.ReadPages(2, 3, buf);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(std::memcmp(buf + i * PAGE_SIZE, pages[i], PAGE_SIZE), 0);
+  }
+
+  // the pages written by WritePages can be overwritten and read back one at a time
+  dm.WritePage(3, data[0]);
+  dm.ReadPage(3, buf);
+  EXPECT_EQ(std::memcmp(buf, data[0], PAGE_SIZE), 0);
+  dm.ReadPage(4, buf);
+  EXPECT_EQ(std::memcmp(buf, data[0], PAGE_SIZE), 0);
+
+  dm.ShutDown();
+  remove(db_file.c_str());
+  remove("disk_manager_test.fsm");
+  remove("disk_manager_test.log");
+}
+
+TEST(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 32;
+  std::string db_file("disk_manager_test.db");
+  auto dm = DiskManager(db_file);
+
+  // every thread writes and reads back its own pages, there is no shared file position to race on
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&dm, t] {
+      char data[PAGE_SIZE];
+      char buf[PAGE_SIZE];
+      for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          const page_id_t page_id = i * num_threads + t;
+          std::memset(data, 'a' + (page_id + round) % 26, PAGE_SIZE);
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  dm.Sync();
+  EXPECT_EQ(num_threads * pages_per_thread * 4, dm.GetNumWrites());
+
+  dm.ShutDown();
+  remove(db_file.c_str());
+  remove("disk_manager_test.fsm");
+  remove("disk_manager_test.log");
+}
+
+TEST(DiskManagerTest, FileSizeTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  char log[16] = {0};
+  std::string db_file("disk_manager_test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+  remove("disk_manager_test.log");  // left behind by an earlier run
+  {
+    auto dm = DiskManager(db_file);
+    dm.WritePage(3, data);
+    EXPECT_FALSE(dm.ReadLog(log, sizeof(log), 0));
+    dm.WriteLog(data, sizeof(log));
+    EXPECT_TRUE(dm.ReadLog(log, sizeof(log), 0));
+    EXPECT_FALSE(dm.ReadLog(log, sizeof(log), sizeof(log)));
+    dm.ShutDown();
+  }
+
+  // a reopened disk manager picks up the sizes of the existing files
+  auto dm = DiskManager(db_file);
+  dm.ReadPage(3, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  std::memset(buf, 'x', sizeof(buf));
+  dm.ReadPage(1, buf);  // a hole before the end of file reads as zeros
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_TRUE(dm.ReadLog(log, sizeof(log), 0));
+  EXPECT_EQ(std::memcmp(log, data, sizeof(log)), 0);
+
+  dm.ShutDown();
+  remove(db_file.c_str());
+  remove("disk_manager_test.fsm");
+  remove("disk_manager_test.log");
 }
 
 TEST(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
   char data[16] = {0};
-  std::string db_file("test.db");
+  std::string db_file("disk_manager_test.db");
   auto dm = DiskManager(db_file);
   std::strncpy(data, "A test string.", sizeof(data));
 
@@ -56,6 +160,8 @@ TEST(DiskManagerTest, ReadWriteLogTest) {
 
   dm.ShutDown();
   remove(db_file.c_str());
+  remove("disk_manager_test.fsm");
+  remove("disk_manager_test.log");
 }
 
 TEST(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
@@ -0,0 +1,206 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_test.cpp
+//
+// Identification: test/storage/free_space_map_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/free_space_map.h"
+
+namespace bustub {
+
+TEST(FreeSpaceMapTest, AllocateFreeTest) {
+  FreeSpaceMap map;
+
+  // Scenario: pages are allocated in order, across several bitmap words.
+  for (page_id_t i = 0; i < 200; i++) {
+    EXPECT_EQ(i, map.Allocate());
+  }
+  EXPECT_EQ(200, map.GetNumPages());
+  EXPECT_EQ(0, map.GetNumFreePages());
+
+  // Scenario: freed pages are reused lowest first before the map grows. Freeing twice or out of range does nothing.
+  map.Free(150);
+  map.Free(3);
+  map.Free(70);
+  map.Free(70);
+  map.Free(500);
+  map.Free(INVALID_PAGE_ID);
+  EXPECT_EQ(3, map.GetNumFreePages());
+  EXPECT_FALSE(map.IsAllocated(70));
+  EXPECT_EQ(3, map.Allocate());
+  EXPECT_EQ(70, map.Allocate());
+  EXPECT_EQ(150, map.Allocate());
+  EXPECT_EQ(200, map.Allocate());
+  EXPECT_TRUE(map.IsAllocated(70));
+
+  // Scenario: striped allocation only hands out its own residue, skipped pages of other residues become free.
+  EXPECT_EQ(203, map.Allocate(4, 3));
+  EXPECT_EQ(2, map.GetNumFreePages());
+  EXPECT_EQ(201, map.Allocate(4, 1));
+  map.Free(5);
+  map.Free(6);
+  EXPECT_EQ(6, map.Allocate(4, 2));
+  EXPECT_EQ(5, map.Allocate(4, 1));
+  EXPECT_EQ(202, map.Allocate());
+  EXPECT_EQ(204, map.Allocate());
+
+  // Scenario: a serialized map is restored exactly, a corrupt one is rejected.
+  std::vector<char> data = map.Serialize();
+  FreeSpaceMap restored;
+  ASSERT_TRUE(restored.Deserialize(data));
+  EXPECT_EQ(map.GetNumPages(), restored.GetNumPages());
+  EXPECT_EQ(map.GetNumFreePages(), restored.GetNumFreePages());
+  data.pop_back();
+  EXPECT_FALSE(restored.Deserialize(data));
+  EXPECT_EQ(205, restored.Allocate());
+
+  // Scenario: marking a range allocated extends the map and keeps the free pages below the range free.
+  restored.Free(150);
+  restored.MarkRangeAllocated(206, 3);
+  EXPECT_EQ(209, restored.GetNumPages());
+  EXPECT_TRUE(restored.IsAllocated(208));
+  EXPECT_FALSE(restored.IsAllocated(150));
+  EXPECT_EQ(150, restored.Allocate());
+}
+
+TEST(FreeSpaceMapTest, RestartTest) {
+  const std::string db_name = "free_space_map_test.db";
+  const std::string fsm_name = "free_space_map_test.fsm";
+  remove(db_name.c_str());
+  remove(fsm_name.c_str());
+  remove("free_space_map_test.log");
+  char data[PAGE_SIZE] = {0};
+
+  auto *disk_manager = new DiskManager(db_name);
+  for (page_id_t i = 0; i < 10; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    disk_manager->WritePage(i, data);
+  }
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(7);
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: the deallocated pages survive a restart and are reused first.
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  EXPECT_EQ(7, disk_manager->AllocatePage());
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+  disk_manager->DeallocatePage(0);
+  disk_manager->Sync();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+  EXPECT_EQ(11, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  // Scenario: after a crash, neither a freed page that was reused before the last Sync nor the pages written past the
+  // saved map are handed out again.
+  disk_manager = new DiskManager(db_name);
+  disk_manager->DeallocatePage(5);
+  disk_manager->Sync();
+  struct stat map_stat;
+  ASSERT_EQ(0, stat(fsm_name.c_str(), &map_stat));
+  const ino_t map_inode = map_stat.st_ino;
+  EXPECT_EQ(5, disk_manager->AllocatePage());
+  // 重用页面时不写位图文件(保存会 rename 一个新文件过来), 到 Sync 时才保存
+  ASSERT_EQ(0, stat(fsm_name.c_str(), &map_stat));
+  EXPECT_EQ(map_inode, map_stat.st_ino);
+  disk_manager->WritePage(5, data);
+  disk_manager->Sync();
+  for (page_id_t i = 12; i < 15; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    disk_manager->WritePage(i, data);
+  }
+  std::ifstream saved_map(fsm_name, std::ios::binary);
+  const std::vector<char> map_data((std::istreambuf_iterator<char>(saved_map)), std::istreambuf_iterator<char>());
+  saved_map.close();
+  disk_manager->ShutDown();
+  delete disk_manager;
+  // 崩溃时磁盘上的位图是 ShutDown 之前的那个
+  std::ofstream(fsm_name, std::ios::binary | std::ios::trunc).write(map_data.data(), map_data.size());
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(15, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  // Scenario: without a map, the pages of an existing file are all treated as allocated.
+  remove(fsm_name.c_str());
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(15, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  // Scenario: a new database file starts with an empty map, even if an old map file is left over.
+  remove(db_name.c_str());
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  remove(db_name.c_str());
+  remove(fsm_name.c_str());
+  remove("free_space_map_test.log");
+}
+
+TEST(FreeSpaceMapTest, BufferPoolTest) {
+  const std::string db_name = "free_space_map_test.db";
+  remove(db_name.c_str());
+  remove("free_space_map_test.fsm");
+  remove("free_space_map_test.log");
+  auto *disk_manager = new DiskManager(db_name);
+
+  // Scenario: a deleted page is reclaimed by the next new page.
+  auto *bpm = new BufferPoolManager(4, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_TRUE(bpm->DeletePage(1));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(1, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  delete bpm;
+
+  // Scenario: every instance of a parallel buffer pool reclaims the deleted pages of its own stripe.
+  auto *parallel_bpm = new ParallelBufferPoolManager(2, 4, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, parallel_bpm->NewPage(&page_id));
+    EXPECT_TRUE(parallel_bpm->UnpinPage(page_id, false));
+    page_ids.push_back(page_id);
+  }
+  for (page_id_t deleted : page_ids) {
+    EXPECT_TRUE(parallel_bpm->DeletePage(deleted));
+  }
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, parallel_bpm->NewPage(&page_id));
+    EXPECT_TRUE(parallel_bpm->UnpinPage(page_id, false));
+    EXPECT_TRUE(std::find(page_ids.begin(), page_ids.end(), page_id) != page_ids.end());
+  }
+  delete parallel_bpm;
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("free_space_map_test.fsm");
+  remove("free_space_map_test.log");
+  delete disk_manager;
+}
+
+}  // namespace bustub
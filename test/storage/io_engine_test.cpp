@@ -0,0 +1,149 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_engine_test.cpp
+//
+// Identification: test/storage/io_engine_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/io_engine.h"
+
+namespace bustub {
+
+static const std::vector<IOEngineType> ENGINE_TYPES = {IOEngineType::THREAD_POOL, IOEngineType::IO_URING};
+
+TEST(IOEngineTest, ManyInFlightTest) {
+  const int num_pages = 256;
+  for (IOEngineType type : ENGINE_TYPES) {
+    const std::string file_name = "test_io_engine.db";
+    int fd = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    ASSERT_GE(fd, 0);
+    // io_uring may be unavailable (old kernel, seccomp), then it falls back to the thread pool
+    auto engine = IOEngine::Create(type, 32);
+    EXPECT_TRUE(engine->GetType() == type || engine->GetType() == IOEngineType::THREAD_POOL);
+
+    // Scenario: a batch of writes larger than the queue depth, page i holds i in every byte.
+    std::vector<char> data(num_pages * PAGE_SIZE);
+    std::atomic<int> completed{0};
+    std::atomic<int> failed{0};
+    std::vector<IORequest> requests;
+    for (int i = 0; i < num_pages; i++) {
+      memset(&data[i * PAGE_SIZE], i, PAGE_SIZE);
+      IORequest request;
+      request.fd_ = fd;
+      request.offset_ = static_cast<off_t>(i) * PAGE_SIZE;
+      request.write_ = true;
+      request.iov_.push_back({&data[i * PAGE_SIZE], PAGE_SIZE});
+      request.on_complete_ = [&](ssize_t n) {
+        failed += n != PAGE_SIZE ? 1 : 0;
+        completed++;
+      };
+      requests.emplace_back(std::move(request));
+    }
+    engine->Submit(std::move(requests));
+
+    // Scenario: vectored reads of 4 pages each, submitted one by one, read back in reverse order.
+    std::vector<char> buffer(num_pages * PAGE_SIZE);
+    std::vector<std::promise<ssize_t>> reads(num_pages / 4);
+    engine.reset();  // completes all writes
+    EXPECT_EQ(num_pages, completed);
+    EXPECT_EQ(0, failed);
+    engine = IOEngine::Create(type, 32);
+    for (int i = 0; i < num_pages / 4; i++) {
+      IORequest request;
+      request.fd_ = fd;
+      request.offset_ = static_cast<off_t>(i) * 4 * PAGE_SIZE;
+      request.write_ = false;
+      for (int j = 0; j < 4; j++) {
+        request.iov_.push_back({&buffer[(num_pages - 1 - (i * 4 + j)) * PAGE_SIZE], PAGE_SIZE});
+      }
+      request.on_complete_ = [&reads, i](ssize_t n) { reads[i].set_value(n); };
+      std::vector<IORequest> batch;
+      batch.emplace_back(std::move(request));
+      engine->Submit(std::move(batch));
+    }
+    for (auto &read : reads) {
+      EXPECT_EQ(4 * PAGE_SIZE, read.get_future().get());
+    }
+    for (int i = 0; i < num_pages; i++) {
+      EXPECT_EQ(static_cast<char>(i), buffer[(num_pages - 1 - i) * PAGE_SIZE]);
+      EXPECT_EQ(static_cast<char>(i), buffer[(num_pages - i) * PAGE_SIZE - 1]);
+    }
+
+    // Scenario: a read across the end of the file is short.
+    std::promise<ssize_t> short_read;
+    std::vector<IORequest> batch(1);
+    batch[0].fd_ = fd;
+    batch[0].offset_ = static_cast<off_t>(num_pages - 1) * PAGE_SIZE;
+    batch[0].write_ = false;
+    batch[0].iov_ = {{&buffer[0], PAGE_SIZE}, {&buffer[PAGE_SIZE], PAGE_SIZE}};
+    batch[0].on_complete_ = [&](ssize_t n) { short_read.set_value(n); };
+    engine->Submit(std::move(batch));
+    EXPECT_EQ(PAGE_SIZE, short_read.get_future().get());
+
+    engine.reset();
+    close(fd);
+    remove(file_name.c_str());
+  }
+}
+
+TEST(IOEngineTest, DiskManagerAsyncTest) {
+  for (IOEngineType type : ENGINE_TYPES) {
+    const std::string db_file = "io_engine_test.db";
+    DiskManager dm(db_file, type);
+    char data[4][PAGE_SIZE];
+    char buf[4][PAGE_SIZE];
+    for (int i = 0; i < 4; i++) {
+      memset(data[i], 'a' + i, PAGE_SIZE);
+      memset(buf[i], 'x', PAGE_SIZE);
+    }
+
+    // Scenario: single and vectored writes are in flight together.
+    const int num_writes = dm.GetNumWrites();
+    char *run[2] = {data[1], data[2]};
+    auto w1 = dm.WritePageAsync(0, data[0]);
+    auto w2 = dm.WritePagesAsync(1, 2, run);
+    auto w3 = dm.WritePageAsync(3, data[3]);
+    EXPECT_TRUE(w1.get());
+    EXPECT_TRUE(w2.get());
+    EXPECT_TRUE(w3.get());
+    EXPECT_EQ(num_writes + 3, dm.GetNumWrites());
+
+    // Scenario: the asynchronous and the synchronous reads see the same pages, past the end of file is zeroed.
+    char *pages[3] = {buf[2], buf[1], buf[0]};
+    auto r1 = dm.ReadPagesAsync(2, 3, pages);
+    auto r2 = dm.ReadPageAsync(1, buf[3]);
+    EXPECT_TRUE(r1.get());
+    EXPECT_TRUE(r2.get());
+    EXPECT_EQ(0, memcmp(buf[2], data[2], PAGE_SIZE));
+    EXPECT_EQ(0, memcmp(buf[1], data[3], PAGE_SIZE));
+    EXPECT_EQ(0, buf[0][0]);
+    EXPECT_EQ(0, buf[0][PAGE_SIZE - 1]);
+    EXPECT_EQ(0, memcmp(buf[3], data[1], PAGE_SIZE));
+    dm.ReadPage(3, buf[0]);
+    EXPECT_EQ(0, memcmp(buf[0], data[3], PAGE_SIZE));
+
+    EXPECT_TRUE(dm.GetIOEngineType() == type || dm.GetIOEngineType() == IOEngineType::THREAD_POOL);
+    dm.ShutDown();
+    remove(db_file.c_str());
+    remove("io_engine_test.fsm");
+    remove("io_engine_test.log");
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,210 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_search_test.cpp
+//
+// Identification: test/storage/key_search_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "b_plus_tree_test_util.h"  // NOLINT
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/key_search.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// @return a small random value of the type, so that the keys have many equal first columns
+static Value RandomValue(TypeId type, std::mt19937 *rng) {
+  const int64_t value = static_cast<int64_t>((*rng)() % 101) - 50;
+  switch (type) {
+    case TypeId::TINYINT:
+      return ValueFactory::GetTinyIntValue(static_cast<int8_t>(value));
+    case TypeId::SMALLINT:
+      return ValueFactory::GetSmallIntValue(static_cast<int16_t>(value * 300));
+    case TypeId::INTEGER:
+      return ValueFactory::GetIntegerValue(static_cast<int32_t>(value * 40000000));
+    case TypeId::BIGINT:
+      return ValueFactory::GetBigIntValue(value * 1000000007);
+    default:
+      return ValueFactory::GetDecimalValue(static_cast<double>(value) / 4);
+  }
+}
+
+static GenericKey<8> RandomKey(Schema *key_schema, std::mt19937 *rng) {
+  std::vector<Value> values;
+  for (const Column &col : key_schema->GetColumns()) {
+    values.push_back(RandomValue(col.GetType(), rng));
+  }
+  GenericKey<8> key;
+  key.SetFromKey(Tuple(values, key_schema));
+  return key;
+}
+
+// Compare the search of the keys of key_schema with the binary search on the comparator, over sorted pages of
+// several sizes, whole and in part.
+template <typename ValueType>
+static void CheckSearch(const std::string &sql) {
+  Schema *key_schema = ParseCreateStatement(sql);
+  GenericComparator<8> comparator(key_schema);
+  std::mt19937 rng(15445);
+  for (int num_items : {0, 1, 3, 4, 5, 8, 9, 17, 100, 254}) {
+    std::vector<std::pair<GenericKey<8>, ValueType>> items(num_items);
+    for (auto &item : items) {
+      item.first = RandomKey(key_schema, &rng);
+    }
+    std::sort(items.begin(), items.end(),
+              [&](const auto &a, const auto &b) { return comparator(a.first, b.first) < 0; });
+    for (int i = 0; i < 200; i++) {
+      const GenericKey<8> key =
+          num_items > 0 && i % 2 == 0 ? items[rng() % num_items].first : RandomKey(key_schema, &rng);
+      const int begin = static_cast<int>(rng() % (num_items / 2 + 1));
+      const int end = i % 4 < 2 ? num_items : begin + static_cast<int>(rng() % (num_items - begin + 1));
+      ASSERT_EQ(BinaryLowerBound(items.data(), begin, end, key, comparator),
+                KeyLowerBound(items.data(), begin, end, key, comparator))
+          << sql << ", " << num_items << " items";
+      ASSERT_EQ(BinaryUpperBound(items.data(), begin, end, key, comparator),
+                KeyUpperBound(items.data(), begin, end, key, comparator))
+          << sql << ", " << num_items << " items";
+    }
+  }
+  delete key_schema;
+}
+
+TEST(KeySearchTest, IntegerPrefixTest) {
+  // Scenario: the integer prefix is the first column if it is an integer.
+  const std::vector<std::pair<std::string, uint32_t>> prefix_sizes = {
+      {"a bigint", 8}, {"a integer", 4}, {"a smallint,b integer", 2}, {"a tinyint", 1}, {"a double", 0}};
+  for (const auto &[sql, prefix_size] : prefix_sizes) {
+    Schema *key_schema = ParseCreateStatement(sql);
+    GenericComparator<8> comparator(key_schema);
+    EXPECT_EQ(prefix_size, comparator.GetIntegerPrefixSize()) << sql;
+    EXPECT_EQ(prefix_size > 0 && key_schema->GetColumnCount() == 1, comparator.IsIntegerKey()) << sql;
+    delete key_schema;
+  }
+  Schema *key_schema = ParseCreateStatement("a integer,b integer");
+  GenericComparator<8> comparator(key_schema);
+  std::vector<Value> values{ValueFactory::GetIntegerValue(-7), ValueFactory::GetIntegerValue(3)};
+  GenericKey<8> key;
+  key.SetFromKey(Tuple(values, key_schema));
+  EXPECT_EQ(-7, comparator.IntegerPrefix(key));
+  delete key_schema;
+}
+
+TEST(KeySearchTest, LeafPageSearchTest) {
+  // Scenario: the keys of leaf pages are found like with the comparator, for every kind of integer prefix.
+  for (const std::string sql : {"a bigint", "a integer", "a smallint", "a tinyint", "a double"}) {
+    CheckSearch<RID>(sql);
+  }
+  // Scenario: keys with equal prefixes are ordered by their other columns.
+  CheckSearch<RID>("a integer,b integer");
+  CheckSearch<RID>("a smallint,b double");
+}
+
+TEST(KeySearchTest, InternalPageSearchTest) {
+  // Scenario: the pairs of internal pages are 12 bytes, the prefixes are not aligned.
+  CheckSearch<page_id_t>("a bigint");
+  CheckSearch<page_id_t>("a integer,b integer");
+}
+
+// Shows the cost of a search in a full leaf page of 8 byte integer keys: the linear scan on the comparator, the
+// binary search on the comparator and the integer prefix search; then point inserts and lookups in a B+ tree.
+TEST(KeySearchTest, DISABLED_SearchBenchmark) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  using Item = std::pair<GenericKey<8>, RID>;
+  const int num_items = static_cast<int>((PAGE_DATA_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(Item));
+  const int num_searches = 200000;
+  std::vector<Item> items(num_items);
+  for (int i = 0; i < num_items; i++) {
+    items[i].first.SetFromInteger(2 * i);
+  }
+  std::vector<GenericKey<8>> keys(num_searches);
+  std::mt19937 rng(15445);
+  for (auto &key : keys) {
+    key.SetFromInteger(rng() % (2 * num_items));
+  }
+
+  auto run = [&](auto &&search) {
+    int64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &key : keys) {
+      sum += search(key);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return std::make_pair(ns / num_searches, sum);
+  };
+  const auto linear = run([&](const GenericKey<8> &key) {
+    int i = 0;
+    while (i < num_items && comparator(key, items[i].first) > 0) {
+      i++;
+    }
+    return i;
+  });
+  const auto binary = run([&](const GenericKey<8> &key) {
+    return BinaryLowerBound(items.data(), 0, num_items, key, comparator);
+  });
+  const auto prefix =
+      run([&](const GenericKey<8> &key) { return KeyLowerBound(items.data(), 0, num_items, key, comparator); });
+  EXPECT_EQ(linear.second, binary.second);
+  EXPECT_EQ(linear.second, prefix.second);
+  std::cout << "search in a leaf of " << num_items << " keys: linear " << linear.first << " ns, binary "
+            << binary.first << " ns, integer prefix " << prefix.first << " ns" << std::endl;
+
+  // 内部结点(根)还不会分裂, 树只有两层
+  const int num_keys = 20000;
+  auto *disk_manager = new DiskManager("key_search_test.db");
+  auto *bpm = new BufferPoolManager(4096, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  auto *tree = new BPlusTree<GenericKey<8>, RID, GenericComparator<8>>("foo_pk", bpm, comparator);
+  auto *transaction = new Transaction(0);
+  std::vector<int64_t> tree_keys(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    tree_keys[i] = i;
+  }
+  std::shuffle(tree_keys.begin(), tree_keys.end(), rng);
+  GenericKey<8> index_key;
+  auto start = std::chrono::steady_clock::now();
+  for (int64_t key : tree_keys) {
+    index_key.SetFromInteger(key);
+    tree->Insert(index_key, RID(static_cast<page_id_t>(key >> 16), static_cast<uint32_t>(key & 0xFFFF)), transaction);
+  }
+  const double insert_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::vector<RID> result;
+  int num_found = 0;
+  start = std::chrono::steady_clock::now();
+  for (int64_t key : tree_keys) {
+    index_key.SetFromInteger(key);
+    num_found += tree->GetValue(index_key, &result, transaction) ? 1 : 0;
+  }
+  const double lookup_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(num_keys, num_found);
+  std::cout << num_keys << " keys in a B+ tree: inserts " << insert_seconds << " s, lookups " << lookup_seconds << " s"
+            << std::endl;
+
+  delete transaction;
+  delete tree;
+  delete bpm;
+  delete disk_manager;
+  delete key_schema;
+  remove("key_search_test.db");
+  remove("key_search_test.fsm");
+  remove("key_search_test.log");
+}
+
+}  // namespace bustub
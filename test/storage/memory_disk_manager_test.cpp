@@ -0,0 +1,183 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_disk_manager_test.cpp
+//
+// Identification: test/storage/memory_disk_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "common/exception.h"
+#include "gtest/gtest.h"
+#include "storage/disk/memory_disk_manager.h"
+
+namespace bustub {
+
+TEST(MemoryDiskManagerTest, ReadWriteTest) {
+  MemoryDiskManager disk_manager;
+  char data[3][PAGE_SIZE] = {"page a", "page b", "page c"};
+  char buf[3][PAGE_SIZE];
+
+  // Scenario: pages are read back as written, pages that were never written read as zeros.
+  disk_manager.WritePage(0, data[0]);
+  char *run[2] = {data[1], data[2]};
+  disk_manager.WritePages(1, 2, run);
+  disk_manager.ReadPages(0, 3, buf[0]);
+  EXPECT_EQ(0, memcmp(buf, data, sizeof(data)));
+  disk_manager.ReadPage(5, buf[0]);
+  EXPECT_EQ(0, buf[0][0]);
+  EXPECT_EQ(3, disk_manager.GetNumPages());
+
+  // Scenario: the arena grows past its first chunk, the pages written before stay in place.
+  disk_manager.WritePage(1000, data[2]);
+  EXPECT_TRUE(disk_manager.WritePageAsync(2000, data[1]).get());
+  char *pages[3] = {buf[0], buf[1], buf[2]};
+  EXPECT_TRUE(disk_manager.ReadPagesAsync(999, 3, pages).get());
+  EXPECT_EQ(0, buf[0][0]);
+  EXPECT_EQ(0, strcmp(buf[1], "page c"));
+  EXPECT_TRUE(disk_manager.ReadPageAsync(2000, buf[2]).get());
+  EXPECT_EQ(0, strcmp(buf[2], "page b"));
+  disk_manager.ReadPage(0, buf[0]);
+  EXPECT_EQ(0, strcmp(buf[0], "page a"));
+  EXPECT_EQ(2001, disk_manager.GetNumPages());
+  EXPECT_EQ(4, disk_manager.GetNumWrites());
+
+  // Scenario: the log is appended and read back, every write is a flush.
+  char log[16] = "log record";
+  disk_manager.WriteLog(log, 11);
+  disk_manager.WriteLog(log, 4);
+  char log_buf[32];
+  EXPECT_TRUE(disk_manager.ReadLog(log_buf, sizeof(log_buf), 0));
+  EXPECT_EQ(0, strcmp(log_buf, "log record"));
+  EXPECT_EQ(0, memcmp(log_buf + 11, "log ", 4));
+  EXPECT_EQ(0, log_buf[15]);
+  EXPECT_FALSE(disk_manager.ReadLog(log_buf, sizeof(log_buf), 15));
+  EXPECT_EQ(2, disk_manager.GetNumFlushes());
+
+  // Scenario: page allocation works like on disk.
+  EXPECT_EQ(0, disk_manager.AllocatePage());
+  disk_manager.DeallocatePage(0);
+  EXPECT_EQ(0, disk_manager.AllocatePage());
+}
+
+TEST(MemoryDiskManagerTest, LatencyTest) {
+  DiskLatency latency;
+  latency.request_ = std::chrono::microseconds(10);
+  latency.per_page_ = std::chrono::microseconds(1);
+  latency.seek_ = std::chrono::microseconds(100);
+  MemoryDiskManager disk_manager(latency);
+  char data[4][PAGE_SIZE] = {};
+  char *run[4] = {data[0], data[1], data[2], data[3]};
+
+  // Scenario: the modelled time only depends on the requests: sequential requests do not pay the seek.
+  auto start = std::chrono::steady_clock::now();
+  disk_manager.WritePages(0, 4, run);  // 10 + 4 * 1
+  disk_manager.ReadPage(0, data[0]);   // 10 + 1 + 100
+  disk_manager.ReadPage(1, data[0]);   // 10 + 1
+  disk_manager.ReadPage(5, data[0]);   // 10 + 1 + 100
+  EXPECT_EQ(std::chrono::microseconds(247), disk_manager.GetSimulatedIOTime());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::microseconds(247));
+
+  // Scenario: asynchronous requests overlap, the caller only waits for the slowest one.
+  disk_manager.SetLatency(DiskLatency{std::chrono::milliseconds(20), {}, {}});
+  start = std::chrono::steady_clock::now();
+  std::vector<std::future<bool>> reads;
+  for (int i = 0; i < 4; i++) {
+    reads.push_back(disk_manager.ReadPageAsync(i, data[i]));
+  }
+  for (auto &read : reads) {
+    EXPECT_TRUE(read.get());
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(80));
+  EXPECT_EQ(std::chrono::microseconds(80247), disk_manager.GetSimulatedIOTime());
+}
+
+TEST(MemoryDiskManagerTest, BufferPoolTest) {
+  auto disk_manager = std::make_unique<MemoryDiskManager>();
+  auto *bpm = new ParallelBufferPoolManager(2, 4, disk_manager.get());
+
+  // Scenario: a buffer pool runs on the in-memory pages, evicted pages are written and read back.
+  const int num_pages = 64;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (int i = 0; i < num_pages; i++) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  bpm->FlushAllPages();
+  EXPECT_LE(num_pages, disk_manager->GetNumPages());
+  delete bpm;
+}
+
+// Shows how much of a buffer pool workload is file system time: the same random fetch workload on the file backed
+// disk manager and on the in-memory one, and the modelled time of the same requests on an SSD.
+TEST(MemoryDiskManagerTest, DISABLED_BufferPoolBenchmark) {
+  const size_t buffer_pool_size = 256;
+  const int num_pages = 4096;
+  const int num_fetches = 200000;
+  const std::string db_name = "memory_disk_manager_test.db";
+
+  auto run = [&](DiskManager *disk_manager) {
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      bpm->NewPage(&page_id);
+      bpm->UnpinPage(page_id, true);
+    }
+    std::mt19937 rng(15445);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_fetches; i++) {
+      const page_id_t page_id = static_cast<page_id_t>(rng() % num_pages);
+      bpm->FetchPage(page_id);
+      bpm->UnpinPage(page_id, i % 4 == 0);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    delete bpm;
+    return seconds;
+  };
+
+  remove(db_name.c_str());
+  remove("memory_disk_manager_test.fsm");
+  remove("memory_disk_manager_test.log");
+  auto *file_disk_manager = new DiskManager(db_name);
+  const double file_seconds = run(file_disk_manager);
+  file_disk_manager->ShutDown();
+  delete file_disk_manager;
+  remove(db_name.c_str());
+  remove("memory_disk_manager_test.fsm");
+  remove("memory_disk_manager_test.log");
+
+  MemoryDiskManager memory_disk_manager;
+  const double memory_seconds = run(&memory_disk_manager);
+  memory_disk_manager.SetLatency(DiskLatency::SSD());
+  char page[PAGE_SIZE];
+  for (int i = 0; i < 1000; i++) {
+    memory_disk_manager.ReadPage(i * 7 % num_pages, page);
+  }
+  std::cout << num_fetches << " fetches: file " << file_seconds << " s, memory " << memory_seconds
+            << " s; 1000 random page reads on the SSD model: "
+            << std::chrono::duration<double>(memory_disk_manager.GetSimulatedIOTime()).count() << " s" << std::endl;
+}
+
+}  // namespace bustub
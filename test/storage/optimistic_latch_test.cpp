@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// optimistic_latch_test.cpp
+//
+// Identification: test/storage/optimistic_latch_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+TEST(OptimisticLatchTest, VersionTest) {
+  Page page;
+  uint64_t version;
+
+  // Scenario: a read that does not overlap a write validates.
+  ASSERT_TRUE(page.TryOptimisticLatch(&version));
+  EXPECT_TRUE(page.ValidateOptimisticLatch(version));
+
+  // Scenario: no optimistic read can start while a writer holds the latch.
+  page.WLatch();
+  uint64_t locked_version;
+  EXPECT_FALSE(page.TryOptimisticLatch(&locked_version));
+  page.WUnlatch();
+
+  // Scenario: a read that overlaps a write fails validation, even if the writer is done.
+  EXPECT_FALSE(page.ValidateOptimisticLatch(version));
+  ASSERT_TRUE(page.TryOptimisticLatch(&version));
+
+  // Scenario: readers that take the shared latch do not invalidate optimistic readers.
+  page.RLatch();
+  page.RUnlatch();
+  EXPECT_TRUE(page.ValidateOptimisticLatch(version));
+}
+
+TEST(OptimisticLatchTest, ConcurrentTest) {
+  Page page;
+  std::atomic<bool> stop{false};
+
+  // The writer fills the whole page with one byte, so a torn read sees two different bytes.
+  std::thread writer([&page, &stop] {
+    for (int i = 0; !stop.load(); i++) {
+      page.WLatch();
+      memset(page.GetData(), 'a' + i % 26, PAGE_SIZE);
+      page.WUnlatch();
+    }
+  });
+
+  std::vector<std::thread> readers;
+  std::atomic<int> validated{0};
+  for (int t = 0; t < 2; t++) {
+    readers.emplace_back([&page, &validated] {
+      char data[PAGE_SIZE];
+      for (int i = 0; i < 2000; i++) {
+        uint64_t version;
+        if (!page.TryOptimisticLatch(&version)) {
+          continue;
+        }
+        memcpy(data, page.GetData(), PAGE_SIZE);
+        if (page.ValidateOptimisticLatch(version)) {
+          validated++;
+          EXPECT_EQ(data[0], data[PAGE_SIZE - 1]);
+          EXPECT_EQ(data[0], data[PAGE_SIZE / 2]);
+        }
+      }
+    });
+  }
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  stop = true;
+  writer.join();
+
+  // Once the writer is gone every read validates.
+  uint64_t version;
+  ASSERT_TRUE(page.TryOptimisticLatch(&version));
+  EXPECT_TRUE(page.ValidateOptimisticLatch(version));
+}
+
+}  // namespace bustub
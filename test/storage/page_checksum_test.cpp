@@ -0,0 +1,220 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_checksum_test.cpp
+//
+// Identification: test/storage/page_checksum_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
+#include "common/util/crc32c.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+// Overwrite size bytes of the db file at offset, behind the disk manager's back.
+static void CorruptFile(const std::string &file_name, off_t offset, const char *data, size_t size) {
+  int fd = open(file_name.c_str(), O_WRONLY);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(static_cast<ssize_t>(size), pwrite(fd, data, size, offset));
+  close(fd);
+}
+
+TEST(PageChecksumTest, Crc32cTest) {
+  // Scenario: the check value of CRC-32C.
+  const std::string check = "123456789";
+  EXPECT_EQ(0xE3069283, Crc32cUtil::Crc32c(check.data(), check.size()));
+  EXPECT_EQ(0xE3069283, Crc32cUtil::Crc32cPortable(check.data(), check.size()));
+  EXPECT_EQ(0, Crc32cUtil::Crc32c(check.data(), 0));
+
+  // Scenario: the hardware and the portable implementation agree on any length and alignment, and a checksum can be
+  // computed in pieces.
+  std::mt19937 rng(15445);
+  std::vector<char> data(PAGE_SIZE + 16);
+  for (char &c : data) {
+    c = static_cast<char>(rng());
+  }
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t size : {1, 7, 8, 9, 63, 100, PAGE_DATA_SIZE}) {
+      const uint32_t crc = Crc32cUtil::Crc32c(data.data() + offset, size);
+      EXPECT_EQ(crc, Crc32cUtil::Crc32cPortable(data.data() + offset, size));
+      const uint32_t head = Crc32cUtil::Crc32c(data.data() + offset, size / 2);
+      EXPECT_EQ(crc, Crc32cUtil::Crc32c(data.data() + offset + size / 2, size - size / 2, head));
+    }
+  }
+}
+
+TEST(PageChecksumTest, DiskManagerTest) {
+  const std::string db_name = "page_checksum_test.db";
+  remove(db_name.c_str());
+  remove("page_checksum_test.fsm");
+  remove("page_checksum_test.log");
+  DiskManager disk_manager(db_name);
+  char data[4][PAGE_SIZE];
+  for (int i = 0; i < 4; i++) {
+    memset(data[i], 'a' + i, PAGE_SIZE);
+  }
+  disk_manager.WritePage(0, data[0]);
+  char *run[2] = {data[1], data[2]};
+  disk_manager.WritePages(1, 2, run);
+  EXPECT_TRUE(disk_manager.WritePageAsync(4, data[3]).get());
+
+  // Scenario: intact pages and a hole in the file (page 3, all zeros) pass verification.
+  char buf[4][PAGE_SIZE];
+  disk_manager.ReadPage(0, buf[0]);
+  EXPECT_EQ(0, memcmp(buf[0], data[0], PAGE_SIZE));
+  disk_manager.ReadPages(1, 3, buf[1]);
+  EXPECT_EQ(0, memcmp(buf[2], data[2], PAGE_SIZE));
+  EXPECT_EQ(0, buf[3][0]);
+  EXPECT_TRUE(disk_manager.ReadPageAsync(4, buf[3]).get());
+  EXPECT_EQ(0, disk_manager.GetNumChecksumFailures());
+
+  // Scenario: a flipped bit is detected by every read function. The page is still read into the buffer.
+  const char flipped = 'b' ^ 0x10;
+  CorruptFile(db_name, PAGE_SIZE + 100, &flipped, 1);
+  try {
+    disk_manager.ReadPage(1, buf[0]);
+    FAIL() << "the corrupted page was not detected";
+  } catch (const CorruptedPageException &e) {
+    EXPECT_EQ(1, e.GetPageId());
+    EXPECT_EQ(flipped, buf[0][100]);
+  }
+  EXPECT_THROW(disk_manager.ReadPages(0, 3, buf[0]), CorruptedPageException);
+  char *pages[3] = {buf[0], buf[1], buf[2]};
+  EXPECT_THROW(disk_manager.ReadPages(0, 3, pages), CorruptedPageException);
+  EXPECT_THROW(disk_manager.ReadPagesAsync(0, 3, pages).get(), CorruptedPageException);
+  EXPECT_EQ(4, disk_manager.GetNumChecksumFailures());
+
+  // Scenario: a torn write, only the first half of a new version of the page reached the disk.
+  memset(data[2], 'x', PAGE_SIZE);
+  CorruptFile(db_name, 2 * PAGE_SIZE, data[2], PAGE_SIZE / 2);
+  EXPECT_THROW(disk_manager.ReadPage(2, buf[0]), CorruptedPageException);
+
+  // Scenario: rewriting the page repairs it.
+  disk_manager.WritePage(2, data[2]);
+  disk_manager.ReadPage(2, buf[0]);
+  EXPECT_EQ(0, memcmp(buf[0], data[2], PAGE_SIZE));
+  EXPECT_EQ(5, disk_manager.GetNumChecksumFailures());
+
+  disk_manager.ShutDown();
+  remove(db_name.c_str());
+  remove("page_checksum_test.fsm");
+  remove("page_checksum_test.log");
+}
+
+TEST(PageChecksumTest, BufferPoolTest) {
+  const std::string db_name = "page_checksum_test.db";
+  remove(db_name.c_str());
+  remove("page_checksum_test.fsm");
+  remove("page_checksum_test.log");
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 4; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  const char garbage[] = "garbage";
+  CorruptFile(db_name, PAGE_SIZE + 10, garbage, sizeof(garbage));
+  for (int i = 2; i < 4; i++) {  // 页面 0 和 1 被置换出去
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: fetching the corrupted page throws and does not cache it or leak its frame.
+  EXPECT_THROW(bpm->FetchPage(1), CorruptedPageException);
+  EXPECT_THROW(bpm->FetchPage(1), CorruptedPageException);
+  EXPECT_THROW(bpm->FetchPages({0, 1, 2}), CorruptedPageException);
+  std::vector<page_id_t> pinned;
+  for (int i = 0; i < 2; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    pinned.push_back(page_id);
+  }
+  for (page_id_t pinned_page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(pinned_page_id, false));
+  }
+
+  // Scenario: the intact pages are read back, rewriting the corrupted page through the buffer pool repairs it.
+  Page *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 0"));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  char data[PAGE_SIZE] = "page 1";
+  disk_manager->WritePage(1, data);
+  page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 1"));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_EQ(3, disk_manager->GetNumChecksumFailures());
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("page_checksum_test.fsm");
+  remove("page_checksum_test.log");
+  delete disk_manager;
+}
+
+// Shows the cost of the page checksum: the time to checksum one page, next to copying it and to reading it from the
+// OS page cache, which every buffer pool miss pays anyway.
+TEST(PageChecksumTest, DISABLED_ChecksumBenchmark) {
+  const int rounds = 200000;
+  std::vector<char> page(PAGE_SIZE, 'x');
+  std::vector<char> copy(PAGE_SIZE);
+  auto time_per_page = [&](auto &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+      f();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+  };
+  uint32_t sink = 0;
+  const double hardware = time_per_page([&] { sink ^= Crc32cUtil::Crc32c(page.data(), PAGE_DATA_SIZE); });
+  const double portable = time_per_page([&] { sink ^= Crc32cUtil::Crc32cPortable(page.data(), PAGE_DATA_SIZE); });
+  const double memcpy_ns = time_per_page([&] {
+    memcpy(copy.data(), page.data(), PAGE_SIZE);
+    page[sink % PAGE_SIZE] = copy[0];
+  });
+
+  const std::string db_name = "page_checksum_test.db";
+  remove(db_name.c_str());
+  remove("page_checksum_test.fsm");
+  remove("page_checksum_test.log");
+  DiskManager disk_manager(db_name);
+  for (page_id_t page_id = 0; page_id < 256; page_id++) {
+    disk_manager.WritePage(page_id, page.data());
+  }
+  page_id_t page_id = 0;
+  const double read = time_per_page([&] { disk_manager.ReadPage(page_id++ % 256, copy.data()); });
+  disk_manager.ShutDown();
+  remove(db_name.c_str());
+  remove("page_checksum_test.fsm");
+  remove("page_checksum_test.log");
+
+  std::cout << "per page: crc32c " << hardware << " ns ("
+            << (Crc32cUtil::IsHardwareAccelerated() ? "hardware" : "portable") << "), portable crc32c " << portable
+            << " ns, memcpy " << memcpy_ns << " ns, verified ReadPage from the os page cache " << read << " ns"
+            << std::endl;
+  EXPECT_NE(0xFFFFFFFF, sink);
+}
+
+}  // namespace bustub
@@ -0,0 +1,203 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_extent_test.cpp
+//
+// Identification: test/storage/page_extent_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/disk/free_space_map.h"
+#include "storage/disk/page_extent.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// @return true if the pages are one run of consecutive page ids
+static bool IsContiguous(const std::set<page_id_t> &page_ids) {
+  return !page_ids.empty() && *page_ids.rbegin() - *page_ids.begin() + 1 == static_cast<page_id_t>(page_ids.size());
+}
+
+TEST(PageExtentTest, AllocateExtentTest) {
+  FreeSpaceMap map;
+
+  // Scenario: extents are aligned to their size, single pages and the skipped pages fill the gaps.
+  EXPECT_EQ(0, map.Allocate());
+  EXPECT_EQ(8, map.AllocateExtent(8));
+  EXPECT_EQ(16, map.GetNumPages());
+  EXPECT_EQ(1, map.Allocate());
+  EXPECT_EQ(16, map.AllocateExtent(8));
+
+  // Scenario: an extent that is completely free again is reused, a partially free one is not.
+  for (page_id_t page_id = 8; page_id < 16; page_id++) {
+    map.Free(page_id);
+  }
+  map.Free(17);
+  EXPECT_EQ(8, map.AllocateExtent(8));
+  EXPECT_EQ(24, map.AllocateExtent(8));
+  EXPECT_EQ(64, map.AllocateExtent(64));
+  EXPECT_EQ(2, map.Allocate());
+}
+
+TEST(PageExtentTest, ReuseTest) {
+  const std::string db_name = "page_extent_test.db";
+  remove(db_name.c_str());
+  remove("page_extent_test.fsm");
+  remove("page_extent_test.log");
+  auto *disk_manager = new DiskManager(db_name);
+  PageExtent extent(8);
+  for (page_id_t i = 0; i < 3; i++) {
+    EXPECT_EQ(i, extent.AllocatePage(disk_manager));
+  }
+
+  // Scenario: the unused pages of a reserved extent are not handed out to anybody else.
+  EXPECT_EQ(8, disk_manager->AllocatePage());
+
+  // Scenario: a page the object deleted is handed out again before the rest of the extent and before a new extent.
+  disk_manager->DeallocatePage(1);
+  extent.FreePage(1);
+  EXPECT_EQ(1, extent.AllocatePage(disk_manager));
+  for (page_id_t i = 3; i < 8; i++) {
+    EXPECT_EQ(i, extent.AllocatePage(disk_manager));
+  }
+  disk_manager->DeallocatePage(5);
+  extent.FreePage(5);
+  EXPECT_EQ(5, extent.AllocatePage(disk_manager));
+  EXPECT_EQ(16, extent.AllocatePage(disk_manager));
+
+  // Scenario: after a restart the pages the object never used are free again.
+  char data[PAGE_SIZE] = {0};
+  disk_manager->WritePage(16, data);
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(14, disk_manager->GetFreeSpaceMap()->GetNumFreePages());
+  EXPECT_EQ(9, disk_manager->AllocatePage());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("page_extent_test.fsm");
+  remove("page_extent_test.log");
+  delete disk_manager;
+}
+
+TEST(PageExtentTest, BufferPoolTest) {
+  const std::string db_name = "page_extent_test.db";
+  remove(db_name.c_str());
+  remove("page_extent_test.fsm");
+  remove("page_extent_test.log");
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(4, disk_manager);
+
+  // Scenario: two objects that create pages in turn each get consecutive page ids from their own extent.
+  PageExtent extent_a(8);
+  PageExtent extent_b(8);
+  std::set<page_id_t> pages_a;
+  std::set<page_id_t> pages_b;
+  page_id_t page_id;
+  for (int i = 0; i < 12; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id, extent_a));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    pages_a.insert(page_id);
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id, extent_b));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    pages_b.insert(page_id);
+  }
+  EXPECT_EQ((std::set<page_id_t>{0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19}), pages_a);
+  EXPECT_EQ((std::set<page_id_t>{8, 9, 10, 11, 12, 13, 14, 15, 24, 25, 26, 27}), pages_b);
+
+  // Scenario: a page id that could not get a frame goes back to the extent.
+  std::vector<page_id_t> pinned;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    pinned.push_back(page_id);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id, extent_a));
+  for (page_id_t pinned_page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(pinned_page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id, extent_a));
+  EXPECT_EQ(20, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  delete bpm;
+
+  // Scenario: in a parallel buffer pool every page of an extent is created by the shard that owns it.
+  auto *parallel_bpm = new ParallelBufferPoolManager(3, 4, disk_manager);
+  PageExtent extent_c(16);
+  for (int i = 0; i < 6; i++) {
+    Page *page = parallel_bpm->NewPage(&page_id, extent_c);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(48 + i, page_id);
+    EXPECT_EQ(page, parallel_bpm->FetchPage(page_id));
+    EXPECT_TRUE(parallel_bpm->UnpinPage(page_id, true));
+    EXPECT_TRUE(parallel_bpm->UnpinPage(page_id, true));
+  }
+  delete parallel_bpm;
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("page_extent_test.fsm");
+  remove("page_extent_test.log");
+  delete disk_manager;
+}
+
+TEST(PageExtentTest, TableHeapTest) {
+  const std::string db_name = "page_extent_test.db";
+  remove(db_name.c_str());
+  remove("page_extent_test.fsm");
+  remove("page_extent_test.log");
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(16, disk_manager);
+  auto *txn = new Transaction(0);
+  Schema schema({Column{"a", TypeId::VARCHAR, 1000}});
+  Tuple tuple(std::vector<Value>{ValueFactory::GetVarcharValue(std::string(1000, 'x'))}, &schema);
+
+  // Scenario: two tables that are filled in turn both occupy a contiguous run of pages, and a scan of one of them
+  // visits its pages in ascending order.
+  TableHeap table_a(bpm, nullptr, nullptr, txn);
+  TableHeap table_b(bpm, nullptr, nullptr, txn);
+  RID rid;
+  for (int i = 0; i < 60; i++) {
+    ASSERT_TRUE(table_a.InsertTuple(tuple, &rid, txn));
+    ASSERT_TRUE(table_b.InsertTuple(tuple, &rid, txn));
+  }
+  std::set<page_id_t> pages_a;
+  std::vector<page_id_t> scan_order;
+  for (auto it = table_a.Begin(txn); it != table_a.End(); ++it) {
+    if (scan_order.empty() || scan_order.back() != it->GetRid().GetPageId()) {
+      scan_order.push_back(it->GetRid().GetPageId());
+    }
+    pages_a.insert(it->GetRid().GetPageId());
+  }
+  std::set<page_id_t> pages_b;
+  for (auto it = table_b.Begin(txn); it != table_b.End(); ++it) {
+    pages_b.insert(it->GetRid().GetPageId());
+  }
+  EXPECT_LT(1, pages_a.size());
+  EXPECT_TRUE(IsContiguous(pages_a));
+  EXPECT_TRUE(IsContiguous(pages_b));
+  EXPECT_EQ(std::vector<page_id_t>(pages_a.begin(), pages_a.end()), scan_order);
+
+  delete txn;
+  delete bpm;
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("page_extent_test.fsm");
+  remove("page_extent_test.log");
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tablespace_test.cpp
+//
+// Identification: test/storage/tablespace_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sys/stat.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/catalog.h"
+#include "common/exception.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/memory_disk_manager.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// @return the size of a file, -1 if it does not exist
+static int64_t FileSize(const std::string &file_name) {
+  struct stat st;
+  return stat(file_name.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+static void RemoveFiles(const std::vector<std::string> &names) {
+  for (const auto &name : names) {
+    remove((name + ".db").c_str());
+    remove((name + ".fsm").c_str());
+    remove((name + ".log").c_str());
+  }
+}
+
+TEST(TablespaceTest, DiskManagerTest) {
+  RemoveFiles({"tablespace_test", "tablespace_test_hot", "tablespace_test_wal"});
+  auto *disk_manager =
+      new DiskManager("tablespace_test.db", IOEngineType::THREAD_POOL, false, "tablespace_test_wal.log");
+  EXPECT_EQ(1, disk_manager->GetNumTablespaces());
+  const tablespace_id_t hot = disk_manager->CreateTablespace("tablespace_test_hot.db");
+  EXPECT_EQ(1, hot);
+  EXPECT_EQ(2, disk_manager->GetNumTablespaces());
+
+  // Scenario: the page ids of a tablespace carry its id, the default tablespace's page ids are the page numbers.
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+  const page_id_t extent = disk_manager->AllocateExtent(8, hot);
+  EXPECT_EQ(DiskManager::MakePageId(hot, 0), extent);
+  EXPECT_EQ(hot, DiskManager::GetTablespaceId(extent + 7));
+  EXPECT_EQ(7, DiskManager::GetPageNo(extent + 7));
+  EXPECT_EQ(DEFAULT_TABLESPACE_ID, DiskManager::GetTablespaceId(0));
+
+  // Scenario: the pages of a tablespace are stored in its own file, at their page number.
+  char data[3][PAGE_SIZE] = {"default page", "hot page 0", "hot page 1"};
+  disk_manager->WritePage(0, data[0]);
+  char *run[2] = {data[1], data[2]};
+  disk_manager->WritePages(extent, 2, run);
+  EXPECT_TRUE(disk_manager->WritePageAsync(extent + 5, data[2]).get());
+  EXPECT_EQ(PAGE_SIZE, FileSize("tablespace_test.db"));
+  EXPECT_EQ(6 * PAGE_SIZE, FileSize("tablespace_test_hot.db"));
+  char buf[2][PAGE_SIZE];
+  disk_manager->ReadPage(extent + 1, buf[0]);
+  EXPECT_EQ(0, strcmp(buf[0], "hot page 1"));
+  disk_manager->ReadPages(extent, 2, buf[0]);
+  EXPECT_EQ(0, strcmp(buf[0], "hot page 0"));
+  EXPECT_TRUE(disk_manager->ReadPageAsync(extent + 5, buf[1]).get());
+  EXPECT_EQ(0, strcmp(buf[1], "hot page 1"));
+  disk_manager->ReadPage(0, buf[0]);
+  EXPECT_EQ(0, strcmp(buf[0], "default page"));
+
+  // Scenario: a page of a tablespace that does not exist is rejected.
+  EXPECT_THROW(disk_manager->ReadPage(DiskManager::MakePageId(2, 0), buf[0]), Exception);
+  EXPECT_THROW(disk_manager->AllocateExtent(8, 2), Exception);
+
+  // Scenario: the log goes to its own file.
+  char log[16] = "log record";
+  disk_manager->WriteLog(log, 11);
+  EXPECT_EQ(11, FileSize("tablespace_test_wal.log"));
+  EXPECT_EQ(-1, FileSize("tablespace_test.log"));
+
+  // Scenario: every tablespace has its own free space map, and it is reloaded when the tablespace is added again.
+  disk_manager->DeallocatePage(extent);
+  EXPECT_FALSE(disk_manager->GetFreeSpaceMap(hot)->IsAllocated(0));
+  EXPECT_TRUE(disk_manager->GetFreeSpaceMap()->IsAllocated(0));
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager("tablespace_test.db", IOEngineType::THREAD_POOL, false, "tablespace_test_wal.log");
+  EXPECT_EQ(hot, disk_manager->CreateTablespace("tablespace_test_hot.db"));
+  EXPECT_EQ(DiskManager::MakePageId(hot, 8), disk_manager->AllocateExtent(8, hot));
+  disk_manager->ReadPage(extent + 1, buf[0]);
+  EXPECT_EQ(0, strcmp(buf[0], "hot page 1"));
+  disk_manager->ShutDown();
+  delete disk_manager;
+  RemoveFiles({"tablespace_test", "tablespace_test_hot", "tablespace_test_wal"});
+}
+
+TEST(TablespaceTest, PageIdTest) {
+  // Scenario: the default tablespace has every non-negative page id.
+  EXPECT_EQ(DEFAULT_TABLESPACE_ID, DiskManager::GetTablespaceId(INT32_MAX));
+  EXPECT_EQ(INT32_MAX, DiskManager::GetPageNo(INT32_MAX));
+  EXPECT_EQ(1 << TABLESPACE_PAGE_BITS, DiskManager::MakePageId(DEFAULT_TABLESPACE_ID, 1 << TABLESPACE_PAGE_BITS));
+
+  // Scenario: the page ids of the other tablespaces are told apart from each other and from INVALID_PAGE_ID.
+  const page_id_t last_page_no = (1 << TABLESPACE_PAGE_BITS) - 1;
+  for (tablespace_id_t tablespace_id = 1; tablespace_id < MAX_TABLESPACES; tablespace_id++) {
+    for (page_id_t page_no : {0, last_page_no}) {
+      const page_id_t page_id = DiskManager::MakePageId(tablespace_id, page_no);
+      EXPECT_NE(INVALID_PAGE_ID, page_id);
+      EXPECT_EQ(tablespace_id, DiskManager::GetTablespaceId(page_id));
+      EXPECT_EQ(page_no, DiskManager::GetPageNo(page_id));
+    }
+  }
+  EXPECT_GE(DiskManager::GetTablespaceId(INVALID_PAGE_ID), MAX_TABLESPACES);
+
+  // Scenario: a run of consecutive pages ends with its tablespace.
+  EXPECT_TRUE(DiskManager::IsNextPage(DiskManager::MakePageId(1, 5), DiskManager::MakePageId(1, 6)));
+  EXPECT_FALSE(DiskManager::IsNextPage(DiskManager::MakePageId(1, last_page_no), DiskManager::MakePageId(2, 0)));
+  EXPECT_FALSE(DiskManager::IsNextPage(INT32_MAX, DiskManager::MakePageId(1, 0)));
+
+  // Scenario: the last page number of a tablespace can be allocated, but not more.
+  RemoveFiles({"tablespace_test", "tablespace_test_hot"});
+  auto *disk_manager = new DiskManager("tablespace_test.db");
+  const tablespace_id_t hot = disk_manager->CreateTablespace("tablespace_test_hot.db");
+  EXPECT_EQ(DiskManager::MakePageId(hot, 0), disk_manager->AllocateExtent(last_page_no + 1, hot));
+  EXPECT_THROW(disk_manager->AllocateExtent(1, hot), Exception);
+  disk_manager->ShutDown();
+  delete disk_manager;
+  RemoveFiles({"tablespace_test", "tablespace_test_hot"});
+}
+
+TEST(TablespaceTest, CatalogTest) {
+  RemoveFiles({"tablespace_test", "tablespace_test_table", "tablespace_test_index"});
+  auto *disk_manager = new DiskManager("tablespace_test.db");
+  const tablespace_id_t table_space = disk_manager->CreateTablespace("tablespace_test_table.db");
+  const tablespace_id_t index_space = disk_manager->CreateTablespace("tablespace_test_index.db");
+  auto *bpm = new BufferPoolManager(32, disk_manager);
+  page_id_t header_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&header_page_id));  // 索引的根页面记录在 header page 中
+  EXPECT_TRUE(bpm->UnpinPage(header_page_id, true));
+  auto *txn = new Transaction(0);
+  auto *catalog = new Catalog(bpm, nullptr, nullptr);
+
+  // Scenario: a table and its index are stored in different tablespaces, and work as usual.
+  Schema schema({Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 100}});
+  TableMetadata *table = catalog->CreateTable(txn, "t", schema, table_space);
+  const int num_tuples = 500;
+  std::set<tablespace_id_t> table_spaces;
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple(
+        std::vector<Value>{ValueFactory::GetBigIntValue(i), ValueFactory::GetVarcharValue(std::string(100, 'x'))},
+        &schema);
+    RID rid;
+    ASSERT_TRUE(table->table_->InsertTuple(tuple, &rid, txn));
+    table_spaces.insert(DiskManager::GetTablespaceId(rid.GetPageId()));
+  }
+  EXPECT_EQ(std::set<tablespace_id_t>{table_space}, table_spaces);
+  Schema key_schema({Column{"a", TypeId::BIGINT}});
+  IndexInfo *index = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(txn, "t_a", "t", schema,
+                                                                                      key_schema, {0}, 8, index_space);
+  for (int i = 0; i < num_tuples; i += 50) {
+    std::vector<RID> result;
+    index->index_->ScanKey(Tuple(std::vector<Value>{ValueFactory::GetBigIntValue(i)}, &key_schema), &result, txn);
+    ASSERT_EQ(1, result.size());
+    Tuple tuple;
+    ASSERT_TRUE(table->table_->GetTuple(result[0], &tuple, txn));
+    EXPECT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int64_t>());
+  }
+
+  // Scenario: the pages are allocated in their own tablespace, the database file only holds the header page.
+  bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->GetFreeSpaceMap()->GetNumPages());
+  EXPECT_EQ(PAGE_SIZE, FileSize("tablespace_test.db"));
+  EXPECT_LT(0, FileSize("tablespace_test_table.db"));
+  EXPECT_LT(0, disk_manager->GetFreeSpaceMap(table_space)->GetNumPages());
+  EXPECT_LT(0, disk_manager->GetFreeSpaceMap(index_space)->GetNumPages());
+
+  delete catalog;
+  delete txn;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  RemoveFiles({"tablespace_test", "tablespace_test_table", "tablespace_test_index"});
+}
+
+TEST(TablespaceTest, MemoryDiskManagerTest) {
+  MemoryDiskManager disk_manager;
+
+  // Scenario: the in-memory backend keeps the pages of every tablespace apart.
+  const tablespace_id_t tablespace_id = disk_manager.CreateTablespace("anything");
+  const page_id_t page_id = disk_manager.AllocateExtent(4, tablespace_id);
+  EXPECT_EQ(DiskManager::MakePageId(tablespace_id, 0), page_id);
+  char data[2][PAGE_SIZE] = {"default page", "tablespace page"};
+  disk_manager.WritePage(0, data[0]);
+  disk_manager.WritePage(page_id + 3, data[1]);
+  char buf[PAGE_SIZE];
+  disk_manager.ReadPage(page_id + 3, buf);
+  EXPECT_EQ(0, strcmp(buf, "tablespace page"));
+  disk_manager.ReadPage(3, buf);
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_EQ(1, disk_manager.GetNumPages());
+  EXPECT_EQ(4, disk_manager.GetNumPages(tablespace_id));
+}
+
+}  // namespace bustub